@@ -25,7 +25,7 @@ public class CustomPCG : ModuleRules
 		PublicDependencyModuleNames.AddRange(
 			new string[]
 			{
-				"Core","PCG" , "CesiumRuntime", "Engine", "InputCore", "Projects" , "ShpFileReader",   "SQLiteSupport",  "SQLiteCore"  /* "Landscape", // ?? ADD THIS LINE*/
+				"Core","PCG" , "CesiumRuntime", "Engine", "InputCore", "Projects" , "ShpFileReader",   "SQLiteSupport",  "SQLiteCore", "DeveloperSettings"  /* "Landscape", // ?? ADD THIS LINE*/
 
 				// ... add other public dependencies that you statically link with here ...
 			}
@@ -38,7 +38,7 @@ public class CustomPCG : ModuleRules
 				"CoreUObject",
 				"Engine",
 				"Slate",
-				"SlateCore", "CesiumRuntime"
+				"SlateCore", "CesiumRuntime", "GeometryCore"
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FeatureCustomData.h"
+#include "FeatureStringTable.h"
+#include "PCGPointContent.h"
+#include "PCGPolygonActor.h"
+#include "Misc/Crc.h"
+
+float FFeatureCustomData::HashString(const FString& Value)
+{
+    if (Value.IsEmpty()) return 0.0f;
+
+    // 24 bits keep every value exactly representable as a float
+    return (FCrc::StrCrc32(*Value) & 0xFFFFFF) / float(1 << 24);
+}
+
+TArray<float> FFeatureCustomData::HashStrings(const FFeatureStringTable& Strings)
+{
+    TArray<float> Values;
+    Values.SetNumUninitialized(Strings.Num());
+    for (int32 i = 0; i < Strings.Num(); ++i)
+    {
+        Values[i] = HashString(Strings.Get(i));
+    }
+    return Values;
+}
+
+void FFeatureCustomData::ForPoint(const FPointFeature& Feature, TConstArrayView<float> StringValues, TConstArrayView<FInstanceCustomDataSlot> Slots, TArrayView<float> Out)
+{
+    for (int32 Slot = 0; Slot < Slots.Num(); ++Slot)
+    {
+        float Value = 0.0f;
+        switch (Slots[Slot].Attribute)
+        {
+        case EFeatureCustomDataAttribute::Id:         Value = Feature.Id; break;
+        case EFeatureCustomDataAttribute::KindID:     Value = Feature.KindID; break;
+        case EFeatureCustomDataAttribute::DomainID:   Value = Feature.DomainID; break;
+        case EFeatureCustomDataAttribute::CountryID:  Value = Feature.CountryID; break;
+        case EFeatureCustomDataAttribute::CategoryID: Value = Feature.CategoryID; break;
+        case EFeatureCustomDataAttribute::SubCategID: Value = Feature.SubCategID; break;
+        case EFeatureCustomDataAttribute::SpecificID: Value = Feature.SpecificID; break;
+        case EFeatureCustomDataAttribute::Scale:      Value = Feature.Scale; break;
+        case EFeatureCustomDataAttribute::Rotation:   Value = Feature.Rotation; break;
+        case EFeatureCustomDataAttribute::Elev:       Value = Feature.Elev; break;
+        case EFeatureCustomDataAttribute::Height:     Value = Feature.Height; break;
+        case EFeatureCustomDataAttribute::Altitude:   Value = Feature.Altitude; break;
+        case EFeatureCustomDataAttribute::State:      Value = StringValues[Feature.State]; break;
+        case EFeatureCustomDataAttribute::Name:       Value = StringValues[Feature.Name]; break;
+        case EFeatureCustomDataAttribute::Code:       Value = StringValues[Feature.Code]; break;
+        case EFeatureCustomDataAttribute::EntityEnum: Value = StringValues[Feature.EntityEnum]; break;
+        default: break;
+        }
+        Out[Slot] = Value * Slots[Slot].Multiplier + Slots[Slot].Offset;
+    }
+}
+
+void FFeatureCustomData::ForPolygon(const FGrassPolygonData& Data, TConstArrayView<FInstanceCustomDataSlot> Slots, TArrayView<float> Out)
+{
+    for (int32 Slot = 0; Slot < Slots.Num(); ++Slot)
+    {
+        float Value = 0.0f;
+        switch (Slots[Slot].Attribute)
+        {
+        case EFeatureCustomDataAttribute::Id:         Value = Data.Id; break;
+        case EFeatureCustomDataAttribute::KindID:     Value = Data.KindID; break;
+        case EFeatureCustomDataAttribute::DomainID:   Value = Data.DomainID; break;
+        case EFeatureCustomDataAttribute::CountryID:  Value = Data.CountryID; break;
+        case EFeatureCustomDataAttribute::CategoryID: Value = Data.CategoryID; break;
+        case EFeatureCustomDataAttribute::SubCategID: Value = Data.SubCategID; break;
+        case EFeatureCustomDataAttribute::SpecificID: Value = Data.SpecificID; break;
+        case EFeatureCustomDataAttribute::Scale:      Value = Data.Scale; break;
+        case EFeatureCustomDataAttribute::Density:    Value = Data.Density; break;
+        case EFeatureCustomDataAttribute::Area:       Value = Data.Area; break;
+        case EFeatureCustomDataAttribute::State:      Value = HashString(Data.State); break;
+        case EFeatureCustomDataAttribute::Name:       Value = HashString(Data.Name); break;
+        case EFeatureCustomDataAttribute::EntityEnum: Value = HashString(Data.EntityEnum); break;
+        case EFeatureCustomDataAttribute::Type:       Value = HashString(Data.Type); break;
+        case EFeatureCustomDataAttribute::Foliage:    Value = HashString(Data.Foliage); break;
+        default: break;
+        }
+        Out[Slot] = Value * Slots[Slot].Multiplier + Slots[Slot].Offset;
+    }
+}
+
+FName FFeatureCustomData::SlotAttributeName(int32 Slot)
+{
+    return FName(*FString::Printf(TEXT("CustomData%d"), Slot));
+}
+
+FString FFeatureCustomData::Describe(TConstArrayView<FInstanceCustomDataSlot> Slots)
+{
+    FString Result;
+    for (const FInstanceCustomDataSlot& Slot : Slots)
+    {
+        Result += FString::Printf(TEXT("%s*%g+%g;"), *StaticEnum<EFeatureCustomDataAttribute>()->GetNameStringByValue(int64(Slot.Attribute)), Slot.Multiplier, Slot.Offset);
+    }
+    return Result;
+}
@@ -0,0 +1,33 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FeatureStringTable.h"
+
+FFeatureStringTable::FFeatureStringTable()
+{
+    Strings.Add(FString());
+    Lookup.Add(FString(), 0);
+}
+
+int32 FFeatureStringTable::Intern(const FString& Value)
+{
+    if (const int32* Found = Lookup.Find(Value))
+    {
+        return *Found;
+    }
+
+    const int32 Index = Strings.Add(Value);
+    Lookup.Add(Value, Index);
+    return Index;
+}
+
+SIZE_T FFeatureStringTable::GetAllocatedSize() const
+{
+    SIZE_T Size = Strings.GetAllocatedSize() + Lookup.GetAllocatedSize();
+    for (const FString& String : Strings)
+    {
+        // Once in Strings, once as the Lookup key
+        Size += 2 * String.GetAllocatedSize();
+    }
+    return Size;
+}
@@ -0,0 +1,177 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "GeoreferenceBatchTransform.h"
+#include "CesiumGeoreference.h"
+#include "Math/VectorRegister.h"
+
+namespace GeoreferenceBatchTransform
+{
+    // WGS84, the ellipsoid Cesium georeferences use by default
+    static constexpr double SemiMajor = 6378137.0;
+    static constexpr double SemiMinor = 6356752.314245179;
+    static constexpr double E2 = 1.0 - (SemiMinor * SemiMinor) / (SemiMajor * SemiMajor);
+    static constexpr double EP2 = (SemiMajor * SemiMajor) / (SemiMinor * SemiMinor) - 1.0;
+
+    // Each matrix element broadcast to all lanes
+    struct FMatrixLanes
+    {
+        VectorRegister4Double M[4][3];
+
+        explicit FMatrixLanes(const FMatrix& Matrix)
+        {
+            for (int32 Row = 0; Row < 4; ++Row)
+            {
+                for (int32 Col = 0; Col < 3; ++Col)
+                {
+                    M[Row][Col] = VectorSetFloat1(Matrix.M[Row][Col]);
+                }
+            }
+        }
+
+        // Row-vector convention, same as FMatrix::TransformPosition
+        FORCEINLINE void TransformPosition(const VectorRegister4Double& X, const VectorRegister4Double& Y, const VectorRegister4Double& Z,
+            VectorRegister4Double& OutX, VectorRegister4Double& OutY, VectorRegister4Double& OutZ) const
+        {
+            OutX = VectorMultiplyAdd(Z, M[2][0], VectorMultiplyAdd(Y, M[1][0], VectorMultiplyAdd(X, M[0][0], M[3][0])));
+            OutY = VectorMultiplyAdd(Z, M[2][1], VectorMultiplyAdd(Y, M[1][1], VectorMultiplyAdd(X, M[0][1], M[3][1])));
+            OutZ = VectorMultiplyAdd(Z, M[2][2], VectorMultiplyAdd(Y, M[1][2], VectorMultiplyAdd(X, M[0][2], M[3][2])));
+        }
+    };
+}
+
+FGeoreferenceBatchTransform::FGeoreferenceBatchTransform(const ACesiumGeoreference* Georef)
+{
+    if (!Georef) return;
+
+    UnrealToEcef = Georef->ComputeUnrealToEarthCenteredEarthFixedTransformation();
+    EcefToUnreal = Georef->ComputeEarthCenteredEarthFixedToUnrealTransformation();
+    bValid = true;
+}
+
+void FGeoreferenceBatchTransform::LongitudeLatitudeHeightToUnreal(TConstArrayView<FVector> LongitudeLatitudeHeights, TArrayView<FVector> OutUnrealPositions) const
+{
+    using namespace GeoreferenceBatchTransform;
+
+    check(LongitudeLatitudeHeights.Num() == OutUnrealPositions.Num());
+    TRACE_CPUPROFILER_EVENT_SCOPE(FGeoreferenceBatchTransform::LongitudeLatitudeHeightToUnreal);
+
+    const FMatrixLanes ToUnreal(EcefToUnreal);
+    const VectorRegister4Double One = VectorSetFloat1(1.0);
+    const VectorRegister4Double VSemiMajor = VectorSetFloat1(SemiMajor);
+    const VectorRegister4Double VE2 = VectorSetFloat1(E2);
+    const VectorRegister4Double VOneMinusE2 = VectorSetFloat1(1.0 - E2);
+
+    const int32 Num = LongitudeLatitudeHeights.Num();
+    for (int32 Base = 0; Base < Num; Base += 4)
+    {
+        const int32 Lanes = FMath::Min(4, Num - Base);
+
+        alignas(32) double SinLat[4], CosLat[4], SinLon[4], CosLon[4], Height[4];
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            // Tail lanes repeat the last position and are not stored
+            const FVector& LLH = LongitudeLatitudeHeights[Base + FMath::Min(Lane, Lanes - 1)];
+            const double Lat = FMath::DegreesToRadians(LLH.Y);
+            const double Lon = FMath::DegreesToRadians(LLH.X);
+            SinLat[Lane] = FMath::Sin(Lat);
+            CosLat[Lane] = FMath::Cos(Lat);
+            SinLon[Lane] = FMath::Sin(Lon);
+            CosLon[Lane] = FMath::Cos(Lon);
+            Height[Lane] = LLH.Z;
+        }
+
+        const VectorRegister4Double VSinLat = VectorLoad(SinLat);
+        const VectorRegister4Double VCosLat = VectorLoad(CosLat);
+        const VectorRegister4Double VHeight = VectorLoad(Height);
+
+        // Prime vertical radius N = a / sqrt(1 - e^2 sin^2(lat))
+        const VectorRegister4Double N = VectorDivide(VSemiMajor, VectorSqrt(VectorSubtract(One, VectorMultiply(VE2, VectorMultiply(VSinLat, VSinLat)))));
+        const VectorRegister4Double Radial = VectorMultiply(VectorAdd(N, VHeight), VCosLat);
+
+        const VectorRegister4Double EcefX = VectorMultiply(Radial, VectorLoad(CosLon));
+        const VectorRegister4Double EcefY = VectorMultiply(Radial, VectorLoad(SinLon));
+        const VectorRegister4Double EcefZ = VectorMultiply(VectorMultiplyAdd(N, VOneMinusE2, VHeight), VSinLat);
+
+        VectorRegister4Double UnrealX, UnrealY, UnrealZ;
+        ToUnreal.TransformPosition(EcefX, EcefY, EcefZ, UnrealX, UnrealY, UnrealZ);
+
+        alignas(32) double OutX[4], OutY[4], OutZ[4];
+        VectorStore(UnrealX, OutX);
+        VectorStore(UnrealY, OutY);
+        VectorStore(UnrealZ, OutZ);
+
+        for (int32 Lane = 0; Lane < Lanes; ++Lane)
+        {
+            OutUnrealPositions[Base + Lane] = FVector(OutX[Lane], OutY[Lane], OutZ[Lane]);
+        }
+    }
+}
+
+void FGeoreferenceBatchTransform::UnrealToLongitudeLatitudeHeight(TConstArrayView<FVector> UnrealPositions, TArrayView<FVector> OutLongitudeLatitudeHeights) const
+{
+    using namespace GeoreferenceBatchTransform;
+
+    check(UnrealPositions.Num() == OutLongitudeLatitudeHeights.Num());
+    TRACE_CPUPROFILER_EVENT_SCOPE(FGeoreferenceBatchTransform::UnrealToLongitudeLatitudeHeight);
+
+    const FMatrixLanes ToEcef(UnrealToEcef);
+    const VectorRegister4Double One = VectorSetFloat1(1.0);
+    const VectorRegister4Double VSemiMajor = VectorSetFloat1(SemiMajor);
+    const VectorRegister4Double VE2 = VectorSetFloat1(E2);
+
+    const int32 Num = UnrealPositions.Num();
+    for (int32 Base = 0; Base < Num; Base += 4)
+    {
+        const int32 Lanes = FMath::Min(4, Num - Base);
+
+        alignas(32) double InX[4], InY[4], InZ[4];
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            const FVector& Position = UnrealPositions[Base + FMath::Min(Lane, Lanes - 1)];
+            InX[Lane] = Position.X;
+            InY[Lane] = Position.Y;
+            InZ[Lane] = Position.Z;
+        }
+
+        VectorRegister4Double EcefX, EcefY, EcefZ;
+        ToEcef.TransformPosition(VectorLoad(InX), VectorLoad(InY), VectorLoad(InZ), EcefX, EcefY, EcefZ);
+
+        const VectorRegister4Double P = VectorSqrt(VectorMultiplyAdd(EcefX, EcefX, VectorMultiply(EcefY, EcefY)));
+
+        alignas(32) double X[4], Y[4], Z[4], Dist[4];
+        VectorStore(EcefX, X);
+        VectorStore(EcefY, Y);
+        VectorStore(EcefZ, Z);
+        VectorStore(P, Dist);
+
+        // Bowring's closed form: sub-millimetre on and near the surface, no iteration
+        alignas(32) double Lon[4], Lat[4], SinLat[4], CosLat[4];
+        for (int32 Lane = 0; Lane < 4; ++Lane)
+        {
+            const double Theta = FMath::Atan2(Z[Lane] * SemiMajor, Dist[Lane] * SemiMinor);
+            const double SinTheta = FMath::Sin(Theta);
+            const double CosTheta = FMath::Cos(Theta);
+
+            Lon[Lane] = FMath::Atan2(Y[Lane], X[Lane]);
+            Lat[Lane] = FMath::Atan2(Z[Lane] + EP2 * SemiMinor * SinTheta * SinTheta * SinTheta,
+                Dist[Lane] - E2 * SemiMajor * CosTheta * CosTheta * CosTheta);
+            SinLat[Lane] = FMath::Sin(Lat[Lane]);
+            CosLat[Lane] = FMath::Cos(Lat[Lane]);
+        }
+
+        // h = p cos(lat) + z sin(lat) - a sqrt(1 - e^2 sin^2(lat)), stable at the poles too
+        const VectorRegister4Double VSinLat = VectorLoad(SinLat);
+        const VectorRegister4Double Height = VectorSubtract(
+            VectorMultiplyAdd(P, VectorLoad(CosLat), VectorMultiply(EcefZ, VSinLat)),
+            VectorMultiply(VSemiMajor, VectorSqrt(VectorSubtract(One, VectorMultiply(VE2, VectorMultiply(VSinLat, VSinLat))))));
+
+        alignas(32) double OutHeight[4];
+        VectorStore(Height, OutHeight);
+
+        for (int32 Lane = 0; Lane < Lanes; ++Lane)
+        {
+            OutLongitudeLatitudeHeights[Base + Lane] = FVector(FMath::RadiansToDegrees(Lon[Lane]), FMath::RadiansToDegrees(Lat[Lane]), OutHeight[Lane]);
+        }
+    }
+}
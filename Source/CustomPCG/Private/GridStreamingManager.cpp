@@ -1,10 +1,13 @@
 #include "GridStreamingManager.h"
 #include "SQLiteDatabase.h"
 #include <SQLiteResultSet.h>
-#include <Components/HierarchicalInstancedStaticMeshComponent.h>
+#include <Components/InstancedStaticMeshComponent.h>
+#include "InstanceBuilderSubsystem.h"
 #include <Kismet/GameplayStatics.h>
 #include <Engine/StreamableManager.h>
 #include "Engine/AssetManager.h"
+#include "CustomPCGSettings.h"
+#include "PCGPointContent.h"
 
 
 
@@ -23,14 +26,54 @@ void AGridStreamingManager::Tick(float DeltaTime)
         if (UWorld* World = GetWorld())
         {
             PC = UGameplayStatics::GetPlayerController(this, 0);
-            UpdateStreaming(PC->PlayerCameraManager->GetCameraLocation());
+            if (PC && PC->PlayerCameraManager)
+            {
+                UpdateStreaming(PC->PlayerCameraManager->GetCameraLocation());
+            }
         }
         FramesSinceUpdate = 0;
     }
 }
 
+void AGridStreamingManager::RegisterPointTile(APCGPointContent* Content, FIntPoint Tile, const FBox2D& Bounds)
+{
+    FStreamedPointTile& Streamed = PointTiles.AddDefaulted_GetRef();
+    Streamed.Content = Content;
+    Streamed.Tile = Tile;
+    Streamed.Bounds = Bounds;
+}
+
+void AGridStreamingManager::UpdatePointTileStreaming(const FVector& ViewLocation)
+{
+    const float StreamingRadius = GetDefault<UCustomPCGSettings>()->PointTileStreamingRadius;
+    if (StreamingRadius <= 0.0f) return;
+
+    const FVector2D View(ViewLocation);
+    const double RadiusSquared = FMath::Square(double(StreamingRadius));
+
+    for (int32 i = PointTiles.Num() - 1; i >= 0; --i)
+    {
+        FStreamedPointTile& Streamed = PointTiles[i];
+        APCGPointContent* Content = Streamed.Content.Get();
+        if (!Content)
+        {
+            PointTiles.RemoveAtSwap(i);
+            continue;
+        }
+
+        const bool bInRange = Streamed.Bounds.ComputeSquaredDistanceToPoint(View) <= RadiusSquared;
+        if (bInRange != Streamed.bLoaded)
+        {
+            Streamed.bLoaded = bInRange;
+            Content->SetTileLoaded(Streamed.Tile, bInRange);
+        }
+    }
+}
+
 void AGridStreamingManager::UpdateStreaming(FVector PawnLocation)
 {
+    UpdatePointTileStreaming(PawnLocation);
+
     int32 MinX = FMath::FloorToInt((PawnLocation.X - Radius) / GridSize);
     int32 MaxX = FMath::FloorToInt((PawnLocation.X + Radius) / GridSize);
     int32 MinY = FMath::FloorToInt((PawnLocation.Y - Radius) / GridSize);
@@ -66,46 +109,54 @@ void AGridStreamingManager::LoadCell(FIntPoint Cell)
         "SELECT PolygonID, X, Y, Z, MeshID FROM PolygonPoints WHERE GridX=%d AND GridY=%d;"),
         Cell.X, Cell.Y);
 
+    TArray<FString> MeshPaths;
+    TArray<FTransform> Transforms;
+
     // Execute the statement with a callback for each row
-    DB.Execute(*SQL, [this](const FSQLitePreparedStatement& Statement) -> ESQLitePreparedStatementExecuteRowResult
+    DB.Execute(*SQL, [&](const FSQLitePreparedStatement& Statement) -> ESQLitePreparedStatementExecuteRowResult
         {
-            int32 PolygonID = 0;
             float X = 0, Y = 0, Z = 0;
             FString MeshPath;
 
             // Use GetColumnValueByName to extract values from current row
-            Statement.GetColumnValueByName(TEXT("PolygonID"), PolygonID);
             Statement.GetColumnValueByName(TEXT("X"), X);
             Statement.GetColumnValueByName(TEXT("Y"), Y);
             Statement.GetColumnValueByName(TEXT("Z"), Z);
             Statement.GetColumnValueByName(TEXT("MeshID"), MeshPath);
 
-            FVector Loc(X, Y, Z);
-
-            UStaticMesh* Mesh = Cast<UStaticMesh>(FSoftObjectPath(MeshPath).TryLoad());
-            if (!Mesh) return ESQLitePreparedStatementExecuteRowResult::Continue;
-
-            // Spawn or reuse HISM component
-            UHierarchicalInstancedStaticMeshComponent* HISMC = nullptr;
-            for (auto* Comp : ParentActor->GetComponents())
-            {
-                if (auto* H = Cast<UHierarchicalInstancedStaticMeshComponent>(Comp))
-                    if (H->GetStaticMesh() == Mesh) { HISMC = H; break; }
-            }
-            if (!HISMC)
-            {
-                HISMC = NewObject<UHierarchicalInstancedStaticMeshComponent>(ParentActor);
-                HISMC->SetupAttachment(ParentActor->GetRootComponent());
-                HISMC->SetStaticMesh(Mesh);
-                HISMC->RegisterComponent();
-            }
-
-            HISMC->AddInstanceWorldSpace(FTransform(Loc));
+            MeshPaths.Add(MeshPath);
+            Transforms.Add(FTransform(FVector(X, Y, Z)));
 
             return ESQLitePreparedStatementExecuteRowResult::Continue;
         });
 
     DB.Close();
+
+    AddCellInstances(Cell, MeshPaths, Transforms);
+}
+
+void AGridStreamingManager::AddCellInstances(FIntPoint Cell, const TArray<FString>& MeshPaths, const TArray<FTransform>& Transforms)
+{
+    UInstanceBuilderSubsystem* InstanceBuilder = GetWorld() ? GetWorld()->GetSubsystem<UInstanceBuilderSubsystem>() : nullptr;
+    if (!InstanceBuilder) return;
+    if (!ParentActor) ParentActor = this;
+
+    // Each distinct path is resolved once
+    TMap<FString, UStaticMesh*> MeshPerPath;
+    TArray<UStaticMesh*> Meshes;
+    Meshes.Reserve(MeshPaths.Num());
+    for (const FString& MeshPath : MeshPaths)
+    {
+        UStaticMesh** Found = MeshPerPath.Find(MeshPath);
+        if (!Found)
+        {
+            Found = &MeshPerPath.Add(MeshPath, Cast<UStaticMesh>(FSoftObjectPath(MeshPath).TryLoad()));
+        }
+        Meshes.Add(*Found);
+    }
+
+    // One component per mesh and cell, so UnloadCell can release the cell's instances in one go
+    InstanceBuilder->AddInstancesByMesh(ParentActor, Meshes, Transforms, Cell, true);
 }
 
 void AGridStreamingManager::LoadDataFromDatabase(const FString& ShapefileID)
@@ -130,9 +181,9 @@ void AGridStreamingManager::LoadDataFromDatabase(const FString& ShapefileID)
     TSet<FIntPoint> CellsToLoad = NewCells.Difference(LoadedCells);
     TSet<FIntPoint> CellsToUnload = LoadedCells.Difference(NewCells);
 
-    // Unload HISM for cells outside radius
+    // Release the instances of cells outside radius
     for (const FIntPoint& Cell : CellsToUnload)
-        UnloadCell(Cell); // implement removal of HISM instances per cell
+        UnloadCell(Cell);
 
     // Load new cells
     FString DBPath = FPaths::ProjectSavedDir() / TEXT("PolygonData.db");
@@ -145,42 +196,26 @@ void AGridStreamingManager::LoadDataFromDatabase(const FString& ShapefileID)
             "WHERE ShapefileID='%s' AND GridX=%d AND GridY=%d;"),
             *ShapefileID, Cell.X, Cell.Y);
 
-        DB.Execute(*SQL, [this](const FSQLitePreparedStatement& Statement) -> ESQLitePreparedStatementExecuteRowResult
+        TArray<FString> MeshPaths;
+        TArray<FTransform> Transforms;
+
+        DB.Execute(*SQL, [&](const FSQLitePreparedStatement& Statement) -> ESQLitePreparedStatementExecuteRowResult
             {
-                int32 PolygonID;
                 float X, Y, Z;
                 FString MeshPath;
 
-                Statement.GetColumnValueByName(TEXT("PolygonID"), PolygonID);
                 Statement.GetColumnValueByName(TEXT("X"), X);
                 Statement.GetColumnValueByName(TEXT("Y"), Y);
                 Statement.GetColumnValueByName(TEXT("Z"), Z);
                 Statement.GetColumnValueByName(TEXT("MeshID"), MeshPath);
 
-                FVector Loc(X, Y, Z);
-
-                UStaticMesh* Mesh = Cast<UStaticMesh>(FSoftObjectPath(MeshPath).TryLoad());
-                if (!Mesh) return ESQLitePreparedStatementExecuteRowResult::Continue;
-
-                // Find existing HISM or create new
-                UHierarchicalInstancedStaticMeshComponent* HISMC = nullptr;
-                for (auto* Comp : ParentActor->GetComponents())
-                {
-                    if (auto* H = Cast<UHierarchicalInstancedStaticMeshComponent>(Comp))
-                        if (H->GetStaticMesh() == Mesh) { HISMC = H; break; }
-                }
-                if (!HISMC)
-                {
-                    HISMC = NewObject<UHierarchicalInstancedStaticMeshComponent>(ParentActor);
-                    HISMC->SetupAttachment(ParentActor->GetRootComponent());
-                    HISMC->SetStaticMesh(Mesh);
-                    HISMC->RegisterComponent();
-                }
-
-                HISMC->AddInstanceWorldSpace(FTransform(Loc));
+                MeshPaths.Add(MeshPath);
+                Transforms.Add(FTransform(FVector(X, Y, Z)));
 
                 return ESQLitePreparedStatementExecuteRowResult::Continue;
             });
+
+        AddCellInstances(Cell, MeshPaths, Transforms);
     }
 
     DB.Close();
@@ -191,8 +226,10 @@ void AGridStreamingManager::LoadDataFromDatabase(const FString& ShapefileID)
 
 void AGridStreamingManager::UnloadCell(FIntPoint Cell)
 {
-
-
+    if (UInstanceBuilderSubsystem* InstanceBuilder = GetWorld() ? GetWorld()->GetSubsystem<UInstanceBuilderSubsystem>() : nullptr)
+    {
+        InstanceBuilder->ReleaseGroup(ParentActor, Cell);
+    }
 }
 
 void AGridStreamingManager::LoadCellAsync(FIntPoint Cell)
@@ -236,7 +273,7 @@ void AGridStreamingManager::LoadCellAsync(FIntPoint Cell)
         })
         .Next([this, Cell](TTuple<TArray<FTransform>, TArray<FString>> Result)
             {
-                // Ensure main thread for HISM
+                // Ensure main thread for the instanced components
                 AsyncTask(ENamedThreads::GameThread, [this, Cell, Result]()
                     {
                         const TArray<FTransform>& Transforms = Result.Get<0>();
@@ -256,57 +293,10 @@ void AGridStreamingManager::LoadCellAsync(FIntPoint Cell)
                         FStreamableManager& Streamable = UAssetManager::GetStreamableManager();
                         Streamable.RequestAsyncLoad(MeshesToLoad, FStreamableDelegate::CreateLambda([this, Cell, Transforms, MeshPaths]()
                             {
-                                const int32 BatchSize = 50;
-                                TArray<TTuple<UStaticMesh*, FTransform>> SpawnQueue;
-
-                                // Prepare spawn queue
-                                for (int32 i = 0; i < Transforms.Num(); ++i)
-                                {
-                                    UStaticMesh* Mesh = Cast<UStaticMesh>(FSoftObjectPath(MeshPaths[i]).TryLoad());
-                                    if (!Mesh) continue;
-                                    SpawnQueue.Add(MakeTuple(Mesh, Transforms[i]));
-                                }
-
-                                // Spawn in batches using timers
-                                for (int32 i = 0; i < SpawnQueue.Num(); i += BatchSize)
-                                {
-                                    TArray<TTuple<UStaticMesh*, FTransform>> Batch;
-                                    for (int32 j = i; j < i + BatchSize && j < SpawnQueue.Num(); ++j)
-                                        Batch.Add(SpawnQueue[j]);
-
-                                    FTimerHandle TimerHandle;
-                                    GetWorld()->GetTimerManager().SetTimer(TimerHandle, [this, Batch, Cell]()
-                                        {
-                                            for (auto& Item : Batch)
-                                            {
-                                                UStaticMesh* Mesh = Item.Get<0>();
-                                                FTransform Xf = Item.Get<1>();
-
-                                                // Find or create HISM
-                                                UHierarchicalInstancedStaticMeshComponent* HISMC = nullptr;
-                                                for (auto* Comp : ParentActor->GetComponents())
-                                                {
-                                                    if (auto* H = Cast<UHierarchicalInstancedStaticMeshComponent>(Comp))
-                                                        if (H->GetStaticMesh() == Mesh) { HISMC = H; break; }
-                                                }
-
-                                                if (!HISMC)
-                                                {
-                                                    HISMC = NewObject<UHierarchicalInstancedStaticMeshComponent>(ParentActor);
-                                                    HISMC->SetupAttachment(ParentActor->GetRootComponent());
-                                                    HISMC->SetStaticMesh(Mesh);
-                                                    HISMC->RegisterComponent();
-                                                }
-
-                                                HISMC->AddInstanceWorldSpace(Xf);
-                                            }
-
-                                            // After last batch, mark cell loaded
-                                            LoadedCells.Add(Cell);
-                                            RequestedCells.Remove(Cell);
-
-                                        }, 0.0f, false);
-                                }
+                                AddCellInstances(Cell, MeshPaths, Transforms);
+
+                                LoadedCells.Add(Cell);
+                                RequestedCells.Remove(Cell);
                             }));
                     });
             });
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HeightProvider.h"
+#include "Cesium3DTileset.h"
+#include "Cesium3DTilesSelection/Tile.h"
+#include "Cesium3DTilesSelection/Tileset.h"
+#include "Engine/World.h"
+#include "HeightSamplingSubsystem.h"
+#include "RasterHeightProvider.h"
+#include "TerrainHeightCacheSubsystem.h"
+
+TSharedPtr<IPCGHeightProvider> IPCGHeightProvider::Create(EPCGHeightProviderType Type, UWorld* World, ACesium3DTileset* Tileset)
+{
+    TSharedPtr<IPCGHeightProvider> Provider = CreateDirect(Type, World, Tileset);
+
+    // Everyone in a world shares one queue, so requests are batched, deduped and throttled together
+    UHeightSamplingSubsystem* Service = World ? World->GetSubsystem<UHeightSamplingSubsystem>() : nullptr;
+    if (Provider && Service)
+    {
+        return MakeShared<FCoalescedHeightProvider>(Service, Provider.ToSharedRef());
+    }
+
+    return Provider;
+}
+
+TSharedPtr<IPCGHeightProvider> IPCGHeightProvider::CreateDirect(EPCGHeightProviderType Type, UWorld* World, ACesium3DTileset* Tileset)
+{
+    if (Type == EPCGHeightProviderType::Raster)
+    {
+        const FString& FilePath = GetDefault<UCustomPCGSettings>()->RasterHeightFile.FilePath;
+        if (FilePath.IsEmpty())
+        {
+            UE_LOG(LogTemp, Error, TEXT("HeightProvider: raster provider selected but RasterHeightFile is not set"));
+            return nullptr;
+        }
+
+        return FRasterHeightProvider::Get(FilePath);
+    }
+
+    if (!IsValid(Tileset))
+    {
+        UE_LOG(LogTemp, Error, TEXT("HeightProvider: Cesium provider selected but there is no tileset"));
+        return nullptr;
+    }
+
+    return MakeShared<FCesiumHeightProvider>(World, Tileset);
+}
+
+FCesiumHeightProvider::FCesiumHeightProvider(UWorld* InWorld, ACesium3DTileset* InTileset)
+    : World(InWorld)
+    , Tileset(InTileset)
+{
+}
+
+void FCesiumHeightProvider::SampleHeights(const TArray<FVector>& LonLatPositions, FHeightSampleCallback OnComplete)
+{
+    ACesium3DTileset* TilesetPtr = Tileset.Get();
+    if (!TilesetPtr)
+    {
+        TArray<FCesiumSampleHeightResult> Failed;
+        Failed.SetNum(LonLatPositions.Num());
+        OnComplete(Failed, { TEXT("Tileset was destroyed before sampling") });
+        return;
+    }
+
+    UTerrainHeightCacheSubsystem::SampleHeights(World.Get(), TilesetPtr, LonLatPositions, MoveTemp(OnComplete));
+}
+
+bool FCesiumHeightProvider::IsReady() const
+{
+    ACesium3DTileset* TilesetPtr = Tileset.Get();
+    if (!TilesetPtr || !TilesetPtr->GetTileset()) return false;
+
+    const Cesium3DTilesSelection::Tile* RootTile = TilesetPtr->GetTileset()->getRootTile();
+    return RootTile && RootTile->getState() == Cesium3DTilesSelection::TileLoadState::Done;
+}
+
+FString FCesiumHeightProvider::GetDescription() const
+{
+    return FString::Printf(TEXT("Cesium (%s)"), *UTerrainHeightCacheSubsystem::MakeTilesetKey(Tileset.Get()));
+}
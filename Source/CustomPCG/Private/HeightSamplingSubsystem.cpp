@@ -0,0 +1,395 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HeightSamplingSubsystem.h"
+#include "CustomPCGSettings.h"
+#include "Engine/World.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+
+namespace HeightSamplingSubsystem
+{
+    static FHeightSampleResponse MakeFailedResponse(const TArray<FVector>& Positions, const FString& Warning)
+    {
+        FHeightSampleResponse Response;
+        Response.Results.SetNum(Positions.Num());
+        for (int32 i = 0; i < Positions.Num(); ++i)
+        {
+            Response.Results[i].LongitudeLatitudeHeight = Positions[i];
+            Response.Results[i].SampleSuccess = false;
+        }
+        Response.Warnings.Add(Warning);
+        return Response;
+    }
+
+    static FAutoConsoleCommandWithWorld LogStatsCommand(
+        TEXT("CustomPCG.HeightSamplingStats"),
+        TEXT("Logs request, batch, dedupe, latency and throughput stats of the world's height-sampling service."),
+        FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+            {
+                if (const UHeightSamplingSubsystem* Service = World ? World->GetSubsystem<UHeightSamplingSubsystem>() : nullptr)
+                {
+                    Service->LogStats();
+                }
+            }));
+}
+
+// One provider call; requests are answered from the deduped results by PositionToUnique
+struct UHeightSamplingSubsystem::FBatch
+{
+    TArray<FPendingRequest> Requests;
+
+    // Unique position index of every requested position, requests back to back
+    TArray<int32> PositionToUnique;
+
+    bool bCompleted = false;
+
+    // Owner of the in-flight slot this batch holds until it completes or is abandoned
+    TWeakObjectPtr<UHeightSamplingSubsystem> Service;
+
+    ~FBatch()
+    {
+        // The provider never answered (service or source went away); the slot must be freed and promises must not be left broken
+        if (bCompleted) return;
+
+        // The provider may drop its callback on any thread; the counter and continuations are game-thread only
+        if (IsInGameThread())
+        {
+            Abandon(Service, Requests);
+            return;
+        }
+
+        AsyncTask(ENamedThreads::GameThread, [Service = Service, Abandoned = MoveTemp(Requests)]() mutable
+            {
+                Abandon(Service, Abandoned);
+            });
+    }
+
+    static void Abandon(const TWeakObjectPtr<UHeightSamplingSubsystem>& Service, TArray<FPendingRequest>& Abandoned)
+    {
+        if (UHeightSamplingSubsystem* This = Service.Get())
+        {
+            --This->BatchesInFlight;
+        }
+
+        for (FPendingRequest& Request : Abandoned)
+        {
+            Request.Promise.SetValue(HeightSamplingSubsystem::MakeFailedResponse(Request.Positions, TEXT("Height sampling batch was abandoned")));
+        }
+    }
+};
+
+void UHeightSamplingSubsystem::Deinitialize()
+{
+    LogStats();
+
+    bDeinitialized = true;
+
+    // Continuations may submit again; fail a detached copy so the map isn't modified while iterated
+    TMap<FString, FProviderQueue> Abandoned = MoveTemp(Queues);
+    Queues.Reset();
+
+    for (TPair<FString, FProviderQueue>& Pair : Abandoned)
+    {
+        for (FPendingRequest& Request : Pair.Value.Pending)
+        {
+            Request.Promise.SetValue(HeightSamplingSubsystem::MakeFailedResponse(Request.Positions, TEXT("Height sampling service shut down")));
+        }
+    }
+
+    Super::Deinitialize();
+}
+
+TStatId UHeightSamplingSubsystem::GetStatId() const
+{
+    RETURN_QUICK_DECLARE_CYCLE_STAT(UHeightSamplingSubsystem, STATGROUP_Tickables);
+}
+
+TFuture<FHeightSampleResponse> UHeightSamplingSubsystem::RequestHeights(const TSharedRef<IPCGHeightProvider>& Provider, TArray<FVector> LonLatPositions)
+{
+    if (bDeinitialized || LonLatPositions.Num() == 0)
+    {
+        FHeightSampleResponse Response = bDeinitialized
+            ? HeightSamplingSubsystem::MakeFailedResponse(LonLatPositions, TEXT("Height sampling service shut down"))
+            : FHeightSampleResponse();
+        return MakeFulfilledPromise<FHeightSampleResponse>(MoveTemp(Response)).GetFuture();
+    }
+
+    const double Now = FPlatformTime::Seconds();
+    if (Requests == 0)
+    {
+        FirstRequestSeconds = Now;
+    }
+
+    ++Requests;
+    RequestedPositions += LonLatPositions.Num();
+
+    // The latest instance wins, so a source that was recreated (e.g. new tileset actor) takes over its queue
+    FProviderQueue& Queue = Queues.FindOrAdd(Provider->GetDescription());
+    Queue.Provider = Provider;
+
+    FPendingRequest& Request = Queue.Pending.AddDefaulted_GetRef();
+    Request.Positions = MoveTemp(LonLatPositions);
+    Request.SubmitSeconds = Now;
+    return Request.Promise.GetFuture();
+}
+
+void UHeightSamplingSubsystem::Tick(float DeltaTime)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UHeightSamplingSubsystem::Tick);
+
+    const UCustomPCGSettings* Settings = GetDefault<UCustomPCGSettings>();
+    const int32 MaxInFlight = FMath::Max(Settings->MaxHeightServiceBatchesInFlight, 1);
+
+    TArray<FString> Keys;
+    Queues.GetKeys(Keys);
+
+    // A provider that never becomes ready (tileset removed, raster failed to load) must not hold its requests forever
+    const double Now = FPlatformTime::Seconds();
+    TArray<FPendingRequest> Expired;
+    for (const FString& Key : Keys)
+    {
+        FProviderQueue& Queue = Queues[Key];
+        if (Queue.Pending.Num() == 0 || Queue.Provider->IsReady())
+        {
+            Queue.NotReadySinceSeconds = 0.0;
+            continue;
+        }
+
+        if (Queue.NotReadySinceSeconds == 0.0)
+        {
+            Queue.NotReadySinceSeconds = Now;
+        }
+        else if (Now - Queue.NotReadySinceSeconds > Settings->HeightServiceReadyTimeoutSeconds)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("HeightSampling: %s not ready after %.1f s, failing %d queued requests"),
+                *Key, Now - Queue.NotReadySinceSeconds, Queue.Pending.Num());
+
+            Expired.Append(MoveTemp(Queue.Pending));
+            Queue.Pending.Reset();
+            Queue.NotReadySinceSeconds = 0.0;
+        }
+    }
+
+    // Fulfilled after the scan since continuations may submit again
+    for (FPendingRequest& Request : Expired)
+    {
+        Request.Promise.SetValue(HeightSamplingSubsystem::MakeFailedResponse(Request.Positions, TEXT("Height provider was not ready in time")));
+    }
+
+    // Round robin over sources so one busy provider can't starve the others
+    bool bDispatched = true;
+    while (bDispatched && BatchesInFlight < MaxInFlight)
+    {
+        bDispatched = false;
+        for (const FString& Key : Keys)
+        {
+            if (BatchesInFlight >= MaxInFlight) break;
+
+            FProviderQueue* Queue = Queues.Find(Key);
+            if (Queue && Queue->Pending.Num() > 0 && Queue->Provider->IsReady())
+            {
+                DispatchBatch(*Queue);
+                bDispatched = true;
+            }
+        }
+    }
+}
+
+void UHeightSamplingSubsystem::DispatchBatch(FProviderQueue& Queue)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UHeightSamplingSubsystem::DispatchBatch);
+
+    const int32 MaxPositions = FMath::Max(GetDefault<UCustomPCGSettings>()->HeightServiceBatchSize, 1);
+
+    // Whole requests only; a request larger than the batch size goes out on its own
+    int32 NumRequests = 0;
+    int32 NumPositions = 0;
+    while (NumRequests < Queue.Pending.Num() &&
+        (NumRequests == 0 || NumPositions + Queue.Pending[NumRequests].Positions.Num() <= MaxPositions))
+    {
+        NumPositions += Queue.Pending[NumRequests].Positions.Num();
+        ++NumRequests;
+    }
+
+    TSharedRef<FBatch> Batch = MakeShared<FBatch>();
+    Batch->Service = this;
+    Batch->Requests.Reserve(NumRequests);
+    for (int32 i = 0; i < NumRequests; ++i)
+    {
+        Batch->Requests.Add(MoveTemp(Queue.Pending[i]));
+    }
+    Queue.Pending.RemoveAt(0, NumRequests, EAllowShrinking::No);
+
+    // Identical coordinates, within and across requests, are sampled once
+    TMap<FVector2D, int32> UniqueIndex;
+    UniqueIndex.Reserve(NumPositions);
+    TArray<FVector> UniquePositions;
+    UniquePositions.Reserve(NumPositions);
+    Batch->PositionToUnique.Reserve(NumPositions);
+
+    for (const FPendingRequest& Request : Batch->Requests)
+    {
+        for (const FVector& Position : Request.Positions)
+        {
+            int32& Index = UniqueIndex.FindOrAdd(FVector2D(Position.X, Position.Y), INDEX_NONE);
+            if (Index == INDEX_NONE)
+            {
+                Index = UniquePositions.Add(Position);
+            }
+            Batch->PositionToUnique.Add(Index);
+        }
+    }
+
+    ++BatchesInFlight;
+    ++Batches;
+    SampledPositions += UniquePositions.Num();
+
+    TWeakObjectPtr<UHeightSamplingSubsystem> WeakThis(this);
+    Queue.Provider->SampleHeights(UniquePositions,
+        [WeakThis, Batch](const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings)
+        {
+            if (IsInGameThread())
+            {
+                if (UHeightSamplingSubsystem* This = WeakThis.Get())
+                {
+                    This->CompleteBatch(*Batch, Results, Warnings);
+                }
+                return;
+            }
+
+            // Stats and promises are game-thread only
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, Batch, Results, Warnings]()
+                {
+                    if (UHeightSamplingSubsystem* This = WeakThis.Get())
+                    {
+                        This->CompleteBatch(*Batch, Results, Warnings);
+                    }
+                });
+        });
+}
+
+void UHeightSamplingSubsystem::CompleteBatch(FBatch& Batch, const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings)
+{
+    --BatchesInFlight;
+    Batch.bCompleted = true;
+
+    const double Now = FPlatformTime::Seconds();
+    LastFulfilledSeconds = Now;
+
+    int32 Position = 0;
+    for (FPendingRequest& Request : Batch.Requests)
+    {
+        FHeightSampleResponse Response;
+        Response.Warnings = Warnings;
+        Response.Results.SetNum(Request.Positions.Num());
+
+        for (int32 i = 0; i < Request.Positions.Num(); ++i, ++Position)
+        {
+            const int32 Unique = Batch.PositionToUnique[Position];
+            FCesiumSampleHeightResult& Result = Response.Results[i];
+            if (Results.IsValidIndex(Unique))
+            {
+                Result = Results[Unique];
+            }
+            else
+            {
+                Result.LongitudeLatitudeHeight = Request.Positions[i];
+                Result.SampleSuccess = false;
+            }
+        }
+
+        const double Latency = Now - Request.SubmitSeconds;
+        TotalLatencySeconds += Latency;
+        MaxLatencySeconds = FMath::Max(MaxLatencySeconds, Latency);
+        ++FulfilledRequests;
+        FulfilledPositions += Request.Positions.Num();
+
+        Request.Promise.SetValue(MoveTemp(Response));
+    }
+}
+
+FHeightSamplingStats UHeightSamplingSubsystem::GetStats() const
+{
+    FHeightSamplingStats Stats;
+    Stats.Requests = Requests;
+    Stats.RequestedPositions = RequestedPositions;
+    Stats.SampledPositions = SampledPositions;
+    Stats.Batches = Batches;
+    Stats.BatchesInFlight = BatchesInFlight;
+    Stats.AverageLatencySeconds = FulfilledRequests > 0 ? TotalLatencySeconds / FulfilledRequests : 0.0;
+    Stats.MaxLatencySeconds = MaxLatencySeconds;
+
+    for (const TPair<FString, FProviderQueue>& Pair : Queues)
+    {
+        Stats.QueuedRequests += Pair.Value.Pending.Num();
+    }
+
+    const double Elapsed = LastFulfilledSeconds - FirstRequestSeconds;
+    Stats.PositionsPerSecond = Elapsed > 0.0 ? FulfilledPositions / Elapsed : 0.0;
+    return Stats;
+}
+
+void UHeightSamplingSubsystem::ResetStats()
+{
+    Requests = 0;
+    RequestedPositions = 0;
+    SampledPositions = 0;
+    FulfilledPositions = 0;
+    Batches = 0;
+    FulfilledRequests = 0;
+    TotalLatencySeconds = 0.0;
+    MaxLatencySeconds = 0.0;
+    FirstRequestSeconds = 0.0;
+    LastFulfilledSeconds = 0.0;
+}
+
+void UHeightSamplingSubsystem::LogStats() const
+{
+    const FHeightSamplingStats Stats = GetStats();
+    if (Stats.Requests == 0) return;
+
+    UE_LOG(LogTemp, Log, TEXT("HeightSampling: %lld requests, %lld positions -> %lld sampled (%.1f%% deduped) in %lld batches; latency avg %.3f s, max %.3f s; %.0f positions/s; %d queued, %d in flight"),
+        Stats.Requests,
+        Stats.RequestedPositions,
+        Stats.SampledPositions,
+        Stats.RequestedPositions > 0 ? 100.0 * (Stats.RequestedPositions - Stats.SampledPositions) / Stats.RequestedPositions : 0.0,
+        Stats.Batches,
+        Stats.AverageLatencySeconds,
+        Stats.MaxLatencySeconds,
+        Stats.PositionsPerSecond,
+        Stats.QueuedRequests,
+        Stats.BatchesInFlight);
+}
+
+FCoalescedHeightProvider::FCoalescedHeightProvider(UHeightSamplingSubsystem* InService, const TSharedRef<IPCGHeightProvider>& InInner)
+    : Service(InService)
+    , Inner(InInner)
+{
+}
+
+void FCoalescedHeightProvider::SampleHeights(const TArray<FVector>& LonLatPositions, FHeightSampleCallback OnComplete)
+{
+    UHeightSamplingSubsystem* ServicePtr = Service.Get();
+    if (!ServicePtr)
+    {
+        Inner->SampleHeights(LonLatPositions, MoveTemp(OnComplete));
+        return;
+    }
+
+    // Continuations run wherever the promise was fulfilled; FHeightSampleCallback promises the game thread
+    ServicePtr->RequestHeights(Inner, LonLatPositions).Then([OnComplete = MoveTemp(OnComplete)](TFuture<FHeightSampleResponse> Future)
+        {
+            if (IsInGameThread())
+            {
+                const FHeightSampleResponse& Response = Future.Get();
+                OnComplete(Response.Results, Response.Warnings);
+                return;
+            }
+
+            AsyncTask(ENamedThreads::GameThread, [OnComplete, Response = Future.Get()]()
+                {
+                    OnComplete(Response.Results, Response.Warnings);
+                });
+        });
+}
@@ -0,0 +1,210 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "InstanceBuilderSubsystem.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+
+void UInstanceBuilderSubsystem::Deinitialize()
+{
+    LogStats();
+    SharedComponents.Reset();
+
+    Super::Deinitialize();
+}
+
+EInstanceBackend UInstanceBuilderSubsystem::ResolveBackend(const UStaticMesh* Mesh)
+{
+    const UCustomPCGSettings* Settings = GetDefault<UCustomPCGSettings>();
+
+    EInstanceBackend Backend = Settings->DefaultInstanceBackend;
+    if (Mesh)
+    {
+        if (const EInstanceBackend* Found = Settings->InstanceBackendPerMesh.Find(TSoftObjectPtr<UStaticMesh>(const_cast<UStaticMesh*>(Mesh))))
+        {
+            Backend = *Found;
+        }
+    }
+
+    if (Backend == EInstanceBackend::Auto)
+    {
+        // Nanite culls and selects LODs per cluster on the GPU, so a HISM tree only costs build time
+        Backend = Mesh && Mesh->HasValidNaniteData() ? EInstanceBackend::ISM : EInstanceBackend::HISM;
+    }
+    return Backend;
+}
+
+EInstanceBackend UInstanceBuilderSubsystem::GetBackend(const UInstancedStaticMeshComponent* Component)
+{
+    return Component && Component->IsA<UHierarchicalInstancedStaticMeshComponent>() ? EInstanceBackend::HISM : EInstanceBackend::ISM;
+}
+
+UInstancedStaticMeshComponent* UInstanceBuilderSubsystem::CreateComponent(AActor* Owner, UStaticMesh* Mesh, int32 NumCustomDataFloats, bool bRegister)
+{
+    if (!Owner) return nullptr;
+
+    const EInstanceBackend Backend = ResolveBackend(Mesh);
+    UInstancedStaticMeshComponent* Component = Backend == EInstanceBackend::ISM
+        ? NewObject<UInstancedStaticMeshComponent>(Owner)
+        : NewObject<UHierarchicalInstancedStaticMeshComponent>(Owner);
+
+    const UCustomPCGSettings* Settings = GetDefault<UCustomPCGSettings>();
+    Component->SetStaticMesh(Mesh);
+    Component->SetCullDistances(Settings->InstanceStartCullDistance, Settings->InstanceEndCullDistance);
+    Component->SetNumCustomDataFloats(NumCustomDataFloats);
+    Component->SetupAttachment(Owner->GetRootComponent());
+    if (bRegister)
+    {
+        Component->RegisterComponent();
+    }
+
+    ++StatsOf(Backend).Components;
+    return Component;
+}
+
+UInstancedStaticMeshComponent* UInstanceBuilderSubsystem::FindOrCreateComponent(AActor* Owner, UStaticMesh* Mesh, FIntPoint Group)
+{
+    if (!Owner || !Mesh) return nullptr;
+
+    TWeakObjectPtr<UInstancedStaticMeshComponent>& Shared = SharedComponents.FindOrAdd(FSharedComponentKey(Owner, Mesh, Group));
+    if (!Shared.IsValid())
+    {
+        Shared = CreateComponent(Owner, Mesh);
+    }
+    return Shared.Get();
+}
+
+int32 UInstanceBuilderSubsystem::AddInstances(UInstancedStaticMeshComponent* Component, const TArray<FTransform>& Transforms, bool bWorldSpace)
+{
+    if (!Component) return INDEX_NONE;
+
+    // New instances are appended, so they start at the previous count
+    const int32 FirstInstance = Component->GetInstanceCount();
+    const double StartSeconds = FPlatformTime::Seconds();
+    Component->AddInstances(Transforms, false, bWorldSpace);
+
+    FInstanceBackendStats& BackendStats = StatsOf(GetBackend(Component));
+    BackendStats.AddSeconds += FPlatformTime::Seconds() - StartSeconds;
+    BackendStats.Instances += Transforms.Num();
+    ++BackendStats.Adds;
+
+    return FirstInstance;
+}
+
+int32 UInstanceBuilderSubsystem::AddInstance(UInstancedStaticMeshComponent* Component, const FTransform& Transform, bool bWorldSpace)
+{
+    if (!Component) return INDEX_NONE;
+
+    const double StartSeconds = FPlatformTime::Seconds();
+    const int32 Index = Component->AddInstance(Transform, bWorldSpace);
+
+    FInstanceBackendStats& BackendStats = StatsOf(GetBackend(Component));
+    BackendStats.AddSeconds += FPlatformTime::Seconds() - StartSeconds;
+    ++BackendStats.Instances;
+    ++BackendStats.Adds;
+
+    return Index;
+}
+
+void UInstanceBuilderSubsystem::AddInstancesByMesh(AActor* Owner, TConstArrayView<UStaticMesh*> Meshes, TConstArrayView<FTransform> Transforms, FIntPoint Group, bool bWorldSpace)
+{
+    check(Meshes.Num() == Transforms.Num());
+
+    TMap<UStaticMesh*, TArray<FTransform>> TransformsPerMesh;
+    for (int32 i = 0; i < Meshes.Num(); ++i)
+    {
+        if (Meshes[i])
+        {
+            TransformsPerMesh.FindOrAdd(Meshes[i]).Add(Transforms[i]);
+        }
+    }
+
+    for (const TPair<UStaticMesh*, TArray<FTransform>>& Pair : TransformsPerMesh)
+    {
+        AddInstances(FindOrCreateComponent(Owner, Pair.Key, Group), Pair.Value, bWorldSpace);
+    }
+}
+
+void UInstanceBuilderSubsystem::SetCustomData(UInstancedStaticMeshComponent* Component, int32 FirstInstance, TConstArrayView<float> Values, int32 NumFloats)
+{
+    if (!Component || FirstInstance == INDEX_NONE || NumFloats <= 0 || Values.Num() == 0) return;
+
+    // Sized when the component is created; resizing here would wipe values already written
+    if (Component->NumCustomDataFloats != NumFloats)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("InstanceBuilder: %s has %d custom data floats, %d were written; skipped."),
+            *Component->GetName(), Component->NumCustomDataFloats, NumFloats);
+        return;
+    }
+
+    const int32 NumInstances = FMath::Min(Values.Num() / NumFloats, Component->GetInstanceCount() - FirstInstance);
+    for (int32 i = 0; i < NumInstances; ++i)
+    {
+        Component->SetCustomData(FirstInstance + i, Values.Slice(i * NumFloats, NumFloats), false);
+    }
+
+    // One render state update for the whole range
+    Component->MarkRenderStateDirty();
+}
+
+void UInstanceBuilderSubsystem::ReleaseGroup(AActor* Owner, FIntPoint Group)
+{
+    const TObjectKey<AActor> OwnerKey(Owner);
+
+    for (auto It = SharedComponents.CreateIterator(); It; ++It)
+    {
+        if (It.Key().Get<0>() != OwnerKey || It.Key().Get<2>() != Group) continue;
+
+        if (UInstancedStaticMeshComponent* Component = It.Value().Get())
+        {
+            FInstanceBackendStats& BackendStats = StatsOf(GetBackend(Component));
+            const int32 NumInstances = Component->GetInstanceCount();
+            const double StartSeconds = FPlatformTime::Seconds();
+            Component->DestroyComponent();
+
+            BackendStats.RemoveSeconds += FPlatformTime::Seconds() - StartSeconds;
+            BackendStats.RemovedInstances += NumInstances;
+        }
+        It.RemoveCurrent();
+    }
+}
+
+void UInstanceBuilderSubsystem::ReadInstances(const UInstancedStaticMeshComponent* Component, TArray<FTransform>& OutTransforms)
+{
+    const int32 NumInstances = Component ? Component->GetInstanceCount() : 0;
+    OutTransforms.SetNumUninitialized(NumInstances);
+    for (int32 i = 0; i < NumInstances; ++i)
+    {
+        Component->GetInstanceTransform(i, OutTransforms[i], true);
+    }
+}
+
+FInstanceBuilderStats UInstanceBuilderSubsystem::GetStats() const
+{
+    return Stats;
+}
+
+void UInstanceBuilderSubsystem::ResetStats()
+{
+    Stats = FInstanceBuilderStats();
+}
+
+void UInstanceBuilderSubsystem::LogStats() const
+{
+    for (const EInstanceBackend Backend : { EInstanceBackend::HISM, EInstanceBackend::ISM })
+    {
+        const FInstanceBackendStats& BackendStats = Backend == EInstanceBackend::HISM ? Stats.HISM : Stats.ISM;
+        if (BackendStats.Components == 0 && BackendStats.Instances == 0) continue;
+
+        UE_LOG(LogTemp, Log, TEXT("InstanceBuilder %-4s: %d components, %lld instances in %d adds (%.2f ms, %.0f instances/s), %lld removed (%.2f ms)"),
+            *StaticEnum<EInstanceBackend>()->GetNameStringByValue(int64(Backend)),
+            BackendStats.Components, BackendStats.Instances, BackendStats.Adds, BackendStats.AddSeconds * 1000.0,
+            BackendStats.AddSeconds > 0.0 ? BackendStats.Instances / BackendStats.AddSeconds : 0.0,
+            BackendStats.RemovedInstances, BackendStats.RemoveSeconds * 1000.0);
+    }
+}
+
+FInstanceBackendStats& UInstanceBuilderSubsystem::StatsOf(EInstanceBackend Backend)
+{
+    return Backend == EInstanceBackend::ISM ? Stats.ISM : Stats.HISM;
+}
@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PCGActorPoolSubsystem.h"
+#include "CustomPCGSettings.h"
+#include "Engine/World.h"
+
+template <typename ActorType>
+static ActorType* PopPooledActor(TArray<ActorType*>& Pool)
+{
+    while (Pool.Num() > 0)
+    {
+        ActorType* Actor = Pool.Pop(EAllowShrinking::No);
+        if (IsValid(Actor))
+        {
+            return Actor;
+        }
+    }
+    return nullptr;
+}
+
+static void WakePooledActor(AActor* Actor, const FVector& Location, AActor* Owner)
+{
+    Actor->SetOwner(Owner);
+    Actor->SetActorLocation(Location, false, nullptr, ETeleportType::ResetPhysics);
+    Actor->SetActorHiddenInGame(false);
+}
+
+void UPCGActorPoolSubsystem::Deinitialize()
+{
+    PooledPolygonActors.Empty();
+    PooledHiGenActors.Empty();
+    Super::Deinitialize();
+}
+
+APCGPolygonActor* UPCGActorPoolSubsystem::AcquirePolygonActor(const FVector& Location, AActor* Owner)
+{
+    if (APCGPolygonActor* Actor = PopPooledActor(PooledPolygonActors))
+    {
+        ++PolygonActorHits;
+        WakePooledActor(Actor, Location, Owner);
+        return Actor;
+    }
+
+    ++PolygonActorMisses;
+
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.Owner = Owner;
+    return GetWorld()->SpawnActor<APCGPolygonActor>(APCGPolygonActor::StaticClass(), Location, FRotator::ZeroRotator, SpawnParams);
+}
+
+void UPCGActorPoolSubsystem::ReleasePolygonActor(APCGPolygonActor* Actor)
+{
+    if (!IsValid(Actor)) return;
+
+    if (PooledPolygonActors.Num() >= GetDefault<UCustomPCGSettings>()->MaxPooledPolygonActors)
+    {
+        Actor->Destroy();
+        return;
+    }
+
+    Actor->ResetForPool();
+    PooledPolygonActors.Add(Actor);
+}
+
+APolygonHiGenActor* UPCGActorPoolSubsystem::AcquireHiGenActor(const FVector& Location, AActor* Owner)
+{
+    if (APolygonHiGenActor* Actor = PopPooledActor(PooledHiGenActors))
+    {
+        ++HiGenActorHits;
+        WakePooledActor(Actor, Location, Owner);
+        return Actor;
+    }
+
+    ++HiGenActorMisses;
+
+    FActorSpawnParameters SpawnParams;
+    SpawnParams.Owner = Owner;
+    return GetWorld()->SpawnActor<APolygonHiGenActor>(APolygonHiGenActor::StaticClass(), Location, FRotator::ZeroRotator, SpawnParams);
+}
+
+void UPCGActorPoolSubsystem::ReleaseHiGenActor(APolygonHiGenActor* Actor)
+{
+    if (!IsValid(Actor)) return;
+
+    if (PooledHiGenActors.Num() >= GetDefault<UCustomPCGSettings>()->MaxPooledHiGenActors)
+    {
+        Actor->Destroy();
+        return;
+    }
+
+    Actor->ResetForPool();
+    PooledHiGenActors.Add(Actor);
+}
+
+FPCGActorPoolStats UPCGActorPoolSubsystem::GetStats() const
+{
+    FPCGActorPoolStats Stats;
+    Stats.PolygonActorHits = PolygonActorHits;
+    Stats.PolygonActorMisses = PolygonActorMisses;
+    Stats.PooledPolygonActors = PooledPolygonActors.Num();
+    Stats.HiGenActorHits = HiGenActorHits;
+    Stats.HiGenActorMisses = HiGenActorMisses;
+    Stats.PooledHiGenActors = PooledHiGenActors.Num();
+    return Stats;
+}
+
+void UPCGActorPoolSubsystem::ResetStats()
+{
+    PolygonActorHits = 0;
+    PolygonActorMisses = 0;
+    HiGenActorHits = 0;
+    HiGenActorMisses = 0;
+}
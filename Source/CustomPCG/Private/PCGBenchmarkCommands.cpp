@@ -0,0 +1,414 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CoreMinimal.h"
+#include "CesiumGeoreference.h"
+#include "Data/PCGPointData.h"
+#include "Data/PCGSplineData.h"
+#include "Elements/PCGSplineSampler.h"
+#include "EngineUtils.h"
+#include "GeoreferenceBatchTransform.h"
+#include "HAL/IConsoleManager.h"
+#include "PCGComponent.h"
+#include "PCGPolygonActor.h"
+#include "PCGPolygonInteriorSamplerSettings.h"
+#include "PCGPointContent.h"
+#include "InstanceBuilderSubsystem.h"
+#include "RasterHeightProvider.h"
+#include "CustomPCGSettings.h"
+#include "Async/ParallelFor.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Math/RandomStream.h"
+
+namespace PCGBenchmarkCommands
+{
+    // Runs PCG's spline sampler on the actor's spline, the path polygon graphs use today
+    static int32 RunSplineSampler(APCGPolygonActor* Actor, float Spacing)
+    {
+        UPCGSplineData* SplineData = NewObject<UPCGSplineData>();
+        SplineData->Initialize(Actor->SplineComponent);
+
+        UPCGSplineSamplerSettings* Settings = NewObject<UPCGSplineSamplerSettings>();
+        Settings->SamplerParams.Dimension = EPCGSplineSamplingDimension::OnInterior;
+        Settings->SamplerParams.InteriorSpacing = Spacing;
+
+        FPCGDataCollection InputData;
+        InputData.TaggedData.Emplace_GetRef().Data = SplineData;
+        InputData.TaggedData.Emplace_GetRef().Data = Settings;
+
+        FPCGElementPtr Element = Settings->GetElement();
+        FPCGContext* Context = Element->Initialize(InputData, Actor->PCGComponent, nullptr);
+        while (!Element->Execute(Context)) {}
+
+        int32 NumPoints = 0;
+        for (const FPCGTaggedData& Output : Context->OutputData.TaggedData)
+        {
+            if (const UPCGPointData* PointData = Cast<UPCGPointData>(Output.Data))
+            {
+                NumPoints += PointData->GetPoints().Num();
+            }
+        }
+
+        delete Context;
+        return NumPoints;
+    }
+
+    static void LogResult(const TCHAR* Label, int32 Points, double Seconds)
+    {
+        UE_LOG(LogTemp, Log, TEXT("  %-16s %10d points %10.2f ms %14.0f points/s"),
+            Label, Points, Seconds * 1000.0, Seconds > 0.0 ? Points / Seconds : 0.0);
+    }
+
+    static void BenchmarkInteriorSampler(const TArray<FString>& Args, UWorld* World)
+    {
+        if (!World) return;
+
+        const int32 Iterations = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 3;
+
+        int32 NumActors = 0;
+        int32 SplinePoints = 0;
+        int32 TrianglePoints = 0;
+        double SplineSeconds = 0.0;
+        double TriangleSeconds = 0.0;
+
+        for (TActorIterator<APCGPolygonActor> It(World); It; ++It)
+        {
+            APCGPolygonActor* Actor = *It;
+            if (!Actor->SplineComponent || Actor->SplineComponent->GetNumberOfSplinePoints() < 3) continue;
+
+            const float Spacing = Actor->InteriorSampleSpacing;
+            ++NumActors;
+
+            for (int32 Iteration = 0; Iteration < Iterations; ++Iteration)
+            {
+                double StartTime = FPlatformTime::Seconds();
+                SplinePoints += RunSplineSampler(Actor, Spacing);
+                SplineSeconds += FPlatformTime::Seconds() - StartTime;
+
+                StartTime = FPlatformTime::Seconds();
+                if (const UPCGPointData* PointData = FPCGPolygonInteriorSamplerElement::SamplePolygonActor(Actor, Spacing, 1.0f, true, Iteration, GetTransientPackage()))
+                {
+                    TrianglePoints += PointData->GetPoints().Num();
+                }
+                TriangleSeconds += FPlatformTime::Seconds() - StartTime;
+            }
+        }
+
+        UE_LOG(LogTemp, Log, TEXT("Interior sampler benchmark: %d polygon actors, %d iterations"), NumActors, Iterations);
+        LogResult(TEXT("Spline sampler"), SplinePoints, SplineSeconds);
+        LogResult(TEXT("Triangulated"), TrianglePoints, TriangleSeconds);
+        if (TriangleSeconds > 0.0)
+        {
+            UE_LOG(LogTemp, Log, TEXT("  Speedup %.2fx"), SplineSeconds / TriangleSeconds);
+        }
+    }
+
+    static void BenchmarkGeoreferenceTransforms(const TArray<FString>& Args, UWorld* World)
+    {
+        ACesiumGeoreference* Georef = World ? ACesiumGeoreference::GetDefaultGeoreference(World) : nullptr;
+        if (!Georef) return;
+
+        const int32 NumPoints = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000000;
+
+        // Spread over a degree around the origin, like a large shapefile
+        FRandomStream Random(NumPoints);
+        TArray<FVector> LonLatHeights;
+        LonLatHeights.SetNumUninitialized(NumPoints);
+        for (FVector& LLH : LonLatHeights)
+        {
+            LLH = FVector(Georef->GetOriginLongitude() + Random.FRandRange(-0.5f, 0.5f),
+                Georef->GetOriginLatitude() + Random.FRandRange(-0.5f, 0.5f),
+                Random.FRandRange(0.0f, 2000.0f));
+        }
+
+        TArray<FVector> PerPointUnreal;
+        TArray<FVector> PerPointLLH;
+        TArray<FVector> BatchUnreal;
+        TArray<FVector> BatchLLH;
+        PerPointUnreal.SetNumUninitialized(NumPoints);
+        PerPointLLH.SetNumUninitialized(NumPoints);
+        BatchUnreal.SetNumUninitialized(NumPoints);
+        BatchLLH.SetNumUninitialized(NumPoints);
+
+        double StartTime = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NumPoints; ++i)
+        {
+            PerPointUnreal[i] = Georef->TransformLongitudeLatitudeHeightPositionToUnreal(LonLatHeights[i]);
+        }
+        const double PerPointToUnrealSeconds = FPlatformTime::Seconds() - StartTime;
+
+        StartTime = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NumPoints; ++i)
+        {
+            PerPointLLH[i] = Georef->TransformUnrealPositionToLongitudeLatitudeHeight(PerPointUnreal[i]);
+        }
+        const double PerPointToLLHSeconds = FPlatformTime::Seconds() - StartTime;
+
+        // Matrix capture is part of what a call site pays per batch
+        StartTime = FPlatformTime::Seconds();
+        FGeoreferenceBatchTransform(Georef).LongitudeLatitudeHeightToUnreal(LonLatHeights, BatchUnreal);
+        const double BatchToUnrealSeconds = FPlatformTime::Seconds() - StartTime;
+
+        StartTime = FPlatformTime::Seconds();
+        FGeoreferenceBatchTransform(Georef).UnrealToLongitudeLatitudeHeight(PerPointUnreal, BatchLLH);
+        const double BatchToLLHSeconds = FPlatformTime::Seconds() - StartTime;
+
+        double MaxUnrealError = 0.0;
+        double MaxHeightError = 0.0;
+        double MaxDegreesError = 0.0;
+        for (int32 i = 0; i < NumPoints; ++i)
+        {
+            MaxUnrealError = FMath::Max(MaxUnrealError, FVector::Dist(PerPointUnreal[i], BatchUnreal[i]));
+            MaxHeightError = FMath::Max(MaxHeightError, FMath::Abs(PerPointLLH[i].Z - BatchLLH[i].Z));
+            MaxDegreesError = FMath::Max(MaxDegreesError, FMath::Max(FMath::Abs(PerPointLLH[i].X - BatchLLH[i].X), FMath::Abs(PerPointLLH[i].Y - BatchLLH[i].Y)));
+        }
+
+        UE_LOG(LogTemp, Log, TEXT("Georeference transform benchmark: %d points"), NumPoints);
+        LogResult(TEXT("LLH->UE single"), NumPoints, PerPointToUnrealSeconds);
+        LogResult(TEXT("LLH->UE batch"), NumPoints, BatchToUnrealSeconds);
+        LogResult(TEXT("UE->LLH single"), NumPoints, PerPointToLLHSeconds);
+        LogResult(TEXT("UE->LLH batch"), NumPoints, BatchToLLHSeconds);
+        UE_LOG(LogTemp, Log, TEXT("  Max difference: %.4f cm (Unreal), %.2e deg, %.4f m height"), MaxUnrealError, MaxDegreesError, MaxHeightError);
+    }
+
+    // The previous extraction: spawn the blueprint, read its first mesh component, destroy it
+    static UStaticMesh* ExtractMeshBySpawning(UWorld* World, TSubclassOf<AActor> BPClass)
+    {
+        AActor* TempActor = World->SpawnActor<AActor>(BPClass, FVector::ZeroVector, FRotator::ZeroRotator);
+        if (!TempActor) return nullptr;
+
+        UStaticMesh* FoundMesh = nullptr;
+        TInlineComponentArray<UStaticMeshComponent*> MeshComponents;
+        TempActor->GetComponents(MeshComponents);
+        for (UStaticMeshComponent* Comp : MeshComponents)
+        {
+            if (Comp->GetStaticMesh())
+            {
+                FoundMesh = Comp->GetStaticMesh();
+                break;
+            }
+        }
+
+        TempActor->Destroy();
+        return FoundMesh;
+    }
+
+    static void BenchmarkMeshExtraction(const TArray<FString>& Args, UWorld* World)
+    {
+        if (!World) return;
+
+        const int32 NumPoints = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+        // Spawning per point is slow enough that only a sample is timed and extrapolated
+        const int32 NumSpawnedPoints = FMath::Min(NumPoints, Args.Num() > 1 ? FMath::Max(FCString::Atoi(*Args[1]), 1) : 2000);
+
+        // Same registry the point content uses unless one is given
+        const UBlueprintRegistery* Registry = Args.Num() > 2
+            ? LoadObject<UBlueprintRegistery>(nullptr, *Args[2])
+            : APCGPointContent::LoadBlueprintRegistry();
+        if (!Registry)
+        {
+            UE_LOG(LogTemp, Error, TEXT("BenchmarkMeshExtraction: registry not found: %s"),
+                Args.Num() > 2 ? *Args[2] : *GetDefault<UCustomPCGSettings>()->PointModelRegistry.ToString());
+            return;
+        }
+
+        TArray<TSubclassOf<AActor>> Classes;
+        for (const TSoftClassPtr<AActor>& SoftBP : Registry->BlueprintClasses)
+        {
+            if (TSubclassOf<AActor> Class = SoftBP.LoadSynchronous())
+            {
+                Classes.Add(Class);
+            }
+        }
+        if (Classes.Num() == 0) return;
+
+        // Random model per point, like a mixed vegetation file
+        FRandomStream Random(NumPoints);
+        TArray<int32> PointClasses;
+        PointClasses.SetNumUninitialized(NumPoints);
+        for (int32& ClassIndex : PointClasses)
+        {
+            ClassIndex = Random.RandRange(0, Classes.Num() - 1);
+        }
+
+        double StartTime = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NumSpawnedPoints; ++i)
+        {
+            ExtractMeshBySpawning(World, Classes[PointClasses[i]]);
+        }
+        const double SpawnSeconds = FPlatformTime::Seconds() - StartTime;
+
+        APCGPointContent::ResetExtractedMeshCache();
+        StartTime = FPlatformTime::Seconds();
+        for (int32 i = 0; i < NumPoints; ++i)
+        {
+            APCGPointContent::ExtractMeshFromBlueprint(Classes[PointClasses[i]]);
+        }
+        const double CachedSeconds = FPlatformTime::Seconds() - StartTime;
+
+        int32 Mismatches = 0;
+        for (TSubclassOf<AActor> Class : Classes)
+        {
+            Mismatches += ExtractMeshBySpawning(World, Class) != APCGPointContent::ExtractMeshFromBlueprint(Class) ? 1 : 0;
+        }
+
+        UE_LOG(LogTemp, Log, TEXT("Mesh extraction benchmark: %d points, %d blueprint classes"), NumPoints, Classes.Num());
+        LogResult(TEXT("Spawn (sampled)"), NumSpawnedPoints, SpawnSeconds);
+        LogResult(TEXT("Spawn (est.)"), NumPoints, SpawnSeconds * NumPoints / NumSpawnedPoints);
+        LogResult(TEXT("Cached defaults"), NumPoints, CachedSeconds);
+        UE_LOG(LogTemp, Log, TEXT("  Classes whose extracted mesh differs: %d"), Mismatches);
+    }
+
+    // Adds the same instances to a fresh component of each backend; the HISM tree is built synchronously so its cost is counted
+    static void BenchmarkInstanceBackends(const TArray<FString>& Args, UWorld* World)
+    {
+        if (!World) return;
+
+        const int32 NumInstances = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 100000;
+        const FString MeshPath = Args.Num() > 1 ? Args[1] : TEXT("/Engine/BasicShapes/Cube.Cube");
+
+        UStaticMesh* Mesh = LoadObject<UStaticMesh>(nullptr, *MeshPath);
+        if (!Mesh)
+        {
+            UE_LOG(LogTemp, Error, TEXT("BenchmarkInstanceBackends: mesh not found: %s"), *MeshPath);
+            return;
+        }
+
+        FRandomStream Random(1);
+        TArray<FTransform> Transforms;
+        Transforms.Reserve(NumInstances);
+        for (int32 i = 0; i < NumInstances; ++i)
+        {
+            const FVector Location(Random.FRandRange(-500000.0, 500000.0), Random.FRandRange(-500000.0, 500000.0), 0.0);
+            Transforms.Emplace(FRotator(0.0f, Random.FRandRange(0.0f, 360.0f), 0.0f), Location, FVector(Random.FRandRange(0.5f, 1.5f)));
+        }
+
+        AActor* Owner = World->SpawnActor<AActor>();
+        Owner->SetRootComponent(NewObject<USceneComponent>(Owner));
+        Owner->GetRootComponent()->RegisterComponent();
+
+        UE_LOG(LogTemp, Log, TEXT("Instance backend benchmark: %d instances of %s (Nanite data: %s, Auto resolves to %s)"),
+            NumInstances, *Mesh->GetPathName(), Mesh->HasValidNaniteData() ? TEXT("yes") : TEXT("no"),
+            *StaticEnum<EInstanceBackend>()->GetNameStringByValue(int64(UInstanceBuilderSubsystem::ResolveBackend(Mesh))));
+
+        for (const bool bHierarchical : { true, false })
+        {
+            UInstancedStaticMeshComponent* Component = bHierarchical
+                ? NewObject<UHierarchicalInstancedStaticMeshComponent>(Owner)
+                : NewObject<UInstancedStaticMeshComponent>(Owner);
+            Component->SetStaticMesh(Mesh);
+            Component->SetupAttachment(Owner->GetRootComponent());
+            Component->RegisterComponent();
+
+            const double StartTime = FPlatformTime::Seconds();
+            Component->AddInstances(Transforms, false, true);
+            if (UHierarchicalInstancedStaticMeshComponent* HISM = Cast<UHierarchicalInstancedStaticMeshComponent>(Component))
+            {
+                HISM->BuildTreeIfOutdated(false, true);
+            }
+            LogResult(bHierarchical ? TEXT("HISM (+tree)") : TEXT("ISM"), NumInstances, FPlatformTime::Seconds() - StartTime);
+
+            Component->DestroyComponent();
+        }
+
+        Owner->Destroy();
+    }
+
+    // Samples random positions inside the raster on one thread and spread over the thread pool like the provider does
+    static void BenchmarkRasterHeights(const TArray<FString>& Args, UWorld* World)
+    {
+        const int32 NumPoints = Args.Num() > 0 ? FMath::Max(FCString::Atoi(*Args[0]), 1) : 1000000;
+        const FString FilePath = Args.Num() > 1 ? Args[1] : GetDefault<UCustomPCGSettings>()->RasterHeightFile.FilePath;
+
+        TSharedPtr<FRasterHeightProvider> Raster = FRasterHeightProvider::Get(FilePath);
+        if (!Raster)
+        {
+            UE_LOG(LogTemp, Error, TEXT("BenchmarkRasterHeights: could not open raster: %s"), *FilePath);
+            return;
+        }
+
+        const FBox2D Bounds = Raster->GetLonLatBounds();
+        FRandomStream Random(NumPoints);
+        TArray<FVector> LonLats;
+        LonLats.SetNumUninitialized(NumPoints);
+        for (FVector& LonLat : LonLats)
+        {
+            LonLat = FVector(Random.FRandRange(Bounds.Min.X, Bounds.Max.X), Random.FRandRange(Bounds.Min.Y, Bounds.Max.Y), 0.0);
+        }
+
+        TArray<FCesiumSampleHeightResult> SingleResults;
+        TArray<FCesiumSampleHeightResult> ParallelResults;
+        SingleResults.SetNum(NumPoints);
+        ParallelResults.SetNum(NumPoints);
+
+        double StartTime = FPlatformTime::Seconds();
+        Raster->SampleHeightsImmediate(LonLats, SingleResults);
+        const double SingleSeconds = FPlatformTime::Seconds() - StartTime;
+
+        constexpr int32 PointsPerTask = 16384;
+        StartTime = FPlatformTime::Seconds();
+        ParallelFor(FMath::DivideAndRoundUp(NumPoints, PointsPerTask), [&](int32 TaskIndex)
+            {
+                const int32 Start = TaskIndex * PointsPerTask;
+                const int32 Num = FMath::Min(PointsPerTask, NumPoints - Start);
+                Raster->SampleHeightsImmediate(
+                    TConstArrayView<FVector>(LonLats.GetData() + Start, Num),
+                    TArrayView<FCesiumSampleHeightResult>(ParallelResults.GetData() + Start, Num));
+            });
+        const double ParallelSeconds = FPlatformTime::Seconds() - StartTime;
+
+        int32 Failed = 0;
+        for (const FCesiumSampleHeightResult& Result : SingleResults)
+        {
+            Failed += Result.SampleSuccess ? 0 : 1;
+        }
+
+        UE_LOG(LogTemp, Log, TEXT("Raster height benchmark: %d points on %s (%d x %d)"), NumPoints, *Raster->GetDescription(), Raster->GetWidth(), Raster->GetHeight());
+        LogResult(TEXT("Single thread"), NumPoints, SingleSeconds);
+        LogResult(TEXT("Thread pool"), NumPoints, ParallelSeconds);
+        UE_LOG(LogTemp, Log, TEXT("  Failed samples (nodata): %d"), Failed);
+    }
+
+    static void LogInstanceBackendStats(const TArray<FString>& Args, UWorld* World)
+    {
+        UInstanceBuilderSubsystem* InstanceBuilder = World ? World->GetSubsystem<UInstanceBuilderSubsystem>() : nullptr;
+        if (!InstanceBuilder) return;
+
+        InstanceBuilder->LogStats();
+        if (Args.Num() > 0 && Args[0] == TEXT("reset"))
+        {
+            InstanceBuilder->ResetStats();
+        }
+    }
+
+    static FAutoConsoleCommandWithWorldAndArgs BenchmarkInteriorSamplerCommand(
+        TEXT("CustomPCG.BenchmarkInteriorSampler"),
+        TEXT("Times PCG's spline interior sampler against the triangulated polygon sampler on every polygon actor. Usage: CustomPCG.BenchmarkInteriorSampler [Iterations]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkInteriorSampler));
+
+    static FAutoConsoleCommandWithWorldAndArgs BenchmarkGeoreferenceTransformsCommand(
+        TEXT("CustomPCG.BenchmarkGeoreferenceTransforms"),
+        TEXT("Times per-point georeference conversions against the batch transform, both directions, and reports the largest difference. Usage: CustomPCG.BenchmarkGeoreferenceTransforms [NumPoints]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkGeoreferenceTransforms));
+
+    static FAutoConsoleCommandWithWorldAndArgs BenchmarkMeshExtractionCommand(
+        TEXT("CustomPCG.BenchmarkMeshExtraction"),
+        TEXT("Times per-point mesh extraction by spawning each registry blueprint against the cached class-default extraction. Usage: CustomPCG.BenchmarkMeshExtraction [NumPoints] [SpawnedPoints] [RegistryPath]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkMeshExtraction));
+
+    static FAutoConsoleCommandWithWorldAndArgs BenchmarkRasterHeightsCommand(
+        TEXT("CustomPCG.BenchmarkRasterHeights"),
+        TEXT("Times raster height sampling on one thread and on the thread pool and reports points per second. Usage: CustomPCG.BenchmarkRasterHeights [NumPoints] [RasterFile]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkRasterHeights));
+
+    static FAutoConsoleCommandWithWorldAndArgs BenchmarkInstanceBackendsCommand(
+        TEXT("CustomPCG.BenchmarkInstanceBackends"),
+        TEXT("Times adding the same instances to an HISM (including a synchronous tree build) and to a plain ISM. Usage: CustomPCG.BenchmarkInstanceBackends [NumInstances] [MeshPath]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&BenchmarkInstanceBackends));
+
+    static FAutoConsoleCommandWithWorldAndArgs InstanceBackendStatsCommand(
+        TEXT("CustomPCG.InstanceBackendStats"),
+        TEXT("Logs components, instances, add and remove time per instance backend in this world. Usage: CustomPCG.InstanceBackendStats [reset]"),
+        FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&LogInstanceBackendStats));
+}
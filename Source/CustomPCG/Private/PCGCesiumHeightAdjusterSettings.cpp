@@ -8,7 +8,12 @@
 #include "DrawDebugHelpers.h"
 #include "Kismet/GameplayStatics.h"
 #include "PCGPolygonContent.h"
+#include "PolygonScanlineTable.h"
+#include "HeightProvider.h"
+#include "GeoreferenceBatchTransform.h"
 #include "EngineUtils.h"
+#include "Async/ParallelFor.h"
+#include "UObject/StrongObjectPtr.h"
 #include <optional>
 
 #define LOCTEXT_NAMESPACE "PCGCesiumHeightAdjusterElement"
@@ -508,63 +513,235 @@ FPCGElementPtr UPCGCesiumHeightAdjusterSettings::CreateElement() const
 //}
 
 
-//last working on 5.4
-bool FPCGCesiumHeightAdjusterElement::ExecuteInternal(FPCGContext* Context) const
+namespace PCGCesiumHeightAdjuster
 {
-    TRACE_CPUPROFILER_EVENT_SCOPE(FPCGCesiumHeightAdjusterElement::Execute);
-    check(Context);
+    // Points per ParallelFor task when converting a chunk's positions
+    static constexpr int32 PointsPerTask = 1024;
 
-    if (!Context || !Context->SourceComponent.IsValid())
+    // One execution's points, split into chunks that are height sampled independently.
+    // Lives on the game thread: chunks are issued and completed from the provider's game-thread callbacks.
+    struct FHeightAdjustJob
     {
-        UE_LOG(LogTemp, Error, TEXT("Invalid PCG Context or Source Component."));
-        return true;
-    }
+        struct FOutput
+        {
+            // Sampled heights are written straight into this data's points; null for pass-through inputs
+            TStrongObjectPtr<UPCGPointData> Data;
+            int32 PassThroughInput = INDEX_NONE;
+            TSet<FString> Tags;
+        };
 
-    static TSet<uint64> RunningTasks;
-    static TSet<uint64> CompletedTasks;
-    static bool bfirstRun = true;
+        struct FChunk
+        {
+            int32 Output = 0;
+            int32 Start = 0;
+            int32 Num = 0;
+        };
 
-    static FCriticalSection TaskMutex;
+        TArray<FOutput> Outputs;
+        TArray<FChunk> Chunks;
 
-    if (bfirstRun) {
-        FScopeLock Lock(&TaskMutex);
-        RunningTasks.Empty();
-        CompletedTasks.Empty();
-        bfirstRun = false;
+        TSharedPtr<IPCGHeightProvider> Provider;
+        TWeakObjectPtr<ACesiumGeoreference> Georef;
 
+        // Georeference matrices captured once for every chunk of the execution
+        FGeoreferenceBatchTransform GeoTransform;
 
-    }
+        // Cleared by the context's destructor; callbacks wake it as chunks complete
+        FPCGContext* Context = nullptr;
 
-    const uint64 TaskId = Context->TaskId;
+        int32 MaxChunksInFlight = 1;
+        int32 NextChunk = 0;
+        int32 ChunksInFlight = 0;
+        int32 CompletedChunks = 0;
+        int32 TotalPoints = 0;
+        int32 SampledPoints = 0;
+        int32 ReportedPercent = 0;
 
-    {
+        bool IsDone() const { return CompletedChunks == Chunks.Num(); }
+    };
 
-        FScopeLock Lock(&TaskMutex);
+    // Runs Body(Start, Num) over [0, Num) in PointsPerTask slices
+    template <typename BodyType>
+    static void ParallelForSlices(int32 Num, BodyType&& Body)
+    {
+        ParallelFor(FMath::DivideAndRoundUp(Num, PointsPerTask), [Num, &Body](int32 TaskIndex)
+            {
+                const int32 Start = TaskIndex * PointsPerTask;
+                Body(Start, FMath::Min(PointsPerTask, Num - Start));
+            });
+    }
 
-        if (CompletedTasks.Contains(TaskId))
+    static void IssueChunks(const TSharedRef<FHeightAdjustJob>& Job)
+    {
+        while (Job->ChunksInFlight < Job->MaxChunksInFlight && Job->NextChunk < Job->Chunks.Num())
         {
-            return true;
+            const int32 ChunkIndex = Job->NextChunk++;
+            const FHeightAdjustJob::FChunk& Chunk = Job->Chunks[ChunkIndex];
+
+            ACesiumGeoreference* Georef = Job->Georef.Get();
+            if (!Georef)
+            {
+                // Nothing left to sample with; count the chunk so the execution can finish
+                Job->CompletedChunks++;
+                continue;
+            }
+
+            // Positions only exist for chunks in flight, which keeps memory bounded by MaxChunksInFlight * ChunkSize
+            const TArray<FPCGPoint>& Points = Job->Outputs[Chunk.Output].Data->GetPoints();
+            TArray<FVector> LonLatPositions;
+            LonLatPositions.SetNumUninitialized(Chunk.Num);
+
+            ParallelForSlices(Chunk.Num, [&Job, &Points, &Chunk, &LonLatPositions](int32 Start, int32 Num)
+                {
+                    TArrayView<FVector> Slice(LonLatPositions.GetData() + Start, Num);
+                    for (int32 i = 0; i < Num; ++i)
+                    {
+                        Slice[i] = Points[Chunk.Start + Start + i].Transform.GetLocation();
+                    }
+
+                    Job->GeoTransform.UnrealToLongitudeLatitudeHeight(Slice, Slice);
+                    for (FVector& LonLat : Slice)
+                    {
+                        LonLat.Z = 0.0;
+                    }
+                });
+
+            Job->ChunksInFlight++;
+
+            Job->Provider->SampleHeights(LonLatPositions,
+                [Job, ChunkIndex](const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings)
+                {
+                    const FHeightAdjustJob::FChunk& Chunk = Job->Chunks[ChunkIndex];
+                    UPCGPointData* OutputData = Job->Outputs[Chunk.Output].Data.Get();
+
+                    if (Results.Num() != Chunk.Num)
+                    {
+                        UE_LOG(LogTemp, Error, TEXT("Mismatch in sample result count: Expected %d, Got %d."), Chunk.Num, Results.Num());
+                    }
+                    else if (Job->Georef.IsValid() && OutputData)
+                    {
+                        TArray<FPCGPoint>& Points = OutputData->GetMutablePoints();
+
+                        ParallelForSlices(Chunk.Num, [&Job, &Points, &Chunk, &Results](int32 Start, int32 Num)
+                            {
+                                TArray<FVector> Positions;
+                                Positions.SetNumUninitialized(Num);
+                                for (int32 i = 0; i < Num; ++i)
+                                {
+                                    Positions[i] = Results[Start + i].LongitudeLatitudeHeight;
+                                }
+                                Job->GeoTransform.LongitudeLatitudeHeightToUnreal(Positions, Positions);
+
+                                for (int32 i = 0; i < Num; ++i)
+                                {
+                                    if (Results[Start + i].SampleSuccess)
+                                    {
+                                        Points[Chunk.Start + Start + i].Transform.SetLocation(Positions[i]);
+                                    }
+                                }
+                            });
+                    }
+
+                    Job->SampledPoints += Chunk.Num;
+                    Job->ChunksInFlight--;
+                    Job->CompletedChunks++;
+
+                    IssueChunks(Job);
+
+                    if (Job->Context)
+                    {
+                        Job->Context->bIsPaused = false;
+                    }
+                });
         }
+    }
 
-        if (RunningTasks.Contains(TaskId))
+    // Outputs go out in input order, whatever order the chunks completed in
+    static void EmitOutputs(FPCGContext* Context, FHeightAdjustJob& Job)
+    {
+        for (FHeightAdjustJob::FOutput& Output : Job.Outputs)
         {
-            return false; // Still processing
+            FPCGTaggedData& TaggedOutput = Context->OutputData.TaggedData.AddDefaulted_GetRef();
+            if (Output.Data)
+            {
+                TaggedOutput.Data = Output.Data.Get();
+                TaggedOutput.Tags = MoveTemp(Output.Tags);
+            }
+            else
+            {
+                TaggedOutput = Context->InputData.TaggedData[Output.PassThroughInput];
+            }
+            TaggedOutput.Pin = PCGPinConstants::DefaultOutputLabel;
         }
+    }
+}
 
-        RunningTasks.Add(TaskId);
-
+FPCGCesiumHeightAdjusterContext::~FPCGCesiumHeightAdjusterContext()
+{
+    // Callbacks still in flight keep the job alive but must not touch this context
+    if (Job.IsValid())
+    {
+        Job->Context = nullptr;
     }
 
+    FTSTicker::GetCoreTicker().RemoveTicker(ReadyPollHandle);
+}
 
-    UObject* SourceComponentObj = Context->SourceComponent.Get();
-    if (!SourceComponentObj)
+FPCGContext* FPCGCesiumHeightAdjusterElement::Initialize(const FPCGDataCollection& InputData, TWeakObjectPtr<UPCGComponent> SourceComponent, const UPCGNode* Node)
+{
+    FPCGCesiumHeightAdjusterContext* Context = new FPCGCesiumHeightAdjusterContext();
+    Context->InputData = InputData;
+    Context->SourceComponent = SourceComponent;
+    Context->Node = Node;
+
+    return Context;
+}
+
+bool FPCGCesiumHeightAdjusterElement::ExecuteInternal(FPCGContext* InContext) const
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FPCGCesiumHeightAdjusterElement::Execute);
+    check(InContext);
+
+    using namespace PCGCesiumHeightAdjuster;
+
+    FPCGCesiumHeightAdjusterContext* Context = static_cast<FPCGCesiumHeightAdjusterContext*>(InContext);
+
+    if (!Context->SourceComponent.IsValid())
+    {
+        UE_LOG(LogTemp, Error, TEXT("Invalid PCG Context or Source Component."));
+        return true;
+    }
+
+    if (const TSharedPtr<FHeightAdjustJob> Job = Context->Job)
     {
-        UE_LOG(LogTemp, Error, TEXT("Null SourceComponent object."));
-        RunningTasks.Remove(TaskId);
-        CompletedTasks.Add(TaskId);
+        if (!Job->IsDone())
+        {
+            // Progress in 10% steps, shown on the node in the PCG debugger and in the output log
+            const int32 Percent = Job->TotalPoints > 0 ? (100 * Job->SampledPoints) / Job->TotalPoints : 100;
+            if (Percent / 10 > Job->ReportedPercent / 10)
+            {
+                Job->ReportedPercent = Percent;
+                PCGE_LOG(Log, GraphAndLog, FText::Format(LOCTEXT("Progress", "Height sampled {0} / {1} points ({2}%)"), Job->SampledPoints, Job->TotalPoints, Percent));
+            }
+
+            // Sleep until the next chunk completes
+            Context->bIsPaused = true;
+            return false;
+        }
+
+        EmitOutputs(Context, *Job);
+
+        UE_LOG(LogTemp, Log, TEXT("Height sampling complete — %d points updated in %d chunks."), Job->TotalPoints, Job->Chunks.Num());
+
+        Job->Context = nullptr;
+        Context->Job.Reset();
         return true;
     }
 
+    const UPCGCesiumHeightAdjusterSettings* Settings = Context->GetInputSettings<UPCGCesiumHeightAdjusterSettings>();
+    check(Settings);
+
+    UObject* SourceComponentObj = Context->SourceComponent.Get();
     UWorld* World = SourceComponentObj->GetWorld();
     ACesiumGeoreference* Georef = ACesiumGeoreference::GetDefaultGeoreference(World);
     ACesium3DTileset* Tileset = nullptr;
@@ -575,202 +752,143 @@ bool FPCGCesiumHeightAdjusterElement::ExecuteInternal(FPCGContext* Context) cons
         break;
     }
 
-    if (!IsValid(Georef) || !IsValid(Tileset) || !Tileset->GetTileset())
+    if (!IsValid(Georef))
     {
-        UE_LOG(LogTemp, Error, TEXT("Missing Cesium Georeference or Tileset."));
-        RunningTasks.Remove(TaskId);
-        CompletedTasks.Add(TaskId);
+        UE_LOG(LogTemp, Error, TEXT("Missing Cesium Georeference."));
         return true;
     }
 
-    Tileset->ResolveGeoreference();
-    Tileset->ResolveCameraManager();
-    Tileset->ResolveCreditSystem();
+    if (IsValid(Tileset))
+    {
+        Tileset->ResolveGeoreference();
+        Tileset->ResolveCameraManager();
+        Tileset->ResolveCreditSystem();
+    }
 
-    Cesium3DTilesSelection::Tileset* NativeTileset = Tileset->GetTileset();
+    TSharedPtr<IPCGHeightProvider> Provider = IPCGHeightProvider::Create(Settings->HeightProvider, World, Tileset);
+    if (!Provider)
+    {
+        return true;
+    }
 
-    if (!NativeTileset->getRootTile() ||
-        NativeTileset->getRootTile()->getState() != Cesium3DTilesSelection::TileLoadState::Done)
+    if (!Provider->IsReady())
     {
-        UE_LOG(LogTemp, Warning, TEXT("Waiting for Cesium root tile to load..."));
-        RunningTasks.Remove(TaskId);
+        const double Now = FPlatformTime::Seconds();
+        if (Context->NotReadySinceSeconds == 0.0)
+        {
+            Context->NotReadySinceSeconds = Now;
+            PCGE_LOG(Log, GraphAndLog, FText::Format(LOCTEXT("WaitingForProvider", "Waiting for {0} to become ready"), FText::FromString(Provider->GetDescription())));
+        }
+        else if (Now - Context->NotReadySinceSeconds > GetDefault<UCustomPCGSettings>()->HeightServiceReadyTimeoutSeconds)
+        {
+            PCGE_LOG(Error, GraphAndLog, FText::Format(LOCTEXT("ProviderTimeout", "{0} was not ready after {1} s"), FText::FromString(Provider->GetDescription()), FText::AsNumber(FMath::RoundToInt(Now - Context->NotReadySinceSeconds))));
+            return true;
+        }
+
+        // Sleep instead of being re-executed every frame; the ticker wakes the context to check again
+        Context->bIsPaused = true;
+        Context->ReadyPollHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateLambda([Context](float)
+            {
+                Context->bIsPaused = false;
+                Context->ReadyPollHandle.Reset();
+                return false;
+            }), 0.25f);
         return false;
     }
 
-    TSharedRef<int32> Remaining = MakeShared<int32>(0);
-    int32 TotalQueued = 0;
+    Context->NotReadySinceSeconds = 0.0;
+
+    const int32 ChunkSize = FMath::Max(Settings->ChunkSize, 1);
 
-    for (const FPCGTaggedData& Input : Context->InputData.TaggedData)
+    TSharedRef<FHeightAdjustJob> Job = MakeShared<FHeightAdjustJob>();
+    Job->Provider = Provider;
+    Job->Georef = Georef;
+    Job->GeoTransform = FGeoreferenceBatchTransform(Georef);
+    Job->MaxChunksInFlight = FMath::Max(Settings->MaxChunksInFlight, 1);
+
+    // Hole rings of the owning polygon actor, if any
+    FPolygonScanlineTable HoleTable;
+    if (const APCGPolygonActor* HoleOwner = Cast<APCGPolygonActor>(Context->SourceComponent->GetOwner()); HoleOwner && HoleOwner->HoleRings.Num() > 0)
     {
+        HoleTable.Build(HoleOwner->HoleRings, HoleOwner->GetActorTransform());
+    }
+
+    for (int32 InputIndex = 0; InputIndex < Context->InputData.TaggedData.Num(); ++InputIndex)
+    {
+        const FPCGTaggedData& Input = Context->InputData.TaggedData[InputIndex];
         const UPCGSpatialData* Spatial = Cast<UPCGSpatialData>(Input.Data);
         const UPCGPointData* PointData = Spatial ? Spatial->ToPointData(Context) : nullptr;
         if (!PointData) continue;
 
         const TArray<FPCGPoint>& Points = PointData->GetPoints();
 
-        //if (Points.Num() > 10000) {
-        //    UE_LOG(LogTemp, Warning, TEXT("Polygon  has points %d , skipping."), Points.Num());
-        //    return true;
-
-        //};
-
-
-        if (Points.IsEmpty()) continue;
-
-        TArray<FPCGPoint> LocalCopy = Points;
-        if (LocalCopy.Num() > 10000)
+        // Nothing to sample: forward the input untouched instead of copying it
+        if (Points.IsEmpty())
         {
-            UObject* OwnerObject = Context->SourceComponent->GetOwner();
-            if (const APCGPolygonActor* PolygonActor = Cast<APCGPolygonActor>(OwnerObject)) {
-                UE_LOG(LogTemp, Warning, TEXT("Skipping Actor: %s Points: %d "), *OwnerObject->GetName(), LocalCopy.Num());
-
-
-
-
+            if (PointData == Input.Data)
+            {
+                Job->Outputs.AddDefaulted_GetRef().PassThroughInput = InputIndex;
             }
             continue;
         }
 
+        const int32 OutputIndex = Job->Outputs.Num();
+        FHeightAdjustJob::FOutput& Output = Job->Outputs.AddDefaulted_GetRef();
+        Output.Tags = Input.Tags;
+        Output.Data.Reset(NewObject<UPCGPointData>(Context->SourceComponent.Get()));
+        Output.Data->InitializeFromData(PointData);
 
-        std::vector<CesiumGeospatial::Cartographic> CesiumCoords;
-        CesiumCoords.reserve(LocalCopy.Num());
-
-        for (const FPCGPoint& Pt : LocalCopy)
+        // The one copy of each point: straight into the output, skipping points inside holes
+        TArray<FPCGPoint>& OutPoints = Output.Data->GetMutablePoints();
+        if (HoleTable.IsEmpty())
         {
-            FVector LLH = Georef->TransformUnrealPositionToLongitudeLatitudeHeight(Pt.Transform.GetLocation());
-            CesiumCoords.emplace_back(
-                CesiumUtility::Math::degreesToRadians(LLH.X),
-                CesiumUtility::Math::degreesToRadians(LLH.Y),
-                0.0);
+            OutPoints = Points;
         }
-
-        UPCGPointData* OutputData = NewObject<UPCGPointData>(SourceComponentObj);
-        check(OutputData);
-
-        TWeakObjectPtr<UPCGPointData> WeakOutputData(OutputData);
-        TWeakObjectPtr<UObject> WeakSourceComponent(SourceComponentObj);
-        TWeakObjectPtr<ACesiumGeoreference> WeakGeoref(Georef);
-
-        (*Remaining)++;
-        TotalQueued += Points.Num();
-
-
-
-        NativeTileset->sampleHeightMostDetailed(CesiumCoords).thenInMainThread(
-            [LocalCopy, WeakOutputData, WeakGeoref, WeakSourceComponent, Remaining, TaskId, Tags = Input.Tags, Context](const Cesium3DTilesSelection::SampleHeightResult& Result) mutable
-            {
-                if (!WeakOutputData.IsValid() || !WeakGeoref.IsValid() || !WeakSourceComponent.IsValid())
-                {
-                    UE_LOG(LogTemp, Warning, TEXT("Async callback skipped due to invalid references."));
-
-                    if (--(*Remaining) == 0)
-                    {
-                        AsyncTask(ENamedThreads::GameThread, [TaskId]()
-                            {
-                                UE_LOG(LogTemp, Warning, TEXT("Finalizing Cesium PCG task after skipped callbacks."));
-                                RunningTasks.Remove(TaskId);
-                                CompletedTasks.Add(TaskId);
-                            });
-                    }
-                    return;
-                }
-
-                ACesiumGeoreference* Georef = WeakGeoref.Get();
-                UPCGPointData* OutputData = WeakOutputData.Get();
-
-                const int32 NumRequested = LocalCopy.Num();
-                const int32 NumReturned = static_cast<int32>(Result.sampleSuccess.size());
-
-                if (NumReturned != NumRequested || Result.positions.size() != NumRequested)
-                {
-                    UE_LOG(LogTemp, Error, TEXT("Mismatch in sample result count: Expected %d, Got %d."), NumRequested, NumReturned);
-
-                    if (--(*Remaining) == 0)
-                    {
-                        AsyncTask(ENamedThreads::GameThread, [TaskId]()
-                            {
-                                RunningTasks.Remove(TaskId);
-                                CompletedTasks.Add(TaskId);
-                            });
-                    }
-                    return;
-                }
-
-
-                
-                TArray<FPCGPoint> UpdatedPoints;
-                UpdatedPoints.Reserve(NumRequested);
-
-                for (int32 i = 0; i < NumRequested; ++i)
+        else
+        {
+            TArray<bool> Keep;
+            Keep.SetNumUninitialized(Points.Num());
+            ParallelForSlices(Points.Num(), [&Points, &HoleTable, &Keep](int32 Start, int32 Num)
                 {
-                    FPCGPoint P = LocalCopy[i];
-
-                    if (Result.sampleSuccess[i])
+                    for (int32 i = Start; i < Start + Num; ++i)
                     {
-                        const auto& Carto = Result.positions[i];
-                        FVector LLH(
-                            FMath::RadiansToDegrees(Carto.longitude),
-                            FMath::RadiansToDegrees(Carto.latitude),
-                            Carto.height);
-
-                        P.Transform.SetLocation(Georef->TransformLongitudeLatitudeHeightPositionToUnreal(LLH));
+                        Keep[i] = !HoleTable.Contains(Points[i].Transform.GetLocation());
                     }
+                });
 
-                    UpdatedPoints.Add(P);
-                }
-
-                OutputData->GetMutablePoints() = MoveTemp(UpdatedPoints);
-
-                if (--(*Remaining) == 0)
+            OutPoints.Reserve(Points.Num());
+            for (int32 i = 0; i < Points.Num(); ++i)
+            {
+                if (Keep[i])
                 {
-                    AsyncTask(ENamedThreads::GameThread, [Context, OutputData, Tags, TaskId]()
-                        {
-                            if (!Context || !Context->SourceComponent.IsValid())
-                            {
-                                UE_LOG(LogTemp, Warning, TEXT("Context invalid or destroyed when writing output."));
-                                RunningTasks.Remove(TaskId);
-                                CompletedTasks.Add(TaskId);
-                                return;
-                            }
-
-                            FPCGTaggedData& Output = Context->OutputData.TaggedData.AddDefaulted_GetRef();
-                            Output.Data = OutputData;
-                            Output.Tags = Tags;
-
-                            int32 NumUpdatePoints = OutputData->GetPoints().Num();
-
-
-
-                            UE_LOG(LogTemp, Log, TEXT("Cesium async complete — %d points updated."), NumUpdatePoints);
-
-                            RunningTasks.Remove(TaskId);
-                            CompletedTasks.Add(TaskId);
-                        });
+                    OutPoints.Add(Points[i]);
                 }
+            }
+        }
 
+        for (int32 Start = 0; Start < OutPoints.Num(); Start += ChunkSize)
+        {
+            Job->Chunks.Add({ OutputIndex, Start, FMath::Min(ChunkSize, OutPoints.Num() - Start) });
+        }
 
-            });
-
-
-
-
+        Job->TotalPoints += OutPoints.Num();
     }
 
-    if (TotalQueued == 0) {
-
-        RunningTasks.Remove(TaskId);
-        CompletedTasks.Add(TaskId);
-
-        RunningTasks.Empty();
-        CompletedTasks.Empty();
-
+    if (Job->TotalPoints == 0)
+    {
+        EmitOutputs(Context, *Job);
         return true;
-
     }
 
+    Job->Context = Context;
+    Context->Job = Job;
+    IssueChunks(Job);
+
+    UE_LOG(LogTemp, Log, TEXT("PCG async height sampling (%s) started for %d points in %d chunks."), *Provider->GetDescription(), Job->TotalPoints, Job->Chunks.Num());
 
-    UE_LOG(LogTemp, Log, TEXT("Cesium PCG async sampling started for %d points."), TotalQueued);
-    return false; // Async in progress
+    // Fully cached inputs may already be done; otherwise sleep until a chunk completes
+    Context->bIsPaused = !Job->IsDone();
+    return false;
 }
 
 
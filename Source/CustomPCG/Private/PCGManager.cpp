@@ -5,9 +5,14 @@
 #include "PCGPolygonContent.h"
 #include "FShapeFileReader.h"
 #include "Engine/World.h" 
+#include "CustomPCGSettings.h"
+#include "Async/Async.h"
 #include <GridStreamingManager.h>
 #include <PcgSQLiteSubsystem.h>
 
+// Parsed features and GDAL's copy of the attributes take a few times the on-disk size
+static constexpr int64 IngestBytesPerFileByte = 4;
+
 void APCGManager::InitializeDatabase()
 {
     // DB file path
@@ -79,6 +84,11 @@ void APCGManager::InitializeDatabase()
     }
 
 
+    if (!DB.Execute(*APCGPolygonContent::GetCreatePolygonHolesTableSQL()))
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to create PolygonHoles table"));
+    }
+
     // --- 3. Create table for shapefile metadata (last modified timestamps) ---
     FString CreateMetadataTableSQL = TEXT(R"(
         CREATE TABLE IF NOT EXISTS ShapefileMetadata (
@@ -182,7 +192,9 @@ void APCGManager::BeginPlay()
 
         DBSubsystem->Execute(CreatePointsTableSQL);
         DBSubsystem->Execute(CreateFeaturesTableSQL);
+        DBSubsystem->Execute(APCGPolygonContent::GetCreatePolygonHolesTableSQL());
         DBSubsystem->Execute(CreateMetadataTableSQL);
+        APCGPointContent::CreatePointCacheTables(DBSubsystem);
 
         UE_LOG(LogTemp, Log, TEXT("APCGManager: Database initialized (via subsystem)"));
     }
@@ -214,22 +226,26 @@ void APCGManager::LoadDataforPCGPoint()
         return;
     }
 
+    UPcgSQLiteSubsystem* SQLite = GetGameInstance() ? GetGameInstance()->GetSubsystem<UPcgSQLiteSubsystem>() : nullptr;
+
     for (const FString& ShapefilePath : ShapefilePaths)
     {
-        UE_LOG(LogTemp, Log, TEXT(" Loading shapefile: %s"), *ShapefilePath);
-
-        FShapeRawData RawData = FShapeFileReader::ReadShapefileRawData(ShapefilePath);
-
-        APCGPointContent* PointContent = NewObject<APCGPointContent>(this, APCGPointContent::StaticClass());
-        if (!PointContent)
+        // Unchanged files go straight from the instance cache to instanced components
+        const FPointCacheKey CacheKey = FPointCacheKey::Make(ShapefilePath, GetWorld());
+        if (APCGPointContent::IsPointCacheValid(SQLite, CacheKey))
         {
-            UE_LOG(LogTemp, Error, TEXT("Failed to create APCGPointContent for file: %s"), *ShapefilePath);
+            UE_LOG(LogTemp, Log, TEXT(" Loading cached shapefile: %s"), *ShapefilePath);
+
+            APCGPointContent* PointContent = NewObject<APCGPointContent>(this, APCGPointContent::StaticClass());
+            PointContent->SpawnPCGPointDataFromCache(CacheKey);
             continue;
         }
 
-        PointContent->InitializePCGPointData(RawData);
-        PointContent->SpawnPCGPointData();
+        UE_LOG(LogTemp, Log, TEXT(" Loading shapefile: %s"), *ShapefilePath);
+        QueueShapefileIngest(ShapefilePath, EShapefileIngestKind::Point, 0);
     }
+
+    StartPendingIngestJobs();
 }
 
 void APCGManager::LoadDataforPCGPolygon()
@@ -278,6 +294,7 @@ void APCGManager::LoadDataforPCGPolygon()
             SQLite->ExecuteWithCallback(DeletePointsSQL, [](const FSQLitePreparedStatement&) { return ESQLitePreparedStatementExecuteRowResult::Continue; });
             SQLite->ExecuteWithCallback(DeleteMetaSQL, [](const FSQLitePreparedStatement&) { return ESQLitePreparedStatementExecuteRowResult::Continue; });
             SQLite->ExecuteWithCallback(DeleteFeaturesSQL, [](const FSQLitePreparedStatement&) { return ESQLitePreparedStatementExecuteRowResult::Continue; });
+            APCGPolygonContent::DeletePolygonHoles(SQLite, DBFile);
 
             UE_LOG(LogTemp, Log, TEXT("Deleted DB entries for removed shapefile: %s"), *DBFile);
         }
@@ -308,13 +325,21 @@ void APCGManager::LoadDataforPCGPolygon()
                 {
                     const FString DeletePointsSQL = FString::Printf(TEXT("DELETE FROM PolygonPoints WHERE ShapefileID='%s';"), *ShapefileName);
                     SQLite->ExecuteWithCallback(DeletePointsSQL, [](const FSQLitePreparedStatement&) { return ESQLitePreparedStatementExecuteRowResult::Continue; });
+                    APCGPolygonContent::DeletePolygonHoles(SQLite, ShapefileName);
                     UE_LOG(LogTemp, Log, TEXT("Deleted old DB points for modified shapefile: %s"), *ShapefileName);
                 }
 
                 return ESQLitePreparedStatementExecuteRowResult::Continue;
             });
 
-        // --- Spawn and process polygon content ---
+        if (bNeedsGeneration)
+        {
+            // Read and parsed on the thread pool, spawned in SpawnIngestedShapefile
+            QueueShapefileIngest(ShapefilePath, EShapefileIngestKind::Polygon, FileTimestamp);
+            continue;
+        }
+
+        // --- Spawn polygon content from the database ---
         FActorSpawnParameters Params;
         Params.Owner = this;
         APCGPolygonContent* PolygonContent = GetWorld()->SpawnActor<APCGPolygonContent>(
@@ -323,29 +348,162 @@ void APCGManager::LoadDataforPCGPolygon()
             FRotator::ZeroRotator,
             Params);
 
-        if (bNeedsGeneration)
+        PolygonContent->InitializeContent();
+        PolygonContent->SpawnHiGenActorsFromDatabase(ShapefileName);
+    }
+
+    StartPendingIngestJobs();
+}
+
+void APCGManager::QueueShapefileIngest(const FString& Path, EShapefileIngestKind Kind, int64 FileTimestamp)
+{
+    TSharedRef<FShapefileIngestJob> Job = MakeShared<FShapefileIngestJob>();
+    Job->Path = Path;
+    Job->Kind = Kind;
+    Job->FileTimestamp = FileTimestamp;
+    Job->QueuedSeconds = FPlatformTime::Seconds();
+
+    // Geometry and attributes dominate; the index and projection files are negligible
+    const int64 ShpBytes = FMath::Max<int64>(IFileManager::Get().FileSize(*Path), 0);
+    const int64 DbfBytes = FMath::Max<int64>(IFileManager::Get().FileSize(*FPaths::ChangeExtension(Path, TEXT("dbf"))), 0);
+    Job->EstimatedBytes = (ShpBytes + DbfBytes) * IngestBytesPerFileByte;
+
+    if (PendingIngestJobs.Num() == 0 && IngestJobsInFlight == 0)
+    {
+        IngestStartSeconds = Job->QueuedSeconds;
+        CompletedIngestJobs.Reset();
+    }
+
+    PendingIngestJobs.Add(Job);
+}
+
+void APCGManager::StartPendingIngestJobs()
+{
+    const int64 BudgetBytes = int64(FMath::Max(GetDefault<UCustomPCGSettings>()->ShapefileIngestMemoryBudgetMB, 1)) * 1024 * 1024;
+
+    while (PendingIngestJobs.Num() > 0)
+    {
+        TSharedRef<FShapefileIngestJob> Job = PendingIngestJobs[0];
+        if (IngestJobsInFlight > 0 && IngestBytesInFlight + Job->EstimatedBytes > BudgetBytes)
         {
-            // Read shapefile raw data
-            FShapeRawData RawData = FShapeFileReader::ReadShapefileRawData(ShapefilePath);
+            break;
+        }
 
-            // Insert/Update metadata
-            const FString UpdateMetaSQL = FString::Printf(
-                TEXT("INSERT OR REPLACE INTO ShapefileMetadata (ShapefileID, LastModified) VALUES ('%s', %lld);"),
-                *ShapefileName, FileTimestamp);
+        PendingIngestJobs.RemoveAt(0);
+        IngestJobsInFlight++;
+        IngestBytesInFlight += Job->EstimatedBytes;
 
-            SQLite->ExecuteWithCallback(UpdateMetaSQL, [](const FSQLitePreparedStatement&) { return ESQLitePreparedStatementExecuteRowResult::Continue; });
+        TWeakObjectPtr<APCGManager> WeakThis(this);
+
+        Async(EAsyncExecution::ThreadPool, [WeakThis, Job]()
+            {
+                TRACE_CPUPROFILER_EVENT_SCOPE(APCGManager::IngestShapefile);
+
+                Job->ReadStartSeconds = FPlatformTime::Seconds();
+                FShapeRawData RawData = FShapeFileReader::ReadShapefileRawData(Job->Path);
+                Job->ReadEndSeconds = FPlatformTime::Seconds();
 
-            // Initialize polygon data and spawn
-            PolygonContent->InitializeContent();
-            PolygonContent->InitializePCGPolygonData(RawData);
-           // PolygonContent->InsertPolygonsFeaturesToDB(RawData.CollectionName);
-            PolygonContent->SpawnPCGPolygonData();
+                Job->NumFeatures = RawData.Attributes.Num();
+                if (Job->Kind == EShapefileIngestKind::Point)
+                {
+                    APCGPointContent::ParsePointData(RawData, Job->Points);
+                }
+                else
+                {
+                    APCGPolygonContent::ParsePolygonData(RawData, Job->Polygons);
+                }
+                Job->ParseEndSeconds = FPlatformTime::Seconds();
+
+                AsyncTask(ENamedThreads::GameThread, [WeakThis, Job]()
+                    {
+                        APCGManager* This = WeakThis.Get();
+                        if (!This) return;
+
+                        This->SpawnIngestedShapefile(Job);
+
+                        This->IngestJobsInFlight--;
+                        This->IngestBytesInFlight -= Job->EstimatedBytes;
+                        This->CompletedIngestJobs.Add(Job);
+
+                        This->StartPendingIngestJobs();
+                        if (This->IngestJobsInFlight == 0 && This->PendingIngestJobs.Num() == 0)
+                        {
+                            This->LogIngestTimeline();
+                        }
+                    });
+            });
+    }
+}
+
+void APCGManager::SpawnIngestedShapefile(const TSharedRef<FShapefileIngestJob>& Job)
+{
+    Job->SpawnStartSeconds = FPlatformTime::Seconds();
+
+    if (Job->Kind == EShapefileIngestKind::Point)
+    {
+        APCGPointContent* PointContent = NewObject<APCGPointContent>(this, APCGPointContent::StaticClass());
+        if (!PointContent)
+        {
+            UE_LOG(LogTemp, Error, TEXT("Failed to create APCGPointContent for file: %s"), *Job->Path);
         }
         else
         {
-            PolygonContent->InitializeContent();
-            PolygonContent->SpawnHiGenActorsFromDatabase(ShapefileName);
+            PointContent->CacheKey = FPointCacheKey::Make(Job->Path, GetWorld());
+            PointContent->InitializePCGPointData(MoveTemp(Job->Points));
+            PointContent->SpawnPCGPointData();
+        }
+    }
+    else
+    {
+        UPcgSQLiteSubsystem* SQLite = GetGameInstance() ? GetGameInstance()->GetSubsystem<UPcgSQLiteSubsystem>() : nullptr;
+        if (SQLite)
+        {
+            // Insert/Update metadata
+            const FString UpdateMetaSQL = FString::Printf(
+                TEXT("INSERT OR REPLACE INTO ShapefileMetadata (ShapefileID, LastModified) VALUES ('%s', %lld);"),
+                *FPaths::GetBaseFilename(Job->Path), Job->FileTimestamp);
+
+            SQLite->ExecuteWithCallback(UpdateMetaSQL, [](const FSQLitePreparedStatement&) { return ESQLitePreparedStatementExecuteRowResult::Continue; });
         }
+
+        FActorSpawnParameters Params;
+        Params.Owner = this;
+        APCGPolygonContent* PolygonContent = GetWorld()->SpawnActor<APCGPolygonContent>(
+            APCGPolygonContent::StaticClass(),
+            FVector::ZeroVector,
+            FRotator::ZeroRotator,
+            Params);
+
+        // Initialize polygon data and spawn
+        PolygonContent->InitializeContent();
+        PolygonContent->InitializePCGPolygonData(MoveTemp(Job->Polygons));
+        PolygonContent->SpawnPCGPolygonData();
+    }
+
+    // Parsed data now lives in the content
+    Job->Points = FPointFeatureDataset();
+    Job->Polygons.Empty();
+    Job->SpawnEndSeconds = FPlatformTime::Seconds();
+}
+
+void APCGManager::LogIngestTimeline() const
+{
+    auto Ms = [this](double Seconds) { return (Seconds - IngestStartSeconds) * 1000.0; };
+
+    UE_LOG(LogTemp, Log, TEXT("Shapefile ingestion timeline (ms from start; read, parse and spawn phases):"));
+    for (const TSharedRef<FShapefileIngestJob>& Job : CompletedIngestJobs)
+    {
+        UE_LOG(LogTemp, Log, TEXT("  %-32s %-7s %8d features %7.1f MB  read %8.1f-%8.1f  parse -%8.1f  spawn %8.1f-%8.1f"),
+            *FPaths::GetBaseFilename(Job->Path),
+            Job->Kind == EShapefileIngestKind::Point ? TEXT("point") : TEXT("polygon"),
+            Job->NumFeatures,
+            Job->EstimatedBytes / IngestBytesPerFileByte / (1024.0 * 1024.0),
+            Ms(Job->ReadStartSeconds), Ms(Job->ReadEndSeconds),
+            Ms(Job->ParseEndSeconds),
+            Ms(Job->SpawnStartSeconds), Ms(Job->SpawnEndSeconds));
     }
+
+    const double LastEnd = CompletedIngestJobs.Num() > 0 ? CompletedIngestJobs.Last()->SpawnEndSeconds : IngestStartSeconds;
+    UE_LOG(LogTemp, Log, TEXT("  %d shapefiles in %.1f ms"), CompletedIngestJobs.Num(), Ms(LastEnd));
 }
 
@@ -1,4 +1,21 @@
 ﻿#include "PCGPointContent.h" 
+#include "CustomPCGSettings.h"
+#include "TerrainHeightCacheSubsystem.h"
+#include "GeoreferenceBatchTransform.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/BlueprintGeneratedClass.h"
+#include "Engine/SimpleConstructionScript.h"
+#include "Engine/SCS_Node.h"
+#include "Async/ParallelFor.h"
+#include "Async/Async.h"
+#include "Misc/Crc.h"
+#include "Misc/ScopeLock.h"
+#include "PcgSQLiteSubsystem.h"
+#include "HAL/FileManager.h"
+#include "GridStreamingManager.h"
+#include "FeatureCustomData.h"
+#include "InstanceBuilderSubsystem.h"
 
 
 int32 APCGPointContent::TotalPointDataPoints = 0;
@@ -6,6 +23,9 @@ int32 APCGPointContent::ExpectedTotalPoints = 0;
 FDateTime APCGPointContent::StartTime = FDateTime::UtcNow();
 bool APCGPointContent::bTimerStarted = false;
 
+// Shared by every point content for the session; a null mesh is cached too, for classes without one
+static TMap<TWeakObjectPtr<UClass>, TWeakObjectPtr<UStaticMesh>> ExtractedMeshPerClass;
+
 APCGPointContent::APCGPointContent()
 {
 
@@ -17,120 +37,314 @@ void APCGPointContent::InitializeContent()
     CesiumGeoreference = ACesiumGeoreference::GetDefaultGeoreference(GetWorld());
     Tileset = Cast<ACesium3DTileset>(UGameplayStatics::GetActorOfClass(GetWorld(), ACesium3DTileset::StaticClass()));
 
-    const FString RegistryPath = TEXT("/Game/PCGData/PointDataAssets/BP_Registry.BP_Registry");
+    BlueprintRegistry = LoadBlueprintRegistry();
+    if (BlueprintRegistry)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Successfully loaded BP_Registry asset."));
+    }
+
+    BuildModelIndex();
 
 
-    UBlueprintRegistery* LoadedRegistry = Cast<UBlueprintRegistery>(
-        StaticLoadObject(UBlueprintRegistery::StaticClass(), nullptr, *RegistryPath)
-    );
+}
+
+void APCGPointContent::InitializePCGPointData(const FShapeRawData& Raw)
+{
+    InitializeContent();
+    ParsePointData(Raw, PointData);
+    HashCustomDataStrings();
+}
 
+void APCGPointContent::InitializePCGPointData(FPointFeatureDataset&& Points)
+{
+    InitializeContent();
+    PointData = MoveTemp(Points);
+    HashCustomDataStrings();
+}
 
-    if (LoadedRegistry)
+void APCGPointContent::HashCustomDataStrings()
+{
+    StringCustomData.Reset();
+    if (GetDefault<UCustomPCGSettings>()->PointInstanceCustomData.Num() > 0)
     {
-        BlueprintRegistry = LoadedRegistry;
-        UE_LOG(LogTemp, Warning, TEXT("Successfully loaded BP_Registry asset."));
+        StringCustomData = FFeatureCustomData::HashStrings(PointData.Strings);
     }
-    else
+}
+
+void APCGPointContent::ParsePointData(const FShapeRawData& Raw, FPointFeatureDataset& OutPoints)
+{
+    OutPoints.FileName = Raw.CollectionName;
+    OutPoints.Features.Reserve(OutPoints.Features.Num() + Raw.Attributes.Num());
+
+    for (int32 i = 0; i < Raw.Attributes.Num(); ++i)
     {
-        UE_LOG(LogTemp, Error, TEXT("Failed to load BP_Registry from path: %s"), *RegistryPath);
+        const auto& A = Raw.Attributes[i];
+
+        auto GetSafeString = [&](const FString& key) -> int32 {
+            const FString* Value = A.Find(key);
+            return Value ? OutPoints.Strings.Intern(*Value) : 0;
+            };
+
+        auto GetSafeInt = [&](const FString& key) -> int32 {
+            const FString* Value = A.Find(key);
+            return Value ? FCString::Atoi(**Value) : 0;
+            };
+
+        auto GetSafeFloat = [&](const FString& key) -> float {
+            const FString* Value = A.Find(key);
+            return Value ? FCString::Atof(**Value) : 0.0f;
+            };
+
+        FPointFeature& temp = OutPoints.Features.AddDefaulted_GetRef();
+        temp.Id = GetSafeInt("id");
+        temp.Name = GetSafeString("Name");
+        temp.Lat = GetSafeFloat("lat");
+        temp.Long = GetSafeFloat("long");
+        temp.Elev = GetSafeFloat("Elev");
+        temp.Height = GetSafeFloat("Height");
+        temp.Scale = GetSafeFloat("Scale");
+        temp.Rotation = GetSafeFloat("Rotation");
+        temp.Code = GetSafeString("code");
+        temp.Model = GetSafeString("Model");
+        temp.State = GetSafeString("State");
+        temp.Altitude = GetSafeFloat("Altitude");
+        temp.KindID = GetSafeInt("KindID");
+        temp.KindDesc = GetSafeString("KindDesc");
+        temp.DomainID = GetSafeInt("DomainID");
+        temp.DomainDesc = GetSafeString("DomainDesc");
+        temp.CountryID = GetSafeInt("CountryID");
+        temp.CountryDes = GetSafeString("CountryDes");
+        temp.CategoryID = GetSafeInt("CategoryID");
+        temp.CategoryDe = GetSafeString("CategoryDe");
+        temp.SubCategID = GetSafeInt("SubCategID");
+        temp.SubCategDe = GetSafeString("SubCategDe");
+        temp.SpecificID = GetSafeInt("SpecificID");
+        temp.SpecificDe = GetSafeString("SpecificDe");
+        temp.EntityEnum = GetSafeString("EntityEnum");
+        temp.Location = Raw.Geometries[i].IsValidIndex(0) ? Raw.Geometries[i][0] : FVector::ZeroVector;
     }
 
+    OutPoints.LogMemoryUsage();
+}
 
+FVegetationPointData FPointFeatureDataset::Expand(int32 Index) const
+{
+    const FPointFeature& Feature = Features[Index];
+
+    FVegetationPointData Data;
+    Data.Id = Feature.Id;
+    Data.Name = Strings.Get(Feature.Name);
+    Data.Lat = Feature.Lat;
+    Data.Long = Feature.Long;
+    Data.Elev = Feature.Elev;
+    Data.Height = Feature.Height;
+    Data.Scale = Feature.Scale;
+    Data.Rotation = Feature.Rotation;
+    Data.Code = Strings.Get(Feature.Code);
+    Data.Model = Strings.Get(Feature.Model);
+    Data.State = Strings.Get(Feature.State);
+    Data.Altitude = Feature.Altitude;
+    Data.KindID = Feature.KindID;
+    Data.KindDesc = Strings.Get(Feature.KindDesc);
+    Data.DomainID = Feature.DomainID;
+    Data.DomainDesc = Strings.Get(Feature.DomainDesc);
+    Data.CountryID = Feature.CountryID;
+    Data.CountryDes = Strings.Get(Feature.CountryDes);
+    Data.CategoryID = Feature.CategoryID;
+    Data.CategoryDe = Strings.Get(Feature.CategoryDe);
+    Data.SubCategID = Feature.SubCategID;
+    Data.SubCategDe = Strings.Get(Feature.SubCategDe);
+    Data.SpecificID = Feature.SpecificID;
+    Data.SpecificDe = Strings.Get(Feature.SpecificDe);
+    Data.EntityEnum = Strings.Get(Feature.EntityEnum);
+    Data.Location = Feature.Location;
+    Data.FileName = FileName;
+    return Data;
 }
 
-void APCGPointContent::InitializePCGPointData(const FShapeRawData& Raw)
+void FPointFeatureDataset::LogMemoryUsage() const
 {
+    if (Features.Num() == 0) return;
 
+    // What the same features cost as FVegetationPointData: the struct plus a heap copy of every string
+    SIZE_T ExpandedBytes = Features.Num() * (sizeof(FVegetationPointData) + FileName.GetAllocatedSize());
+    for (const FPointFeature& Feature : Features)
+    {
+        for (const int32 String : { Feature.Name, Feature.Code, Feature.Model, Feature.State, Feature.KindDesc, Feature.DomainDesc,
+            Feature.CountryDes, Feature.CategoryDe, Feature.SubCategDe, Feature.SpecificDe, Feature.EntityEnum })
+        {
+            ExpandedBytes += Strings.Get(String).GetAllocatedSize();
+        }
+    }
 
-    InitializeContent();
-    for (int32 i = 0; i < Raw.Attributes.Num(); ++i)
+    const SIZE_T CompactBytes = Features.GetAllocatedSize() + Strings.GetAllocatedSize() + FileName.GetAllocatedSize();
+
+    UE_LOG(LogTemp, Log, TEXT("Point features of %s: %d features, %d unique strings, %.1f bytes/feature (%.1f MB) vs %.1f bytes/feature (%.1f MB) as FVegetationPointData."),
+        *FileName, Features.Num(), Strings.Num(),
+        double(CompactBytes) / Features.Num(), CompactBytes / (1024.0 * 1024.0),
+        double(ExpandedBytes) / Features.Num(), ExpandedBytes / (1024.0 * 1024.0));
+}
+
+UBlueprintRegistery* APCGPointContent::LoadBlueprintRegistry()
+{
+    const TSoftObjectPtr<UBlueprintRegistery>& RegistryPath = GetDefault<UCustomPCGSettings>()->PointModelRegistry;
+
+    UBlueprintRegistery* LoadedRegistry = RegistryPath.LoadSynchronous();
+
+    if (!LoadedRegistry)
     {
+        UE_LOG(LogTemp, Error, TEXT("Failed to load BP_Registry from path: %s"), *RegistryPath.ToString());
+    }
+    return LoadedRegistry;
+}
 
+uint32 APCGPointContent::HashModelRegistry(const UBlueprintRegistery* Registry)
+{
+    if (!Registry) return 0;
 
-        const auto& A = Raw.Attributes[i];
+    // In registry order, since that order decides which entry a duplicated model name resolves to
+    uint32 Hash = 0;
+    for (const TSoftClassPtr<AActor>& SoftBP : Registry->BlueprintClasses)
+    {
+        Hash = FCrc::StrCrc32(*SoftBP.ToSoftObjectPath().ToString(), Hash);
+    }
+    return Hash;
+}
 
-        auto GetSafeString = [&](const FString& key) ->FString {
-            return A.Contains(key) ? A[key] : TEXT("");
-            };
+FString APCGPointContent::NormalizeModelName(const FString& Model)
+{
+    return Model.Replace(TEXT(" "), TEXT("")).ToLower();
+}
 
+void APCGPointContent::BuildModelIndex()
+{
+    ModelIndex.Reset();
+    ModelClasses.Reset();
+    MissingModels.Reset();
 
-        auto GetSafeInt = [&](const FString& key) -> int32 {
-            return A.Contains(key) ? FCString::Atoi(*A[key]) : 0;
+    if (!BlueprintRegistry) return;
 
-            };
+    for (const TSoftClassPtr<AActor>& SoftBP : BlueprintRegistry->BlueprintClasses)
+    {
+        FString AssetName = SoftBP.GetAssetName().ToLower();
+        AssetName.RemoveFromEnd(TEXT("_c")); // remove _C suffix if present
 
+        if (!AssetName.RemoveFromStart(TEXT("pd_"))) continue;
 
-        auto GetSafeFloat = [&](const FString& key) -> float {
-            return A.Contains(key) ? FCString::Atof(*A[key]) : 0.0f;
+        // The linear registry scan this replaces matched the first entry, so later duplicates are ignored
+        if (const TSoftClassPtr<AActor>* Existing = ModelIndex.Find(AssetName))
+        {
+            UE_LOG(LogTemp, Warning, TEXT("BP_Registry: %s and %s both map to model '%s'; using the first."),
+                *Existing->ToString(), *SoftBP.ToString(), *AssetName);
+            continue;
+        }
+        ModelIndex.Add(AssetName, SoftBP);
+    }
 
-            };
+    UE_LOG(LogTemp, Log, TEXT("Indexed %d point models from BP_Registry."), ModelIndex.Num());
+}
+
+TSubclassOf<AActor> APCGPointContent::FindModelClass(const FString& CleanedName)
+{
+    if (const TSubclassOf<AActor>* Found = ModelClasses.Find(CleanedName))
+    {
+        return *Found;
+    }
+
+    if (MissingModels.Contains(CleanedName)) return nullptr;
+
+    // Normally resolved by the async load in SpawnPCGPointData; this is the fallback for late arrivals
+    const TSoftClassPtr<AActor>* SoftBP = ModelIndex.Find(CleanedName);
+    TSubclassOf<AActor> MatchedBPClass = SoftBP ? SoftBP->LoadSynchronous() : nullptr;
+    if (!MatchedBPClass)
+    {
+        UE_LOG(LogTemp, Error, TEXT("No blueprint found in registry for model: %s"), *CleanedName);
+        MissingModels.Add(CleanedName);
+        return nullptr;
+    }
 
+    ModelClasses.Add(CleanedName, MatchedBPClass);
+    return MatchedBPClass;
+}
 
-        FVegetationPointData temp;
-        //temp.Id = FCString::Atoi(*A["id"]);
-        //temp.Name = A["Name"];
-        //temp.Lat = FCString::Atof(*A["lat"]);
-        //temp.Long = FCString::Atof(*A["long"]);
-        //temp.Elev = FCString::Atof(*A["Elev"]);
-        //temp.Height = FCString::Atof(*A["Height"]);
-        //temp.Scale = FCString::Atof(*A["Scale"]);
-        //temp.Rotation = FCString::Atof(*A["Rotation"]);
-        //temp.Code = A["code"];
-        //temp.Model = A["Model"];
-        //temp.FileName = Raw.CollectionName;
-        // temp.State = A["State"];
-        // temp.Altitude = FCString::Atof(*A["Altitude"]);
-        // temp.KindID = FCString::Atoi(*A["KindID"]);
-        // temp.KindDesc = A["KindDesc"];
-        // temp.DomainID = FCString::Atoi(*A["DomainID"]);
-        // temp.DomainDesc = A["DomainDesc"];
-        // temp.CountryID = FCString::Atoi(*A["CountryID"]);
-        // temp.CountryDes = A["CountryDes"];
-        // temp.CategoryID = FCString::Atoi(*A["CategoryID"]);
-        // temp.CategoryDe = A["CategoryDe"];
-        // temp.SubCategID = FCString::Atoi(*A["SubCategID"]);
-        // temp.SubCategDe = A["SubCategDe"];
-        // temp.SpecificID = FCString::Atoi(*A["SpecificID"]);
-        // temp.SpecificDe = A["SpecificDe"];
-        //  temp.EntityEnum = A.Contains("EntityEnum") ? A["EntityEnum"] : TEXT("");
-        //  temp.Location = Raw.Geometries[i].IsValidIndex(0) ? Raw.Geometries[i][0] : FVector::ZeroVector;
-
-
-
-          temp.Id = GetSafeInt("id");
-          temp.Name = A["Name"];
-          temp.Lat = GetSafeFloat("lat");
-          temp.Long = GetSafeFloat("long");
-          temp.Elev = GetSafeFloat("Elev");
-          temp.Height = GetSafeFloat("Height");
-          temp.Scale = GetSafeFloat("Scale");
-          temp.Rotation = GetSafeFloat("Rotation");
-          temp.Code = GetSafeString("code");
-          temp.Model = GetSafeString("Model");
-          temp.FileName = Raw.CollectionName;
-          temp.State = GetSafeString("State");
-          temp.Altitude = GetSafeFloat("Altitude");
-          temp.KindID = GetSafeInt("KindID");
-          temp.KindDesc = GetSafeString("KindDesc");
-          temp.DomainID = GetSafeInt("DomainID");
-          temp.DomainDesc = GetSafeString("DomainDesc");
-          temp.CountryID = GetSafeInt("CountryID");
-          temp.CountryDes = GetSafeString("CountryDes");
-          temp.CategoryID = GetSafeInt("CategoryID");
-          temp.CategoryDe = GetSafeString("CategoryDe");
-          temp.SubCategID = GetSafeInt("SubCategID");
-          temp.SubCategDe = GetSafeString("SubCategDe");
-          temp.SpecificID = GetSafeInt("SpecificID");
-          temp.SpecificDe = GetSafeString("SpecificDe");
-          temp.EntityEnum = A.Contains("EntityEnum") ? A["EntityEnum"] : TEXT("");
-          temp.Location = Raw.Geometries[i].IsValidIndex(0) ? Raw.Geometries[i][0] : FVector::ZeroVector;
-          PointDataList.Add(temp);
+UStaticMesh* APCGPointContent::FindModelMesh(const FString& CleanedName)
+{
+    if (UStaticMesh* Found = StaticMeshesPerType.FindRef(CleanedName))
+    {
+        return Found;
     }
 
+    TSubclassOf<AActor> MatchedBPClass = FindModelClass(CleanedName);
+    if (!MatchedBPClass) return nullptr;
 
+    UStaticMesh* MeshToUse = ExtractMeshFromBlueprint(MatchedBPClass);
+    if (!MeshToUse)
+    {
+        UE_LOG(LogTemp, Error, TEXT("No mesh extracted from blueprint: %s"), *CleanedName);
+        ModelClasses.Remove(CleanedName);
+        MissingModels.Add(CleanedName);
+        return nullptr;
+    }
+
+    StaticMeshesPerType.Add(CleanedName, MeshToUse);
+    return MeshToUse;
 }
 
 void APCGPointContent::SpawnPCGPointData()
+{
+    if (PointData.Num() == 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("No PCG point data available to spawn."));
+        return;
+    }
+
+    // Only the models this shapefile uses, each once
+    TSet<FString> UsedModels;
+    for (const FPointFeature& Data : PointData.Features)
+    {
+        UsedModels.Add(NormalizeModelName(PointData.GetModel(Data)));
+    }
+
+    TArray<FSoftObjectPath> ClassesToLoad;
+    for (const FString& Model : UsedModels)
+    {
+        if (const TSoftClassPtr<AActor>* SoftBP = ModelIndex.Find(Model))
+        {
+            ClassesToLoad.Add(SoftBP->ToSoftObjectPath());
+        }
+        else if (!MissingModels.Contains(Model))
+        {
+            UE_LOG(LogTemp, Error, TEXT("No blueprint found in registry for model: %s"), *Model);
+            MissingModels.Add(Model);
+        }
+    }
+
+    if (ClassesToLoad.Num() == 0)
+    {
+        SpawnLoadedPCGPointData();
+        return;
+    }
+
+    TWeakObjectPtr<APCGPointContent> WeakThis(this);
+    ModelLoadHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(ClassesToLoad, FStreamableDelegate::CreateLambda([WeakThis, UsedModels]()
+        {
+            APCGPointContent* This = WeakThis.Get();
+            if (!This) return;
+
+            for (const FString& Model : UsedModels)
+            {
+                if (const TSoftClassPtr<AActor>* SoftBP = This->ModelIndex.Find(Model); SoftBP && SoftBP->Get())
+                {
+                    This->ModelClasses.Add(Model, SoftBP->Get());
+                }
+            }
+
+            This->ModelLoadHandle.Reset();
+            This->SpawnLoadedPCGPointData();
+        }));
+}
+
+void APCGPointContent::SpawnLoadedPCGPointData()
 {
 
 
@@ -140,17 +354,31 @@ void APCGPointContent::SpawnPCGPointData()
 
     }
 
-    if (PointDataList.Num() == 0)
+    if (PointData.Num() == 0)
     {
         UE_LOG(LogTemp, Warning, TEXT("No PCG point data available to spawn."));
+        BeginPointSamplingReport();
+        LogPointSamplingReport(TEXT("no points"));
         return;
     }
 
-    ExpectedTotalPoints += PointDataList.Num();
+    ExpectedTotalPoints += PointData.Num();
+
+    //TotalPointDataPoints += PointData.Num();
+
+    SpawnParentActor(PointData.FileName);
+
+    if (GetDefault<UCustomPCGSettings>()->PointHeightSource == EPointHeightSource::ElevAttribute)
+    {
+        SpawnPointDataOnTerrainUsingElevData_Staged();
+        return;
+    }
 
-    //TotalPointDataPoints += PointDataList.Num();
+    SpawnPointDataOnTerrainUsingHeightProvider_Batched();
+}
 
-    FString BaseName = PointDataList[0].FileName;
+void APCGPointContent::SpawnParentActor(const FString& BaseName)
+{
     FName DesiredName(*BaseName);
 
     // Generate a unique name in the current world (Outer)
@@ -175,322 +403,760 @@ void APCGPointContent::SpawnPCGPointData()
         ParentActor->SetActorLabel(TEXT("PCG Point Parent"));
 #endif
     }
-
-    for (const FVegetationPointData& Data : PointDataList)
-    {
-        // SpawnPointDataOnTerrainUsingElevData(Data);
-        //SpawnPointDataOnTerrainUsingCesiumSampler_HISM(Data);
-        SpawnPointDataOnTerrainUsingElevData_HISM(Data);
-        APCGPointContent::TotalPointDataPoints++;
-
-        //SpawnPointDataOnTerrainUsingCesiumSampler(Data);
-    }
-
-
 }
 
-void APCGPointContent::SpawnPointDataOnTerrainUsingCesiumSampler(const FVegetationPointData& Data)
+void APCGPointContent::SpawnPointDataOnTerrainUsingElevData_Staged()
 {
-    if (!CesiumGeoreference || !BlueprintRegistry || !Tileset)
+    TRACE_CPUPROFILER_EVENT_SCOPE(APCGPointContent::SpawnPointDataOnTerrainUsingElevData_Staged);
+
+    if (!CesiumGeoreference || !BlueprintRegistry || !ParentActor)
     {
-        UE_LOG(LogTemp, Error, TEXT("CesiumGeoreference, Tileset, or BlueprintRegistry is null."));
+        UE_LOG(LogTemp, Error, TEXT("Missing required references."));
         return;
     }
 
-    TArray<FVector> Positions;
-    Positions.Add(FVector(Data.Long, Data.Lat, 0)); // Z is ignored by Cesium sampler
+    const double StartSeconds = FPlatformTime::Seconds();
+    const int32 NumPoints = PointData.Num();
+
+    TArray<int32> PointIndices;
+    TArray<FVector> WorldLocations;
+    PointIndices.SetNumUninitialized(NumPoints);
+    WorldLocations.SetNumUninitialized(NumPoints);
 
-    // Pre-bind data
-    FString CleanedName = Data.Model.Replace(TEXT(" "), TEXT("")).ToLower();
-    FVector FinalScale = FVector(Data.Scale / 100.f);
-    FRotator FinalRotation = FRotator(0.0f, Data.Rotation + 90.0f, 0.0f);
+    const FGeoreferenceBatchTransform GeoTransform(CesiumGeoreference);
+    constexpr int32 PointsPerTask = 4096;
 
-    FCesiumSampleHeightMostDetailedCallback CesiumCallback;
-    CesiumCallback.BindLambda(
-        [this, CleanedName, FinalScale, FinalRotation, Data](ACesium3DTileset* /*Tileset*/, const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings)
+    ParallelFor(FMath::DivideAndRoundUp(NumPoints, PointsPerTask), [this, NumPoints, &PointIndices, &WorldLocations, &GeoTransform](int32 TaskIndex)
         {
-            if (Results.Num() == 0 || !Results[0].SampleSuccess)
+            const int32 First = TaskIndex * PointsPerTask;
+            const int32 Count = FMath::Min(PointsPerTask, NumPoints - First);
+
+            for (int32 i = First; i < First + Count; ++i)
             {
-                UE_LOG(LogTemp, Warning, TEXT("Failed to sample terrain height for model: %s"), *CleanedName);
-                return;
+                const FPointFeature& Data = PointData.Features[i];
+                PointIndices[i] = i;
+                WorldLocations[i] = FVector(static_cast<double>(Data.Long), static_cast<double>(Data.Lat), static_cast<double>(Data.Elev));
             }
 
-            if (!CesiumGeoreference) return;
-            const FCesiumSampleHeightResult& Result = Results[0];
-            FVector WorldLocation = CesiumGeoreference->TransformLongitudeLatitudeHeightPositionToUnreal(Result.LongitudeLatitudeHeight);
+            TArrayView<FVector> Slice(WorldLocations.GetData() + First, Count);
+            GeoTransform.LongitudeLatitudeHeightToUnreal(Slice, Slice);
+        });
 
-            // Load blueprint from registry
-            TSubclassOf<AActor> MatchedBPClass = nullptr;
-            for (const TSoftClassPtr<AActor>& SoftBP : BlueprintRegistry->BlueprintClasses)
-            {
-                FString AssetName = SoftBP.GetAssetName().ToLower();
-                AssetName.RemoveFromEnd(TEXT("_c"));
+    AddPointInstances(PointIndices, WorldLocations);
+    TotalPointDataPoints += NumPoints;
 
-                if (AssetName.Equals("pd_" + CleanedName))
-                {
-                    MatchedBPClass = SoftBP.LoadSynchronous();
-                    break;
-                }
-            }
+    WritePointCache();
+    RegisterTilesForStreaming();
 
-            if (!MatchedBPClass)
+    const double Seconds = FPlatformTime::Seconds() - StartSeconds;
+    UE_LOG(LogTemp, Log, TEXT("Instanced %d points of %s from the Elev attribute in %.2f s (%.0f points/s)."),
+        NumPoints, *PointData.FileName, Seconds, Seconds > 0.0 ? NumPoints / Seconds : 0.0);
+}
+
+void APCGPointContent::AddPointInstances(TConstArrayView<int32> PointIndices, TConstArrayView<FVector> WorldLocations)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(APCGPointContent::AddPointInstances);
+
+    // Stage 1: group by model and tile; each interned model string is normalized once
+    const float TileSize = GetDefault<UCustomPCGSettings>()->PointTileSize;
+    const TArray<FInstanceCustomDataSlot>& Slots = GetDefault<UCustomPCGSettings>()->PointInstanceCustomData;
+    const int32 NumSlots = Slots.Num();
+    TArray<int32> ModelPerString;
+    ModelPerString.Init(INDEX_NONE, PointData.Strings.Num());
+    TMap<FString, int32> ModelPerCleanedName;
+    TArray<FString> Models;
+    TMap<TPair<int32, FIntPoint>, int32> GroupPerModelTile;
+    TArray<TPair<int32, FIntPoint>> GroupKeys;
+    TArray<TArray<int32>> GroupMembers;
+
+    for (int32 i = 0; i < PointIndices.Num(); ++i)
+    {
+        int32& Model = ModelPerString[PointData.Features[PointIndices[i]].Model];
+        if (Model == INDEX_NONE)
+        {
+            const FString CleanedName = NormalizeModelName(PointData.Strings.Get(PointData.Features[PointIndices[i]].Model));
+            if (const int32* FoundCleaned = ModelPerCleanedName.Find(CleanedName))
             {
-                UE_LOG(LogTemp, Error, TEXT("No blueprint found in registry for model: %s"), *CleanedName);
-                return;
+                Model = *FoundCleaned;
             }
-
-            // Spawn actor
-            FActorSpawnParameters SpawnParams;
-            AActor* Spawned = GetWorld()->SpawnActor<AActor>(MatchedBPClass, WorldLocation, FinalRotation, SpawnParams);
-            if (Spawned && ParentActor && ParentActor->GetRootComponent())
+            else
             {
-                Spawned->SetActorScale3D(FinalScale);
-                Spawned->AttachToComponent(ParentActor->GetRootComponent(), FAttachmentTransformRules::KeepWorldTransform);
-                UE_LOG(LogTemp, Log, TEXT("Spawned %s at %s with Cesium height: %.2f"), *CleanedName, *WorldLocation.ToString(), Result.LongitudeLatitudeHeight[2]);
+                Model = Models.Add(CleanedName);
+                ModelPerCleanedName.Add(CleanedName, Model);
             }
+        }
+
+        const TPair<int32, FIntPoint> Key(Model, TileOf(WorldLocations[i], TileSize));
+        int32 Group;
+        if (const int32* Found = GroupPerModelTile.Find(Key))
+        {
+            Group = *Found;
+        }
+        else
+        {
+            Group = GroupKeys.Add(Key);
+            GroupMembers.AddDefaulted();
+            GroupPerModelTile.Add(Key, Group);
+        }
+        GroupMembers[Group].Add(i);
+    }
 
-            for (const FString& Warn : Warnings)
+    UInstanceBuilderSubsystem* InstanceBuilder = GetWorld()->GetSubsystem<UInstanceBuilderSubsystem>();
+
+    for (int32 Group = 0; Group < GroupKeys.Num(); ++Group)
+    {
+        UInstancedStaticMeshComponent* ISM = FindOrCreateInstancedMesh(Models[GroupKeys[Group].Key], GroupKeys[Group].Value);
+        if (!ISM) continue;
+
+        // Stage 2: transforms and custom data of the group in parallel
+        const TArray<int32>& Members = GroupMembers[Group];
+        TArray<FTransform> Transforms;
+        Transforms.SetNumUninitialized(Members.Num());
+        TArray<float> CustomData;
+        CustomData.SetNumUninitialized(Members.Num() * NumSlots);
+
+        ParallelFor(Members.Num(), [this, &Members, &Transforms, &CustomData, &Slots, NumSlots, PointIndices, WorldLocations](int32 Index)
             {
-                UE_LOG(LogTemp, Warning, TEXT("Cesium Warning: %s"), *Warn);
-            }
-        });
+                const int32 i = Members[Index];
+                const FPointFeature& Data = PointData.Features[PointIndices[i]];
+                Transforms[Index] = FTransform(FRotator(0.0f, Data.Rotation, 0.0f), WorldLocations[i], FVector(Data.Scale / 100.f));
+                if (NumSlots > 0)
+                {
+                    FFeatureCustomData::ForPoint(Data, StringCustomData, Slots, TArrayView<float>(CustomData.GetData() + Index * NumSlots, NumSlots));
+                }
+            });
 
-    Tileset->SampleHeightMostDetailed(Positions, CesiumCallback);
+        // Stage 3: one call per model and tile; new instances are appended, so they start at the previous count
+        const int32 FirstInstance = InstanceBuilder->AddInstances(ISM, Transforms, true);
+        InstanceBuilder->SetCustomData(ISM, FirstInstance, CustomData, NumSlots);
+    }
 }
 
-void APCGPointContent::SpawnPointDataOnTerrainUsingElevData(const FVegetationPointData& Data)
+void APCGPointContent::SpawnPointDataOnTerrainUsingHeightProvider_Batched()
 {
-    if (!CesiumGeoreference || !BlueprintRegistry)
+    BeginPointSamplingReport();
+
+    if (!CesiumGeoreference || !BlueprintRegistry || !ParentActor)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Missing required references."));
+        LogPointSamplingReport(TEXT("missing georeference, registry or parent actor"));
+        return;
+    }
+
+    HeightProvider = IPCGHeightProvider::Create(GetDefault<UCustomPCGSettings>()->PointHeightProvider, GetWorld(), Tileset);
+    if (!HeightProvider)
     {
-        UE_LOG(LogTemp, Error, TEXT("CesiumGeoreference or BlueprintRegistry is null."));
+        LogPointSamplingReport(TEXT("no height provider"));
         return;
     }
 
-    // Step 1: Convert LLH to Unreal World Location
-    FVector LLH(static_cast<double>(Data.Long), static_cast<double>(Data.Lat), static_cast<double>(Data.Elev));
-    FVector WorldLocation = CesiumGeoreference->TransformLongitudeLatitudeHeightPositionToUnreal(LLH);
+    NextSampleIndex = 0;
+    SampleRequestsInFlight = 0;
 
-    // Step 2: Match model name
-    FString CleanedName = Data.Model.Replace(TEXT(" "), TEXT("")).ToLower();
-    TSubclassOf<AActor> MatchedBPClass = nullptr;
+    IssuePendingSampleChunks();
+}
 
-    for (const TSoftClassPtr<AActor>& SoftBP : BlueprintRegistry->BlueprintClasses)
+void APCGPointContent::IssuePendingSampleChunks()
+{
+    if (!HeightProvider) return;
+
+    const UCustomPCGSettings* Settings = GetDefault<UCustomPCGSettings>();
+    const int32 ChunkSize = FMath::Max(Settings->HeightSampleChunkSize, 1);
+    const int32 MaxInFlight = FMath::Max(Settings->MaxHeightSampleRequestsInFlight, 1);
+
+    while (SampleRequestsInFlight < MaxInFlight && NextSampleIndex < PointData.Num())
     {
-        FString AssetName = SoftBP.GetAssetName().ToLower();
-        AssetName.RemoveFromEnd(TEXT("_c")); // remove _C suffix if present
+        const int32 FirstIndex = NextSampleIndex;
+        const int32 Count = FMath::Min(ChunkSize, PointData.Num() - FirstIndex);
+        NextSampleIndex += Count;
 
-        if (AssetName.Equals("pd_" + CleanedName))
+        TArray<FVector> Positions;
+        Positions.Reserve(Count);
+        for (int32 i = FirstIndex; i < FirstIndex + Count; ++i)
         {
-            MatchedBPClass = SoftBP.LoadSynchronous();
-            break;
+            Positions.Add(FVector(PointData.Features[i].Long, PointData.Features[i].Lat, 0)); // Z ignored for sampling
         }
+
+        TWeakObjectPtr<APCGPointContent> WeakThis(this);
+
+        SampleRequestsInFlight++;
+        SamplingReport.Requests++;
+
+        HeightProvider->SampleHeights(Positions,
+            [WeakThis, FirstIndex, Count](const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings)
+            {
+                APCGPointContent* This = WeakThis.Get();
+                if (!This) return;
+
+                This->SampleRequestsInFlight--;
+
+                if (Results.Num() == Count)
+                {
+                    This->ScatterSampledChunk(FirstIndex, Results);
+                }
+                else
+                {
+                    UE_LOG(LogTemp, Error, TEXT("Sampled results (%d) do not match chunk size (%d)."), Results.Num(), Count);
+                    This->SamplingReport.FailedPoints += Count;
+                }
+
+                for (const FString& Warn : Warnings)
+                {
+                    UE_LOG(LogTemp, Warning, TEXT("Height sampling warning: %s"), *Warn);
+                }
+
+                This->OnPointSamplesCompleted(Count);
+                This->IssuePendingSampleChunks();
+            });
     }
+}
 
-    if (!MatchedBPClass)
+void APCGPointContent::ScatterSampledChunk(int32 FirstIndex, const TArray<FCesiumSampleHeightResult>& Results)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(APCGPointContent::ScatterSampledChunk);
+
+    if (!CesiumGeoreference)
     {
-        UE_LOG(LogTemp, Error, TEXT("No blueprint found in registry for model: %s"), *CleanedName);
+        SamplingReport.FailedPoints += Results.Num();
         return;
     }
 
-    // Step 3: Spawn actor with position, scale, and rotation
-    FVector FinalScale = FVector(Data.Scale / 100.f);
-    FRotator FinalRotation = FRotator(0.0f, Data.Rotation, 0.0f);
-    FActorSpawnParameters SpawnParams;
+    TArray<FVector> WorldLocations;
+    WorldLocations.SetNumUninitialized(Results.Num());
+    for (int32 i = 0; i < Results.Num(); ++i)
+    {
+        WorldLocations[i] = Results[i].LongitudeLatitudeHeight;
+    }
+    FGeoreferenceBatchTransform(CesiumGeoreference).LongitudeLatitudeHeightToUnreal(WorldLocations, WorldLocations);
+
+    TArray<int32> PointIndices;
+    TArray<FVector> SampledLocations;
+    PointIndices.Reserve(Results.Num());
+    SampledLocations.Reserve(Results.Num());
 
-    AActor* Spawned = GetWorld()->SpawnActor<AActor>(MatchedBPClass, WorldLocation, FinalRotation, SpawnParams);
-    if (Spawned && ParentActor && ParentActor->GetRootComponent())
+    for (int32 i = 0; i < Results.Num(); ++i)
     {
-        Spawned->SetActorScale3D(FinalScale);
-        Spawned->AttachToComponent(ParentActor->GetRootComponent(), FAttachmentTransformRules::KeepWorldTransform);
-        UE_LOG(LogTemp, Log, TEXT("Spawned %s at %s"), *CleanedName, *WorldLocation.ToString());
+        if (Results[i].SampleSuccess)
+        {
+            PointIndices.Add(FirstIndex + i);
+            SampledLocations.Add(WorldLocations[i]);
+        }
     }
+
+    const int32 NumFailed = Results.Num() - PointIndices.Num();
+    SamplingReport.FailedPoints += NumFailed;
+    if (NumFailed > 0)
+    {
+        UE_LOG(LogTemp, Warning, TEXT("Failed to sample height for %d of %d points."), NumFailed, Results.Num());
+    }
+
+    AddPointInstances(PointIndices, SampledLocations);
 }
 
-void APCGPointContent::SpawnPointDataOnTerrainUsingCesiumSampler_HISM(const FVegetationPointData& Data)
+void APCGPointContent::OnPointSamplesCompleted(int32 NumPoints)
 {
-    if (!CesiumGeoreference || !BlueprintRegistry || !Tileset || !ParentActor)
+    SamplingReport.CompletedPoints += NumPoints;
+    if (SamplingReport.CompletedPoints != SamplingReport.Points) return;
+
+    LogPointSamplingReport(TEXT("complete"));
+
+    // A partial result would be replayed as if the missing points did not exist
+    if (SamplingReport.FailedPoints == 0)
     {
-        UE_LOG(LogTemp, Error, TEXT("Missing required references."));
-        return;
+        WritePointCache();
+    }
+    RegisterTilesForStreaming();
+}
+
+void APCGPointContent::BeginPointSamplingReport()
+{
+    SamplingReport = FPointSamplingReport();
+    SamplingReport.StartSeconds = FPlatformTime::Seconds();
+    SamplingReport.Points = PointData.Num();
+}
+
+void APCGPointContent::LogPointSamplingReport(const TCHAR* Outcome) const
+{
+    const double Seconds = FPlatformTime::Seconds() - SamplingReport.StartSeconds;
+    UE_LOG(LogTemp, Log, TEXT("Point height sampling (%s, %s, %s): %d of %d points returned (%d failed) in %d requests, %.2f s (%.0f points/s)."),
+        *PointData.FileName,
+        HeightProvider ? *HeightProvider->GetDescription() : TEXT("Batched"),
+        Outcome,
+        SamplingReport.CompletedPoints,
+        SamplingReport.Points,
+        SamplingReport.FailedPoints,
+        SamplingReport.Requests,
+        Seconds,
+        Seconds > 0.0 ? SamplingReport.CompletedPoints / Seconds : 0.0);
+}
+
+UInstancedStaticMeshComponent* APCGPointContent::FindOrCreateInstancedMesh(const FString& CleanedName, FIntPoint Tile)
+{
+    if (const FPointInstanceTile* FoundTile = InstanceTiles.Find(Tile))
+    {
+        if (UInstancedStaticMeshComponent* const* Found = FoundTile->Components.Find(CleanedName))
+        {
+            return *Found;
+        }
     }
 
-    TArray<FVector> Positions;
-    Positions.Add(FVector(Data.Long, Data.Lat, 0)); // Z ignored for sampling
+    UStaticMesh* MeshToUse = FindModelMesh(CleanedName);
+    if (!MeshToUse) return nullptr;
+
+    return CreateInstancedMesh(CleanedName, Tile, MeshToUse);
+}
+
+UInstancedStaticMeshComponent* APCGPointContent::CreateInstancedMesh(const FString& Key, FIntPoint Tile, UStaticMesh* Mesh)
+{
+    FPointInstanceTile& InstanceTile = InstanceTiles.FindOrAdd(Tile);
+
+    UInstancedStaticMeshComponent* ISM = GetWorld()->GetSubsystem<UInstanceBuilderSubsystem>()->CreateComponent(
+        ParentActor, Mesh, GetDefault<UCustomPCGSettings>()->PointInstanceCustomData.Num(), InstanceTile.bLoaded);
+    AddInstanceComponent(ISM);
+    InstanceTile.Components.Add(Key, ISM);
+
+    return ISM;
+}
+
+FIntPoint APCGPointContent::TileOf(const FVector& WorldLocation, float TileSize)
+{
+    if (TileSize <= 0.0f) return FIntPoint::ZeroValue;
+
+    return FIntPoint(FMath::FloorToInt(WorldLocation.X / TileSize), FMath::FloorToInt(WorldLocation.Y / TileSize));
+}
 
-    FString CleanedName = Data.Model.Replace(TEXT(" "), TEXT("")).ToLower();
-    FVector FinalScale = FVector(Data.Scale / 100.f);
-    FRotator FinalRotation = FRotator(0.0f, Data.Rotation, 0.0f);
+void APCGPointContent::RegisterTilesForStreaming()
+{
+    const float TileSize = GetDefault<UCustomPCGSettings>()->PointTileSize;
+    if (TileSize <= 0.0f) return;
 
+    AGridStreamingManager* StreamingManager = Cast<AGridStreamingManager>(UGameplayStatics::GetActorOfClass(GetWorld(), AGridStreamingManager::StaticClass()));
+    if (!StreamingManager) return;
 
+    for (const TPair<FIntPoint, FPointInstanceTile>& Pair : InstanceTiles)
+    {
+        StreamingManager->RegisterPointTile(this, Pair.Key, FBox2D(FVector2D(Pair.Key) * TileSize, FVector2D(Pair.Key + FIntPoint(1, 1)) * TileSize));
+    }
+}
+
+void APCGPointContent::SetTileLoaded(FIntPoint Tile, bool bLoaded)
+{
+    FPointInstanceTile* InstanceTile = InstanceTiles.Find(Tile);
+    if (!InstanceTile || InstanceTile->bLoaded == bLoaded) return;
+
+    InstanceTile->bLoaded = bLoaded;
+    for (const TPair<FString, UInstancedStaticMeshComponent*>& Pair : InstanceTile->Components)
+    {
+        if (!Pair.Value) continue;
 
-    FCesiumSampleHeightMostDetailedCallback CesiumCallback;
-    CesiumCallback.BindLambda(
-        [this, CleanedName, FinalScale, FinalRotation, Data](ACesium3DTileset*, const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings)
+        if (bLoaded)
         {
-            if (Results.Num() == 0 || !Results[0].SampleSuccess)
-            {
-                UE_LOG(LogTemp, Warning, TEXT("Failed to sample height for %s"), *CleanedName);
-                return;
-            }
-            if (!CesiumGeoreference) return;
+            Pair.Value->RegisterComponent();
+        }
+        else
+        {
+            Pair.Value->UnregisterComponent();
+        }
+    }
+}
 
-            // Step 1: Cesium world transform
-            const FVector WorldLocation = CesiumGeoreference->TransformLongitudeLatitudeHeightPositionToUnreal(
-                Results[0].LongitudeLatitudeHeight);
+FPointCacheKey FPointCacheKey::Make(const FString& ShapefilePath, UWorld* World)
+{
+    FPointCacheKey Key;
+    Key.ShapefileID = FPaths::GetBaseFilename(ShapefilePath);
 
+    for (const FString& Extension : { FString(TEXT("shp")), FString(TEXT("dbf")) })
+    {
+        const FString File = FPaths::ChangeExtension(ShapefilePath, Extension);
+        Key.LastModified = FMath::Max(Key.LastModified, IFileManager::Get().GetTimeStamp(*File).ToUnixTimestamp());
+        Key.FileSize += FMath::Max<int64>(IFileManager::Get().FileSize(*File), 0);
+    }
 
-            // Step 2: Retrieve or extract mesh
-            UStaticMesh* MeshToUse = StaticMeshesPerType.FindRef(CleanedName);
-            if (!MeshToUse)
-            {
-                TSubclassOf<AActor> MatchedBPClass = nullptr;
-                for (const TSoftClassPtr<AActor>& SoftBP : BlueprintRegistry->BlueprintClasses)
-                {
-                    FString AssetName = SoftBP.GetAssetName().ToLower();
-                    AssetName.RemoveFromEnd(TEXT("_c"));
+    const UCustomPCGSettings* Settings = GetDefault<UCustomPCGSettings>();
+    Key.SourceKey = StaticEnum<EPointHeightSource>()->GetNameStringByValue(int64(Settings->PointHeightSource));
+    if (Settings->PointHeightSource == EPointHeightSource::Batched)
+    {
+        Key.SourceKey += TEXT("/") + StaticEnum<EPCGHeightProviderType>()->GetNameStringByValue(int64(Settings->PointHeightProvider));
+        if (Settings->PointHeightProvider == EPCGHeightProviderType::Raster)
+        {
+            Key.SourceKey += FString::Printf(TEXT("/%s/%f"), *Settings->RasterHeightFile.FilePath, Settings->RasterHeightOffset);
+        }
+        else if (World)
+        {
+            // Heights came from this tileset, the same one APCGPointContent samples
+            const ACesium3DTileset* Tileset = Cast<ACesium3DTileset>(UGameplayStatics::GetActorOfClass(World, ACesium3DTileset::StaticClass()));
+            Key.SourceKey += TEXT("/") + UTerrainHeightCacheSubsystem::MakeTilesetKey(Tileset);
+        }
+    }
 
-                    if (AssetName.Equals("pd_" + CleanedName))
-                    {
-                        MatchedBPClass = SoftBP.LoadSynchronous();
-                        break;
-                    }
-                }
+    // Cached custom data was written with this slot mapping
+    if (Settings->PointInstanceCustomData.Num() > 0)
+    {
+        Key.SourceKey += TEXT("#") + FFeatureCustomData::Describe(Settings->PointInstanceCustomData);
+    }
 
-                if (!MatchedBPClass)
-                {
-                    UE_LOG(LogTemp, Error, TEXT("Blueprint not found for type: %s"), *CleanedName);
-                    return;
-                }
+    // Cached mesh paths were resolved through this model -> blueprint mapping
+    Key.SourceKey += FString::Printf(TEXT("|registry:%08x"), HashModelRegistry(LoadBlueprintRegistry()));
 
-                MeshToUse = ExtractMeshFromBlueprint(MatchedBPClass);
-                if (!MeshToUse)
-                {
-                    UE_LOG(LogTemp, Error, TEXT("No mesh extracted from blueprint: %s"), *CleanedName);
-                    return;
-                }
+    // Cached transforms are in Unreal space, so they are only valid for the same origin
+    if (const ACesiumGeoreference* Georef = World ? ACesiumGeoreference::GetDefaultGeoreference(World) : nullptr)
+    {
+        Key.SourceKey += FString::Printf(TEXT("@%.9f,%.9f,%.3f"), Georef->GetOriginLongitude(), Georef->GetOriginLatitude(), Georef->GetOriginHeight());
+    }
 
-                StaticMeshesPerType.Add(CleanedName, MeshToUse);
-            }
+    return Key;
+}
+
+void APCGPointContent::CreatePointCacheTables(UPcgSQLiteSubsystem* SQLite)
+{
+    const FString CreateMetadataTableSQL = TEXT(R"(
+        CREATE TABLE IF NOT EXISTS PointShapefileMetadata (
+            ShapefileID TEXT PRIMARY KEY,
+            LastModified INT,
+            FileSize INT,
+            SourceKey TEXT
+        );
+    )");
+
+    const FString CreateInstancesTableSQL = TEXT(R"(
+        CREATE TABLE IF NOT EXISTS PointInstances (
+            ShapefileID TEXT,
+            InstanceIndex INTEGER,
+            MeshID TEXT,
+            X REAL,
+            Y REAL,
+            Z REAL,
+            QX REAL,
+            QY REAL,
+            QZ REAL,
+            QW REAL,
+            SX REAL,
+            SY REAL,
+            SZ REAL,
+            PRIMARY KEY(ShapefileID, InstanceIndex)
+        );
+    )");
+
+    // Separate table, so caches written before custom data existed stay readable
+    const FString CreateCustomDataTableSQL = TEXT(R"(
+        CREATE TABLE IF NOT EXISTS PointInstanceCustomData (
+            ShapefileID TEXT,
+            InstanceIndex INTEGER,
+            Data BLOB,
+            PRIMARY KEY(ShapefileID, InstanceIndex)
+        );
+    )");
+
+    SQLite->Execute(CreateMetadataTableSQL);
+    SQLite->Execute(CreateInstancesTableSQL);
+    SQLite->Execute(CreateCustomDataTableSQL);
+}
+
+bool APCGPointContent::IsPointCacheValid(UPcgSQLiteSubsystem* SQLite, const FPointCacheKey& Key)
+{
+    if (!SQLite || !SQLite->IsOpen()) return false;
+
+    bool bValid = false;
+    const FString CheckSQL = FString::Printf(TEXT("SELECT LastModified, FileSize, SourceKey FROM PointShapefileMetadata WHERE ShapefileID='%s';"), *Key.ShapefileID);
+    SQLite->ExecuteWithCallback(CheckSQL, [&](const FSQLitePreparedStatement& Statement) -> ESQLitePreparedStatementExecuteRowResult
+        {
+            int64 SavedTimestamp = 0;
+            int64 SavedSize = 0;
+            FString SavedSourceKey;
+            Statement.GetColumnValueByIndex(0, SavedTimestamp);
+            Statement.GetColumnValueByIndex(1, SavedSize);
+            Statement.GetColumnValueByIndex(2, SavedSourceKey);
+
+            bValid = SavedTimestamp == Key.LastModified && SavedSize == Key.FileSize && SavedSourceKey == Key.SourceKey;
+            return ESQLitePreparedStatementExecuteRowResult::Stop;
+        });
+
+    return bValid;
+}
+
+void APCGPointContent::SpawnPCGPointDataFromCache(const FPointCacheKey& Key)
+{
+    UPcgSQLiteSubsystem* SQLite = GetWorld()->GetGameInstance() ? GetWorld()->GetGameInstance()->GetSubsystem<UPcgSQLiteSubsystem>() : nullptr;
+    if (!SQLite || !SQLite->IsOpen())
+    {
+        UE_LOG(LogTemp, Error, TEXT("SpawnPCGPointDataFromCache: DB subsystem not available/open"));
+        return;
+    }
+
+    SpawnParentActor(Key.ShapefileID);
+
+    // One group per mesh and tile
+    struct FCachedInstances
+    {
+        TArray<FString> MeshPaths;
+        TArray<FIntPoint> Tiles;
+        TArray<TArray<FTransform>> Transforms;
+        // NumCustomDataFloats per instance, empty when the cache has none
+        TArray<TArray<float>> CustomData;
+    };
+
+    const double StartSeconds = FPlatformTime::Seconds();
+    TWeakObjectPtr<APCGPointContent> WeakThis(this);
+    // The worker opens its own read-only connection, so it never touches the subsystem or its lock
+    const FString DatabasePath = SQLite->GetDatabasePath();
+    const FString ShapefileID = Key.ShapefileID;
+    const float TileSize = GetDefault<UCustomPCGSettings>()->PointTileSize;
+    const int32 NumSlots = GetDefault<UCustomPCGSettings>()->PointInstanceCustomData.Num();
+
+    Async(EAsyncExecution::ThreadPool, [WeakThis, DatabasePath, ShapefileID, StartSeconds, TileSize, NumSlots]()
+        {
+            TRACE_CPUPROFILER_EVENT_SCOPE(APCGPointContent::ReadPointCache);
 
-            UHierarchicalInstancedStaticMeshComponent* HISM = nullptr;
+            TSharedRef<FCachedInstances> Cached = MakeShared<FCachedInstances>();
+            TMap<TPair<FString, FIntPoint>, int32> GroupIndex;
 
-            if (!InstancedMeshMap.Contains(CleanedName))
+            FSQLiteDatabase ReadDB;
+            if (!ReadDB.Open(*DatabasePath, ESQLiteDatabaseOpenMode::ReadOnly))
             {
-                HISM = NewObject<UHierarchicalInstancedStaticMeshComponent>(ParentActor);
-                HISM->SetStaticMesh(MeshToUse);
-                HISM->AttachToComponent(ParentActor->GetRootComponent(), FAttachmentTransformRules::KeepWorldTransform);
-                HISM->RegisterComponent();
-                AddInstanceComponent(HISM);
-                InstancedMeshMap.Add(CleanedName, HISM);
+                UE_LOG(LogTemp, Error, TEXT("SpawnPCGPointDataFromCache: failed to open %s for reading"), *DatabasePath);
             }
             else
             {
-                HISM = InstancedMeshMap[CleanedName];
+                // Read in pages keyed on InstanceIndex so no read transaction spans the whole table and
+                // WritePointCache on the main connection can commit between pages
+                constexpr int32 PageSize = 8192;
+                FSQLitePreparedStatement Statement = ReadDB.PrepareStatement(TEXT(
+                    "SELECT i.InstanceIndex, i.MeshID, i.X, i.Y, i.Z, i.QX, i.QY, i.QZ, i.QW, i.SX, i.SY, i.SZ, c.Data FROM PointInstances i "
+                    "LEFT JOIN PointInstanceCustomData c ON c.ShapefileID = i.ShapefileID AND c.InstanceIndex = i.InstanceIndex "
+                    "WHERE i.ShapefileID = ?1 AND i.InstanceIndex > ?2 ORDER BY i.InstanceIndex LIMIT ?3;"),
+                    ESQLitePreparedStatementFlags::Persistent);
+
+                int64 LastIndex = -1;
+                int64 RowsInPage = PageSize;
+                while (Statement.IsValid() && RowsInPage == PageSize)
+                {
+                    Statement.SetBindingValueByIndex(1, ShapefileID);
+                    Statement.SetBindingValueByIndex(2, LastIndex);
+                    Statement.SetBindingValueByIndex(3, PageSize);
+
+                    RowsInPage = Statement.Execute([&](const FSQLitePreparedStatement& Row) -> ESQLitePreparedStatementExecuteRowResult
+                        {
+                            FString MeshPath;
+                            FVector Location;
+                            FQuat Rotation;
+                            FVector Scale;
+                            Row.GetColumnValueByIndex(0, LastIndex);
+                            Row.GetColumnValueByIndex(1, MeshPath);
+                            Row.GetColumnValueByIndex(2, Location.X);
+                            Row.GetColumnValueByIndex(3, Location.Y);
+                            Row.GetColumnValueByIndex(4, Location.Z);
+                            Row.GetColumnValueByIndex(5, Rotation.X);
+                            Row.GetColumnValueByIndex(6, Rotation.Y);
+                            Row.GetColumnValueByIndex(7, Rotation.Z);
+                            Row.GetColumnValueByIndex(8, Rotation.W);
+                            Row.GetColumnValueByIndex(9, Scale.X);
+                            Row.GetColumnValueByIndex(10, Scale.Y);
+                            Row.GetColumnValueByIndex(11, Scale.Z);
+                            TArray<uint8> CustomDataBytes;
+                            Row.GetColumnValueByIndex(12, CustomDataBytes);
+
+                            const TPair<FString, FIntPoint> Key(MeshPath, TileOf(Location, TileSize));
+                            int32 Group;
+                            if (const int32* Found = GroupIndex.Find(Key))
+                            {
+                                Group = *Found;
+                            }
+                            else
+                            {
+                                Group = Cached->MeshPaths.Add(MeshPath);
+                                Cached->Tiles.Add(Key.Value);
+                                Cached->Transforms.AddDefaulted();
+                                Cached->CustomData.AddDefaulted();
+                                GroupIndex.Add(Key, Group);
+                            }
+                            Cached->Transforms[Group].Emplace(Rotation, Location, Scale);
+
+                            // The cache key covers the slot mapping, so a stored row always has NumSlots floats
+                            if (NumSlots > 0)
+                            {
+                                TArray<float>& GroupCustomData = Cached->CustomData[Group];
+                                const int32 First = GroupCustomData.AddZeroed(NumSlots);
+                                if (CustomDataBytes.Num() == NumSlots * sizeof(float))
+                                {
+                                    FMemory::Memcpy(GroupCustomData.GetData() + First, CustomDataBytes.GetData(), CustomDataBytes.Num());
+                                }
+                            }
+
+                            return ESQLitePreparedStatementExecuteRowResult::Continue;
+                        });
+
+                    if (RowsInPage == INDEX_NONE)
+                    {
+                        UE_LOG(LogTemp, Error, TEXT("SpawnPCGPointDataFromCache: reading %s stopped after instance %lld: %s"), *ShapefileID, LastIndex, *ReadDB.GetLastError());
+                    }
+
+                    Statement.Reset();
+                    Statement.ClearBindings();
+                }
+
+                Statement.Destroy();
+                ReadDB.Close();
             }
 
-            // Step 4: Add the instance
-            FTransform InstanceTransform(FinalRotation, WorldLocation, FinalScale);
-            HISM->AddInstance(InstanceTransform);
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, Cached, ShapefileID, StartSeconds]()
+                {
+                    if (!WeakThis.IsValid()) return;
 
-            //APCGPointContent::TotalPointDataPoints++;
+                    TArray<FSoftObjectPath> MeshesToLoad;
+                    for (const FString& MeshPath : Cached->MeshPaths)
+                    {
+                        MeshesToLoad.AddUnique(FSoftObjectPath(MeshPath));
+                    }
 
-            if (APCGPointContent::TotalPointDataPoints!=0 && ExpectedTotalPoints == APCGPointContent::TotalPointDataPoints) {
-                FTimespan Elapsed = FDateTime::UtcNow() - StartTime;
+                    auto AddInstances = [WeakThis, Cached, ShapefileID, StartSeconds]()
+                        {
+                            APCGPointContent* This = WeakThis.Get();
+                            if (!This || !This->ParentActor) return;
+
+                            int32 NumInstances = 0;
+                            for (int32 Group = 0; Group < Cached->MeshPaths.Num(); ++Group)
+                            {
+                                UStaticMesh* StaticMesh = Cast<UStaticMesh>(FSoftObjectPath(Cached->MeshPaths[Group]).ResolveObject());
+                                if (!StaticMesh)
+                                {
+                                    UE_LOG(LogTemp, Error, TEXT("Cached point mesh not found: %s"), *Cached->MeshPaths[Group]);
+                                    continue;
+                                }
+
+                                UInstanceBuilderSubsystem* InstanceBuilder = This->GetWorld()->GetSubsystem<UInstanceBuilderSubsystem>();
+                                UInstancedStaticMeshComponent* ISM = This->CreateInstancedMesh(Cached->MeshPaths[Group], Cached->Tiles[Group], StaticMesh);
+                                const int32 FirstInstance = InstanceBuilder->AddInstances(ISM, Cached->Transforms[Group], true);
+                                InstanceBuilder->SetCustomData(ISM, FirstInstance, Cached->CustomData[Group], ISM ? ISM->NumCustomDataFloats : 0);
+                                NumInstances += Cached->Transforms[Group].Num();
+                            }
+                            This->RegisterTilesForStreaming();
+
+                            const double Seconds = FPlatformTime::Seconds() - StartSeconds;
+                            UE_LOG(LogTemp, Log, TEXT("Instanced %d cached points of %s in %.2f s."), NumInstances, *ShapefileID, Seconds);
+                        };
+
+                    if (MeshesToLoad.Num() == 0)
+                    {
+                        AddInstances();
+                        return;
+                    }
 
-                GEngine->AddOnScreenDebugMessage(-1, 5.0, FColor::Green, FString::Printf(TEXT("Total Point Data Points: %d"), TotalPointDataPoints));
-                GEngine->AddOnScreenDebugMessage(-1, 5.0, FColor::Red, FString::Printf(TEXT("Total Time(s) Point Data: %f"), Elapsed.GetTotalSeconds()));
+                    UAssetManager::GetStreamableManager().RequestAsyncLoad(MeshesToLoad, FStreamableDelegate::CreateLambda(AddInstances));
+                });
+        });
+}
 
+void APCGPointContent::WritePointCache()
+{
+    if (CacheKey.ShapefileID.IsEmpty()) return;
 
-                UE_LOG(LogTemp, Log, TEXT("Total Point Data Points are: %d"), TotalPointDataPoints);
-                UE_LOG(LogTemp, Log, TEXT("Total Execution Time(Point Data): %.2f"), Elapsed.GetTotalSeconds());
+    UPcgSQLiteSubsystem* SQLite = GetWorld()->GetGameInstance() ? GetWorld()->GetGameInstance()->GetSubsystem<UPcgSQLiteSubsystem>() : nullptr;
+    if (!SQLite || !SQLite->IsOpen()) return;
 
-                TotalPointDataPoints = 0;
-                ExpectedTotalPoints = 0;
-                StartTime = FDateTime::MinValue();
-                bTimerStarted = false;
-            }
+    TRACE_CPUPROFILER_EVENT_SCOPE(APCGPointContent::WritePointCache);
 
+    // The transaction and its persistent statements use the shared connection, so no other query may interleave
+    FScopeLock DatabaseLock(&SQLite->GetLock());
 
- 
-            UE_LOG(LogTemp, Log, TEXT("Instanced %s at %s"), *CleanedName, *WorldLocation.ToString());
+    SQLite->BeginTransaction();
 
-            for (const FString& Warn : Warnings)
-            {
-                UE_LOG(LogTemp, Warning, TEXT("Cesium warning: %s"), *Warn);
-            }
-        });
+    SQLite->Execute(FString::Printf(TEXT("DELETE FROM PointInstances WHERE ShapefileID='%s';"), *CacheKey.ShapefileID));
+    SQLite->Execute(FString::Printf(TEXT("DELETE FROM PointInstanceCustomData WHERE ShapefileID='%s';"), *CacheKey.ShapefileID));
 
-    Tileset->SampleHeightMostDetailed(Positions, CesiumCallback);
-}
+    FSQLitePreparedStatement Statement = SQLite->GetDatabase().PrepareStatement(
+        TEXT("INSERT INTO PointInstances (ShapefileID, InstanceIndex, MeshID, X, Y, Z, QX, QY, QZ, QW, SX, SY, SZ) VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, ?11, ?12, ?13);"),
+        ESQLitePreparedStatementFlags::Persistent);
 
-void APCGPointContent::SpawnPointDataOnTerrainUsingElevData_HISM(const FVegetationPointData& Data) {
-    if (!CesiumGeoreference || !BlueprintRegistry)
+    FSQLitePreparedStatement CustomDataStatement = SQLite->GetDatabase().PrepareStatement(
+        TEXT("INSERT INTO PointInstanceCustomData (ShapefileID, InstanceIndex, Data) VALUES (?1, ?2, ?3);"),
+        ESQLitePreparedStatementFlags::Persistent);
+
+    if (!Statement.IsValid() || !CustomDataStatement.IsValid())
     {
-        UE_LOG(LogTemp, Error, TEXT("CesiumGeoreference or BlueprintRegistry is null."));
+        UE_LOG(LogTemp, Error, TEXT("WritePointCache: failed to prepare insert statement"));
+        SQLite->RollbackTransaction();
         return;
     }
-    FVector LLH(static_cast<double>(Data.Long), static_cast<double>(Data.Lat), static_cast<double>(Data.Elev));
-    FVector WorldLocation = CesiumGeoreference->TransformLongitudeLatitudeHeightPositionToUnreal(LLH);
-    FString CleanedName = Data.Model.Replace(TEXT(" "), TEXT("")).ToLower();
-    FVector FinalScale = FVector(Data.Scale / 100.f);
-    FRotator FinalRotation = FRotator(0.0f, Data.Rotation, 0.0f);
-    TSubclassOf<AActor> MatchedBPClass = nullptr;
-    UStaticMesh* MeshToUse = StaticMeshesPerType.FindRef(CleanedName);
 
-    for (const TSoftClassPtr<AActor>& SoftBP : BlueprintRegistry->BlueprintClasses)
+    TArray<UInstancedStaticMeshComponent*> Components;
+    for (const TPair<FIntPoint, FPointInstanceTile>& Tile : InstanceTiles)
     {
-        FString AssetName = SoftBP.GetAssetName().ToLower();
-        AssetName.RemoveFromEnd(TEXT("_c")); // remove _C suffix if present
-
-        if (AssetName.Equals("pd_" + CleanedName))
+        for (const TPair<FString, UInstancedStaticMeshComponent*>& Pair : Tile.Value.Components)
         {
-            MatchedBPClass = SoftBP.LoadSynchronous();
-            break;
+            Components.Add(Pair.Value);
         }
     }
-    if (!MatchedBPClass)
-    {
-        UE_LOG(LogTemp, Error, TEXT("No blueprint found in registry for model: %s"), *CleanedName);
-        return;
-    }
-    MeshToUse = ExtractMeshFromBlueprint(MatchedBPClass);
-    if (!MeshToUse)
+
+    int32 InstanceIndex = 0;
+    TArray<FTransform> Transforms;
+    for (UInstancedStaticMeshComponent* ISM : Components)
     {
-        UE_LOG(LogTemp, Error, TEXT("No mesh extracted from blueprint: %s"), *CleanedName);
-        return;
-    }
-    StaticMeshesPerType.Add(CleanedName, MeshToUse);
+        if (!ISM || !ISM->GetStaticMesh()) continue;
 
-    UHierarchicalInstancedStaticMeshComponent* HISM = nullptr;
+        const FString MeshPath = ISM->GetStaticMesh()->GetPathName();
+        const int32 NumSlots = ISM->NumCustomDataFloats;
+        UInstanceBuilderSubsystem::ReadInstances(ISM, Transforms);
+        for (int32 i = 0; i < Transforms.Num(); ++i)
+        {
+            if (NumSlots > 0 && ISM->PerInstanceSMCustomData.Num() >= (i + 1) * NumSlots)
+            {
+                const TArrayView<const uint8> Bytes(reinterpret_cast<const uint8*>(ISM->PerInstanceSMCustomData.GetData() + i * NumSlots), NumSlots * sizeof(float));
+                CustomDataStatement.SetBindingValueByIndex(1, CacheKey.ShapefileID);
+                CustomDataStatement.SetBindingValueByIndex(2, InstanceIndex);
+                CustomDataStatement.SetBindingValueByIndex(3, Bytes);
+                CustomDataStatement.Execute();
+                CustomDataStatement.Reset();
+                CustomDataStatement.ClearBindings();
+            }
 
-    if (!InstancedMeshMap.Contains(CleanedName))
-    {
-        HISM = NewObject<UHierarchicalInstancedStaticMeshComponent>(ParentActor);
-        HISM->SetStaticMesh(MeshToUse);
-        HISM->AttachToComponent(ParentActor->GetRootComponent(), FAttachmentTransformRules::KeepWorldTransform);
-        HISM->RegisterComponent();
-        AddInstanceComponent(HISM);
-        InstancedMeshMap.Add(CleanedName, HISM);
-    }
-    else
-    {
-        HISM = InstancedMeshMap[CleanedName];
+            const FTransform& Transform = Transforms[i];
+            const FVector Location = Transform.GetLocation();
+            const FQuat Rotation = Transform.GetRotation();
+            const FVector Scale = Transform.GetScale3D();
+
+            Statement.SetBindingValueByIndex(1, CacheKey.ShapefileID);
+            Statement.SetBindingValueByIndex(2, InstanceIndex++);
+            Statement.SetBindingValueByIndex(3, MeshPath);
+            Statement.SetBindingValueByIndex(4, Location.X);
+            Statement.SetBindingValueByIndex(5, Location.Y);
+            Statement.SetBindingValueByIndex(6, Location.Z);
+            Statement.SetBindingValueByIndex(7, Rotation.X);
+            Statement.SetBindingValueByIndex(8, Rotation.Y);
+            Statement.SetBindingValueByIndex(9, Rotation.Z);
+            Statement.SetBindingValueByIndex(10, Rotation.W);
+            Statement.SetBindingValueByIndex(11, Scale.X);
+            Statement.SetBindingValueByIndex(12, Scale.Y);
+            Statement.SetBindingValueByIndex(13, Scale.Z);
+            Statement.Execute();
+            Statement.Reset();
+            Statement.ClearBindings();
+        }
     }
-    FTransform InstanceTransform(FinalRotation, WorldLocation, FinalScale);
-    HISM->AddInstance(InstanceTransform);
+
+    // Written last, so a metadata row always describes a complete set of instances
+    SQLite->Execute(FString::Printf(
+        TEXT("INSERT OR REPLACE INTO PointShapefileMetadata (ShapefileID, LastModified, FileSize, SourceKey) VALUES ('%s', %lld, %lld, '%s');"),
+        *CacheKey.ShapefileID, CacheKey.LastModified, CacheKey.FileSize, *CacheKey.SourceKey.Replace(TEXT("'"), TEXT("''"))));
+
+    SQLite->CommitTransaction();
+
+    UE_LOG(LogTemp, Log, TEXT("Cached %d point instances of %s."), InstanceIndex, *CacheKey.ShapefileID);
 }
 
 UStaticMesh* APCGPointContent::ExtractMeshFromBlueprint(TSubclassOf<AActor> BPClass)
 {
     if (!BPClass) return nullptr;
 
-    AActor* TempActor = GetWorld()->SpawnActor<AActor>(BPClass, FVector::ZeroVector, FRotator::ZeroRotator);
-    if (!TempActor) return nullptr;
+    if (const TWeakObjectPtr<UStaticMesh>* Cached = ExtractedMeshPerClass.Find(BPClass.Get()); Cached && !Cached->IsStale())
+    {
+        return Cached->Get();
+    }
 
     UStaticMesh* FoundMesh = nullptr;
-    TArray<UStaticMeshComponent*> MeshComponents;
-    TempActor->GetComponents<UStaticMeshComponent>(MeshComponents);
 
+    // Native components exist on the class default object
+    TInlineComponentArray<UStaticMeshComponent*> MeshComponents;
+    BPClass->GetDefaultObject<AActor>()->GetComponents(MeshComponents);
     for (UStaticMeshComponent* Comp : MeshComponents)
     {
         if (Comp->GetStaticMesh())
@@ -500,7 +1166,30 @@ UStaticMesh* APCGPointContent::ExtractMeshFromBlueprint(TSubclassOf<AActor> BPCl
         }
     }
 
-    TempActor->Destroy();
+    // Blueprint-added components only exist as construction script templates, walk up through the parent blueprints
+    UBlueprintGeneratedClass* ActualBPGC = Cast<UBlueprintGeneratedClass>(BPClass.Get());
+    for (UBlueprintGeneratedClass* BPGC = ActualBPGC; BPGC && !FoundMesh; BPGC = Cast<UBlueprintGeneratedClass>(BPGC->GetSuperClass()))
+    {
+        if (!BPGC->SimpleConstructionScript) continue;
+
+        for (USCS_Node* Node : BPGC->SimpleConstructionScript->GetAllNodes())
+        {
+            // Picks up child blueprint overrides of inherited templates
+            UStaticMeshComponent* Template = Node ? Cast<UStaticMeshComponent>(Node->GetActualComponentTemplate(ActualBPGC)) : nullptr;
+            if (Template && Template->GetStaticMesh())
+            {
+                FoundMesh = Template->GetStaticMesh();
+                break;
+            }
+        }
+    }
+
+    ExtractedMeshPerClass.Add(BPClass.Get(), FoundMesh);
     return FoundMesh;
 }
 
+void APCGPointContent::ResetExtractedMeshCache()
+{
+    ExtractedMeshPerClass.Reset();
+}
+
@@ -32,7 +32,24 @@ void APCGPolygonActor::DeActivatePCG()
     isActive = false;
 }
 
+void APCGPolygonActor::ResetForPool()
+{
+    PCGComponent->OnPCGGraphGeneratedExternal.Clear();
+    PCGComponent->CleanupLocal(true, true);
+    PCGComponent->SetGraph(nullptr);
+    isActive = false;
 
+    SplineComponent->ClearSplinePoints(true);
+    if (BoxCollision)
+    {
+        BoxCollision->SetBoxExtent(FVector::ZeroVector);
+    }
 
+    Data = FGrassPolygonData();
+    HoleRings.Reset();
+    FileName.Reset();
+    ID = INDEX_NONE;
 
-
+    DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+    SetActorHiddenInGame(true);
+}
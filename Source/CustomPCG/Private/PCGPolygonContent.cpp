@@ -8,14 +8,28 @@
 #include "Kismet/GameplayStatics.h"
 #include "Components/SplineComponent.h"
 #include "Components/InstancedStaticMeshComponent.h"
-#include "Components/HierarchicalInstancedStaticMeshComponent.h"    
+#include "InstanceBuilderSubsystem.h"
 #include <SQLiteDatabase.h>
+#include "PCGActorPoolSubsystem.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "CustomPCGSettings.h"
+#include "GeoreferenceBatchTransform.h"
+#include "PolygonScanlineTable.h"
+#include <atomic>
+
+// Vertices of adjacent polygons that land in the same PolygonVertexDedupeDegrees cell are the same vertex
+static FInt64Point SharedVertexCell(const FVector& LonLat, double InvQuantum)
+{
+    return FInt64Point(FMath::RoundToInt64(LonLat.X * InvQuantum), FMath::RoundToInt64(LonLat.Y * InvQuantum));
+}
 
 
 void APCGPolygonContent::Tick(float DeltaTime) {
 
     Super::Tick(DeltaTime);
 
+    DispatchPolygonPreprocessing();
 }
 
 APCGPolygonContent::APCGPolygonContent()
@@ -29,19 +43,72 @@ void APCGPolygonContent::BeginPlay() {
 
 }
 
+void APCGPolygonContent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+    // On a region change the actors go back to the pool; on world teardown they die with the world
+    if (EndPlayReason == EEndPlayReason::Destroyed || EndPlayReason == EEndPlayReason::RemovedFromWorld)
+    {
+        ReleaseSpawnedActors();
+    }
+
+    Super::EndPlay(EndPlayReason);
+}
+
+void APCGPolygonContent::ReleaseSpawnedActors()
+{
+    UPCGActorPoolSubsystem* Pool = GetWorld() ? GetWorld()->GetSubsystem<UPCGActorPoolSubsystem>() : nullptr;
+
+    for (APCGPolygonActor* PolygonActor : SpawnedPolygonActors)
+    {
+        if (!IsValid(PolygonActor)) continue;
+        if (Pool) Pool->ReleasePolygonActor(PolygonActor);
+        else PolygonActor->Destroy();
+    }
+
+    for (APolygonHiGenActor* HiGenActor : SpawnedHiGenActors)
+    {
+        if (!IsValid(HiGenActor)) continue;
+        if (Pool) Pool->ReleaseHiGenActor(HiGenActor);
+        else HiGenActor->Destroy();
+    }
+
+    SpawnedPolygonActors.Reset();
+    SpawnedHiGenActors.Reset();
+}
+
 void APCGPolygonContent::InitializeContent()
 {
     CesiumGeoreference = ACesiumGeoreference::GetDefaultGeoreference(GetWorld());
     Tileset = Cast<ACesium3DTileset>(UGameplayStatics::GetActorOfClass(GetWorld(), ACesium3DTileset::StaticClass()));
+    HeightProvider = IPCGHeightProvider::Create(GetDefault<UCustomPCGSettings>()->PolygonHeightProvider, GetWorld(), Tileset);
 
     GI = GetWorld() ? GetWorld()->GetGameInstance() : nullptr;
     DBSubsystem = GI->GetSubsystem<UPcgSQLiteSubsystem>();
+
+    const TSoftObjectPtr<UPolygonGenerationProfile>& ProfileSetting = GetDefault<UCustomPCGSettings>()->PolygonGenerationProfile;
+    GenerationProfile = ProfileSetting.LoadSynchronous();
+    if (!GenerationProfile)
+    {
+        UE_LOG(LogTemp, Log, TEXT("No polygon generation profile at %s, using automatic generation radii."), *ProfileSetting.ToString());
+    }
 }
 
 void APCGPolygonContent::InitializePCGPolygonData(const FShapeRawData& Raw)
 {
     //InitializeContent();
 
+    ParsePolygonData(Raw, PolygonDataList);
+}
+
+void APCGPolygonContent::InitializePCGPolygonData(TArray<FGrassPolygonData>&& Polygons)
+{
+    PolygonDataList = MoveTemp(Polygons);
+}
+
+void APCGPolygonContent::ParsePolygonData(const FShapeRawData& Raw, TArray<FGrassPolygonData>& OutPolygons)
+{
+    OutPolygons.Reserve(OutPolygons.Num() + Raw.Attributes.Num());
+
     for (int32 i = 0; i < Raw.Attributes.Num(); ++i)
     {
         const auto& A = Raw.Attributes[i];
@@ -86,11 +153,19 @@ void APCGPolygonContent::InitializePCGPolygonData(const FShapeRawData& Raw)
         temp.SpecificDe = GetSafeString("SpecificDe");
         temp.Foliage = GetSafeString("Foliage");
         temp.EntityEnum = A.Contains("EntityEnum") ? A["EntityEnum"] : TEXT("");
-        temp.PolygonPoints = Raw.Geometries[i];
+
+        // Outer ring plus holes; extra parts of multipart polygons are not supported by the polygon actor
+        TArray<TArray<FVector>> Rings;
+        FPolygonPreprocessor::SplitRings(Raw.Geometries[i], Rings);
+        const int32 NumDroppedRings = FPolygonPreprocessor::ClassifyRings(Rings, temp.PolygonPoints, temp.HoleRings);
+        if (NumDroppedRings > 0)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("Polygon %d (%s): ignored %d rings outside the outer ring."), temp.Id, *Raw.CollectionName, NumDroppedRings);
+        }
         temp.Area = GetSafeFloat("Area");
         temp.Pnts = GetSafeFloat("pnts");
 
-        PolygonDataList.Add(temp);
+        OutPolygons.Add(MoveTemp(temp));
     }
 }
 
@@ -258,41 +333,141 @@ void APCGPolygonContent::SpawnPCGPolygonData()
 #endif
     }
 
-    for (const FGrassPolygonData& Data : PolygonDataList)
+    SimplifyPolygonData();
+
+    if (!HeightProvider || !CesiumGeoreference)
     {
-        SpawnIndividualPCGPolygonData(Data);
+        UE_LOG(LogTemp, Error, TEXT("Missing height provider or Cesium georeference."));
+        return;
     }
 
+    SamplingReport.SamplingStartSeconds = FPlatformTime::Seconds();
+    BuildSharedVertexSampling();
+    IssueSharedVertexChunks();
+
 }
 
-static void ExtractFromHISMC(UHierarchicalInstancedStaticMeshComponent* ISMC, TArray<FBakedInstanceBatch>& Out)
+void APCGPolygonContent::SimplifyPolygonData()
 {
-    if (!ISMC || !ISMC->GetStaticMesh()) return;
+    TRACE_CPUPROFILER_EVENT_SCOPE(APCGPolygonContent::SimplifyPolygonData);
 
-    FBakedInstanceBatch Batch;
-    Batch.MeshPath = FSoftObjectPath(ISMC->GetStaticMesh());
+    const UCustomPCGSettings* Settings = GetDefault<UCustomPCGSettings>();
+    const double StartSeconds = FPlatformTime::Seconds();
 
-    const int32 MatCount = ISMC->GetNumMaterials();
-    Batch.Materials.Reserve(MatCount);
-    for (int32 i = 0; i < MatCount; ++i)
+    std::atomic<int32> VerticesBefore{ 0 };
+    std::atomic<int32> VerticesAfter{ 0 };
+
+    // Vertices on more than one polygon are never removed, so adjacent polygons keep identical shared boundaries
+    const double InvQuantum = 1.0 / FMath::Max(Settings->PolygonVertexDedupeDegrees, UE_DOUBLE_SMALL_NUMBER);
+    TSet<FInt64Point> SharedCells;
+    if (Settings->PolygonSimplificationMethod != EPolygonSimplificationMethod::None)
     {
-        if (UMaterialInterface* M = ISMC->GetMaterial(i)) Batch.Materials.Add(FSoftObjectPath(M));
-        else                                              Batch.Materials.Add(FSoftObjectPath());
+        TMap<FInt64Point, int32> FirstPolygonByCell;
+        for (int32 Index = 0; Index < PolygonDataList.Num(); ++Index)
+        {
+            const FGrassPolygonData& Data = PolygonDataList[Index];
+            auto AddRing = [&](TConstArrayView<FVector> Ring)
+                {
+                    for (const FVector& Point : Ring)
+                    {
+                        const FInt64Point Cell = SharedVertexCell(Point, InvQuantum);
+                        if (FirstPolygonByCell.FindOrAdd(Cell, Index) != Index)
+                        {
+                            SharedCells.Add(Cell);
+                        }
+                    }
+                };
+
+            AddRing(Data.PolygonPoints);
+            for (const FPolygonRing& Hole : Data.HoleRings)
+            {
+                AddRing(Hole.Points);
+            }
+        }
     }
 
-    const int32 N = ISMC->GetInstanceCount();
-    Batch.Transforms.Reserve(N);
-    for (int32 i = 0; i < N; ++i)
+    ParallelFor(PolygonDataList.Num(), [this, Settings, InvQuantum, &SharedCells, &VerticesBefore, &VerticesAfter](int32 Index)
+        {
+            FGrassPolygonData& Data = PolygonDataList[Index];
+
+            // InteriorSampleSpacing is Density * 100 cm; anything finer than a fraction of it never reaches PCG
+            const double ToleranceMeters = Data.Density * 100.0 * Settings->SimplificationToleranceFactor / 100.0;
+
+            int32 Before = Data.PolygonPoints.Num();
+            for (const FPolygonRing& Hole : Data.HoleRings)
+            {
+                Before += Hole.Points.Num();
+            }
+
+            TArray<FVector> SimplifiedOuter;
+            TArray<FPolygonRing> SimplifiedHoles;
+            FPolygonPreprocessor::SimplifyPolygon(Data.PolygonPoints, Data.HoleRings, ToleranceMeters, Settings->PolygonSimplificationMethod,
+                [&SharedCells, InvQuantum](const FVector& LonLat) { return SharedCells.Contains(SharedVertexCell(LonLat, InvQuantum)); },
+                SimplifiedOuter, SimplifiedHoles);
+
+            Data.PolygonPoints = MoveTemp(SimplifiedOuter);
+            Data.HoleRings = MoveTemp(SimplifiedHoles);
+
+            int32 After = Data.PolygonPoints.Num();
+            for (const FPolygonRing& Hole : Data.HoleRings)
+            {
+                After += Hole.Points.Num();
+            }
+
+            VerticesBefore += Before;
+            VerticesAfter += After;
+        });
+
+    SamplingReport.VerticesBefore = VerticesBefore;
+    SamplingReport.VerticesAfter = VerticesAfter;
+    SamplingReport.SimplifySeconds = FPlatformTime::Seconds() - StartSeconds;
+    SamplingReport.SampledVertices = 0;
+}
+
+void APCGPolygonContent::ReportPolygonSampling() const
+{
+    const FPolygonSamplingReport& Report = SamplingReport;
+    const double SamplingSeconds = FPlatformTime::Seconds() - Report.SamplingStartSeconds;
+    const int32 RemovedVertices = Report.VerticesBefore - Report.VerticesAfter;
+
+    // Sampling requests run concurrently, so use throughput rather than per-request latency
+    const double SecondsPerVertex = Report.SampledVertices > 0 ? SamplingSeconds / Report.SampledVertices : 0.0;
+    const double EstimatedSavedSeconds = RemovedVertices * SecondsPerVertex - Report.SimplifySeconds;
+
+    UE_LOG(LogTemp, Log, TEXT("Polygon simplification (%s): %d -> %d vertices (%.1f%% removed) in %.3f s. Height sampling took %.2f s, estimated %.2f s saved."),
+        PolygonDataList.Num() > 0 ? *PolygonDataList[0].FileName : TEXT(""),
+        Report.VerticesBefore,
+        Report.VerticesAfter,
+        Report.VerticesBefore > 0 ? 100.0 * RemovedVertices / Report.VerticesBefore : 0.0,
+        Report.SimplifySeconds,
+        SamplingSeconds,
+        EstimatedSavedSeconds);
+
+    UE_LOG(LogTemp, Log, TEXT("Polygon vertex dedupe (%s): %d ring vertices -> %d unique samples (%.2fx, %.1f%% shared)."),
+        PolygonDataList.Num() > 0 ? *PolygonDataList[0].FileName : TEXT(""),
+        Report.VerticesAfter,
+        Report.UniqueVertices,
+        Report.UniqueVertices > 0 ? (double)Report.VerticesAfter / Report.UniqueVertices : 0.0,
+        Report.VerticesAfter > 0 ? 100.0 * (Report.VerticesAfter - Report.UniqueVertices) / Report.VerticesAfter : 0.0);
+
+    if (Report.DroppedPolygons > 0)
     {
-        FTransform Xf;
-        ISMC->GetInstanceTransform(i, Xf, /*bWorldSpace*/ true);
-        Batch.Transforms.Add(Xf);
+        UE_LOG(LogTemp, Warning, TEXT("Polygon height sampling (%s): %d of %d polygons dropped for missing vertex heights."),
+            PolygonDataList.Num() > 0 ? *PolygonDataList[0].FileName : TEXT(""),
+            Report.DroppedPolygons,
+            PolygonDataList.Num());
     }
 
-    Out.Add(MoveTemp(Batch));
+    if (Report.FilledVertices > 0)
+    {
+        UE_LOG(LogTemp, Log, TEXT("Polygon height sampling (%s): %d failed vertex samples filled from their ring neighbours."),
+            PolygonDataList.Num() > 0 ? *PolygonDataList[0].FileName : TEXT(""),
+            Report.FilledVertices);
+    }
 }
 
-static void ExtractFromISMC(UInstancedStaticMeshComponent* ISMC, TArray<FBakedInstanceBatch>& Out)
+// HISMs are ISMs too, so one helper covers both
+static void ExtractFromISMC(const UInstancedStaticMeshComponent* ISMC, TArray<FBakedInstanceBatch>& Out)
 {
     if (!ISMC || !ISMC->GetStaticMesh()) return;
 
@@ -307,14 +482,7 @@ static void ExtractFromISMC(UInstancedStaticMeshComponent* ISMC, TArray<FBakedIn
         else                                              Batch.Materials.Add(FSoftObjectPath());
     }
 
-    const int32 N = ISMC->GetInstanceCount();
-    Batch.Transforms.Reserve(N);
-    for (int32 i = 0; i < N; ++i)
-    {
-        FTransform Xf;
-        ISMC->GetInstanceTransform(i, Xf, /*bWorldSpace*/ true);
-        Batch.Transforms.Add(Xf);
-    }
+    UInstanceBuilderSubsystem::ReadInstances(ISMC, Batch.Transforms);
 
     Out.Add(MoveTemp(Batch));
 }
@@ -350,6 +518,84 @@ bool APCGPolygonContent::InsertPolygonPointsToDB(
     return true;
 }
 
+const FString& APCGPolygonContent::GetCreatePolygonHolesTableSQL()
+{
+    static const FString SQL = TEXT(R"(
+        CREATE TABLE IF NOT EXISTS PolygonHoles (
+            ShapefileID TEXT,
+            PolygonID INTEGER,
+            RingIndex INTEGER,
+            PointIndex INTEGER,
+            X REAL,
+            Y REAL,
+            Z REAL,
+            PRIMARY KEY(ShapefileID, PolygonID, RingIndex, PointIndex)
+        );
+    )");
+    return SQL;
+}
+
+void APCGPolygonContent::DeletePolygonHoles(UPcgSQLiteSubsystem* SQLite, const FString& ShapefileID)
+{
+    const FString DeleteHolesSQL = FString::Printf(TEXT("DELETE FROM PolygonHoles WHERE ShapefileID='%s';"), *ShapefileID);
+    SQLite->ExecuteWithCallback(DeleteHolesSQL, [](const FSQLitePreparedStatement&) { return ESQLitePreparedStatementExecuteRowResult::Continue; });
+}
+
+void APCGPolygonContent::LoadPolygonHoles(UPcgSQLiteSubsystem* SQLite, const FString& ShapefileID, TMap<int32, TArray<FPolygonRing>>& OutHoles)
+{
+    // Ordered so points append in ring order
+    const FString HolesSQL = FString::Printf(TEXT("SELECT PolygonID, RingIndex, X, Y, Z FROM PolygonHoles WHERE ShapefileID='%s' ORDER BY PolygonID, RingIndex, PointIndex;"), *ShapefileID);
+    SQLite->ExecuteWithCallback(HolesSQL, [&](const FSQLitePreparedStatement& Statement) -> ESQLitePreparedStatementExecuteRowResult
+        {
+            int32 PolygonID = 0;
+            int32 RingIndex = 0;
+            double X = 0, Y = 0, Z = 0;
+            Statement.GetColumnValueByName(TEXT("PolygonID"), PolygonID);
+            Statement.GetColumnValueByName(TEXT("RingIndex"), RingIndex);
+            Statement.GetColumnValueByName(TEXT("X"), X);
+            Statement.GetColumnValueByName(TEXT("Y"), Y);
+            Statement.GetColumnValueByName(TEXT("Z"), Z);
+
+            TArray<FPolygonRing>& Holes = OutHoles.FindOrAdd(PolygonID);
+            if (Holes.Num() <= RingIndex) Holes.SetNum(RingIndex + 1);
+            Holes[RingIndex].Points.Add(FVector(X, Y, Z));
+
+            return ESQLitePreparedStatementExecuteRowResult::Continue;
+        });
+}
+
+bool APCGPolygonContent::InsertPolygonHolesToDB(const FString& ShapefileID, int32 PolygonID, const TArray<FPolygonRing>& WorldHoles)
+{
+    if (!GI) return false;
+    if (!DBSubsystem || !DBSubsystem->IsOpen())
+    {
+        UE_LOG(LogTemp, Error, TEXT("InsertPolygonHolesToDB: DB subsystem not available/open"));
+        return false;
+    }
+
+    DBSubsystem->BeginTransaction();
+
+    DBSubsystem->Execute(FString::Printf(TEXT("DELETE FROM PolygonHoles WHERE ShapefileID='%s' AND PolygonID=%d;"), *ShapefileID, PolygonID));
+
+    for (int32 RingIndex = 0; RingIndex < WorldHoles.Num(); ++RingIndex)
+    {
+        const TArray<FVector>& Points = WorldHoles[RingIndex].Points;
+        for (int32 i = 0; i < Points.Num(); ++i)
+        {
+            const FString SQL = FString::Printf(
+                TEXT("INSERT INTO PolygonHoles (ShapefileID, PolygonID, RingIndex, PointIndex, X, Y, Z) "
+                    "VALUES ('%s', %d, %d, %d, %f, %f, %f);"),
+                *ShapefileID, PolygonID, RingIndex, i, Points[i].X, Points[i].Y, Points[i].Z);
+
+            DBSubsystem->Execute(SQL);
+        }
+    }
+
+    DBSubsystem->CommitTransaction();
+
+    return true;
+}
+
 void APCGPolygonContent::AssignPCGGraph(UPCGComponent* TargetPCG, const FString& GraphName)
 {
     const FString GraphFolderPath = TEXT("/Game/PCGData/PolygonDataAssets");
@@ -374,135 +620,357 @@ void APCGPolygonContent::AssignPCGGraph(UPCGComponent* TargetPCG, const FString&
     }
 }
 
-void APCGPolygonContent::SpawnIndividualPCGPolygonData(const FGrassPolygonData& Data)
+void APCGPolygonContent::BuildSharedVertexSampling()
 {
-    if (!Tileset || !CesiumGeoreference)
+    TRACE_CPUPROFILER_EVENT_SCOPE(APCGPolygonContent::BuildSharedVertexSampling);
+
+    const UCustomPCGSettings* Settings = GetDefault<UCustomPCGSettings>();
+    const double InvQuantum = 1.0 / FMath::Max(Settings->PolygonVertexDedupeDegrees, UE_DOUBLE_SMALL_NUMBER);
+
+    FSharedVertexSampling& Sampling = VertexSampling;
+    Sampling = FSharedVertexSampling();
+    Sampling.ChunkSize = FMath::Max(Settings->HeightSampleChunkSize, 1);
+    Sampling.VertexToUnique.Reserve(SamplingReport.VerticesAfter);
+    Sampling.PolygonVertexStart.Reserve(PolygonDataList.Num() + 1);
+    Sampling.PolygonMaxUnique.Reserve(PolygonDataList.Num());
+
+    TMap<FInt64Point, int32> UniqueByCell;
+    UniqueByCell.Reserve(SamplingReport.VerticesAfter);
+
+    auto AddVertex = [&Sampling, &UniqueByCell, InvQuantum](const FVector& LonLat)
+        {
+            int32& Unique = UniqueByCell.FindOrAdd(SharedVertexCell(LonLat, InvQuantum), INDEX_NONE);
+            if (Unique == INDEX_NONE)
+            {
+                Unique = Sampling.UniqueLonLat.Add(LonLat);
+            }
+            Sampling.VertexToUnique.Add(Unique);
+        };
+
+    for (const FGrassPolygonData& Data : PolygonDataList)
     {
-        UE_LOG(LogTemp, Error, TEXT("Missing Cesium references."));
-        return;
+        Sampling.PolygonVertexStart.Add(Sampling.VertexToUnique.Num());
+
+        for (const FVector& Point : Data.PolygonPoints)
+        {
+            AddVertex(Point);
+        }
+        for (const FPolygonRing& Hole : Data.HoleRings)
+        {
+            for (const FVector& Point : Hole.Points)
+            {
+                AddVertex(Point);
+            }
+        }
+
+        Sampling.PolygonMaxUnique.Add(Sampling.UniqueLonLat.Num() - 1);
     }
+    Sampling.PolygonVertexStart.Add(Sampling.VertexToUnique.Num());
+
+    Sampling.UniqueUnreal.SetNumZeroed(Sampling.UniqueLonLat.Num());
+    Sampling.UniqueHeight.SetNumZeroed(Sampling.UniqueLonLat.Num());
+    Sampling.UniqueSampled.SetNumZeroed(Sampling.UniqueLonLat.Num());
+    Sampling.UniqueLost.SetNumZeroed(Sampling.UniqueLonLat.Num());
+    Sampling.ChunkDone.SetNumZeroed(FMath::DivideAndRoundUp(Sampling.UniqueLonLat.Num(), Sampling.ChunkSize));
 
-    const TArray<FVector>& Points = Data.PolygonPoints;
-    if (Points.Num() == 0)
+    SamplingReport.UniqueVertices = Sampling.UniqueLonLat.Num();
+    SamplingReport.PendingSampleRequests = Sampling.ChunkDone.Num();
+
+    if (Sampling.ChunkDone.Num() == 0)
     {
-        UE_LOG(LogTemp, Warning, TEXT("No points found in polygon data."));
-        return;
+        QueueSampledPolygons();
+        ReportPolygonSampling();
+    }
+}
+
+void APCGPolygonContent::IssueSharedVertexChunks()
+{
+    FSharedVertexSampling& Sampling = VertexSampling;
+    const int32 MaxInFlight = FMath::Max(GetDefault<UCustomPCGSettings>()->MaxHeightSampleRequestsInFlight, 1);
+
+    while (Sampling.ChunksInFlight < MaxInFlight && Sampling.NextChunk < Sampling.ChunkDone.Num())
+    {
+        const int32 ChunkIndex = Sampling.NextChunk++;
+        const int32 Start = ChunkIndex * Sampling.ChunkSize;
+        const int32 Num = FMath::Min(Sampling.ChunkSize, Sampling.UniqueLonLat.Num() - Start);
+
+        Sampling.ChunksInFlight++;
+
+        TWeakObjectPtr<APCGPolygonContent> WeakThis(this);
+        HeightProvider->SampleHeights(TArray<FVector>(Sampling.UniqueLonLat.GetData() + Start, Num),
+            [WeakThis, ChunkIndex](const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings)
+            {
+                if (APCGPolygonContent* This = WeakThis.Get())
+                {
+                    This->OnSharedVertexChunkSampled(ChunkIndex, Results);
+                }
+            });
+    }
+}
+
+void APCGPolygonContent::OnSharedVertexChunkSampled(int32 ChunkIndex, const TArray<FCesiumSampleHeightResult>& Results)
+{
+    FSharedVertexSampling& Sampling = VertexSampling;
+    const int32 Start = ChunkIndex * Sampling.ChunkSize;
+    const int32 Num = FMath::Min(Sampling.ChunkSize, Sampling.UniqueLonLat.Num() - Start);
+
+    Sampling.ChunksInFlight--;
+    Sampling.ChunkDone[ChunkIndex] = true;
+    SamplingReport.SampledVertices += Num;
+
+    if (Results.Num() == Num && CesiumGeoreference)
+    {
+        TArrayView<FVector> Unreal(Sampling.UniqueUnreal.GetData() + Start, Num);
+        for (int32 i = 0; i < Num; ++i)
+        {
+            Unreal[i] = Results[i].LongitudeLatitudeHeight;
+            Sampling.UniqueHeight[Start + i] = Results[i].LongitudeLatitudeHeight.Z;
+            Sampling.UniqueSampled[Start + i] = Results[i].SampleSuccess;
+        }
+        FGeoreferenceBatchTransform(CesiumGeoreference).LongitudeLatitudeHeightToUnreal(Unreal, Unreal);
+    }
+    else
+    {
+        // Results cannot be matched to vertices, so every polygon using one of the chunk's vertices is dropped
+        for (int32 i = 0; i < Num; ++i)
+        {
+            Sampling.UniqueLost[Start + i] = true;
+        }
+        UE_LOG(LogTemp, Error, TEXT("Sampled results (%d) do not match vertex chunk size (%d); dropping the polygons that use unique vertices [%d, %d)."),
+            Results.Num(), Num, Start, Start + Num);
     }
 
-    FCesiumSampleHeightMostDetailedCallback Callback;
-    Callback.BindLambda([this, Points, Data](ACesium3DTileset* InTileset, const TArray<FCesiumSampleHeightResult>& SampledResults, const TArray<FString>& Warnings)
+    // Chunks can return out of order; polygons are released once every chunk before theirs is back
+    while (Sampling.SampledPrefix < Sampling.UniqueLonLat.Num() && Sampling.ChunkDone[Sampling.SampledPrefix / Sampling.ChunkSize])
+    {
+        Sampling.SampledPrefix = FMath::Min(Sampling.SampledPrefix + Sampling.ChunkSize, Sampling.UniqueLonLat.Num());
+    }
+
+    QueueSampledPolygons();
+    IssueSharedVertexChunks();
+
+    if (--SamplingReport.PendingSampleRequests == 0)
+    {
+        ReportPolygonSampling();
+    }
+}
+
+void APCGPolygonContent::QueueSampledPolygons()
+{
+    FSharedVertexSampling& Sampling = VertexSampling;
+
+    while (Sampling.NextPolygon < PolygonDataList.Num() && Sampling.PolygonMaxUnique[Sampling.NextPolygon] < Sampling.SampledPrefix)
+    {
+        const int32 PolygonIndex = Sampling.NextPolygon++;
+        const FGrassPolygonData& Data = PolygonDataList[PolygonIndex];
+        if (Data.PolygonPoints.Num() == 0)
+        {
+            UE_LOG(LogTemp, Warning, TEXT("No points found in polygon data."));
+            continue;
+        }
+
+        // Vertices of a mismatched chunk have no result at all; leaving them out would change the polygon's shape
+        bool bLost = false;
+        for (int32 Vertex = Sampling.PolygonVertexStart[PolygonIndex]; Vertex < Sampling.PolygonVertexStart[PolygonIndex + 1]; ++Vertex)
         {
-            if (SampledResults.Num() != Points.Num())
+            if (Sampling.UniqueLost[Sampling.VertexToUnique[Vertex]])
             {
-                UE_LOG(LogTemp, Error, TEXT("Sampled results do not match polygon point count."));
-                return;
+                bLost = true;
+                break;
             }
+        }
+        if (bLost)
+        {
+            UE_LOG(LogTemp, Verbose, TEXT("Dropping polygon %d of %s: some of its vertices were in a mismatched sample chunk."), Data.Id, *Data.FileName);
+            SamplingReport.DroppedPolygons++;
+            continue;
+        }
 
-            TArray<FVector> AdjustedPoints;
-            for (int32 i = 0; i < SampledResults.Num(); ++i)
+        // Only the lookup and filling failed samples stay here; dedupe, bounds and spline points run on workers
+        FSampledPolygon Sampled;
+        Sampled.Data = Data;
+        Sampled.WorldPoints.Reserve(Data.PolygonPoints.Num());
+        Sampled.WorldHoles.SetNum(Data.HoleRings.Num());
+
+        int32 Vertex = Sampling.PolygonVertexStart[PolygonIndex];
+        bool bRingsSampled = true;
+        TArray<int32> Failed;
+        TArray<FVector> Filled;
+        auto AppendRing = [this, &Sampling, &Vertex, &bRingsSampled, &Failed, &Filled](int32 RingNum, TArray<FVector>& Out)
             {
-                if (SampledResults[i].SampleSuccess) {
-                    FVector UnrealPos = CesiumGeoreference->TransformLongitudeLatitudeHeightPositionToUnreal(SampledResults[i].LongitudeLatitudeHeight);
-                    AdjustedPoints.Add(UnrealPos);
+                const int32 RingStart = Vertex;
+                auto IsSampled = [&Sampling, RingStart](int32 i) { return Sampling.UniqueSampled[Sampling.VertexToUnique[RingStart + i]]; };
+
+                Failed.Reset();
+                for (int32 i = 0; i < RingNum; ++i, ++Vertex)
+                {
+                    Out.Add(Sampling.UniqueUnreal[Sampling.VertexToUnique[Vertex]]);
+                    if (!IsSampled(i))
+                    {
+                        Failed.Add(i);
+                    }
                 }
-            }
 
-            // Filter out duplicate points
-            TArray<FVector> UniquePoints;
-            for (const FVector& Pt : AdjustedPoints)
-            {
-                if (!UniquePoints.ContainsByPredicate([&](const FVector& Other)
-                    { return FVector::DistSquared(Other, Pt) < KINDA_SMALL_NUMBER; }))
+                if (Failed.Num() == 0) return;
+                if (Failed.Num() == RingNum)
                 {
-                    UniquePoints.Add(Pt);
+                    bRingsSampled = false;
+                    return;
                 }
-            }
 
-            if (UniquePoints.Num() < 3)
-            {
-                UE_LOG(LogTemp, Warning, TEXT("Polygon has fewer than 3 unique points, skipping."));
-                return;
-            }
+                // A failed vertex takes the height of its nearest sampled neighbours on either side, interpolated along the ring
+                Filled.Reset(Failed.Num());
+                for (int32 i : Failed)
+                {
+                    int32 Back = 1;
+                    while (!IsSampled((i - Back + RingNum) % RingNum)) ++Back;
+                    int32 Ahead = 1;
+                    while (!IsSampled((i + Ahead) % RingNum)) ++Ahead;
+
+                    const double BackHeight = Sampling.UniqueHeight[Sampling.VertexToUnique[RingStart + (i - Back + RingNum) % RingNum]];
+                    const double AheadHeight = Sampling.UniqueHeight[Sampling.VertexToUnique[RingStart + (i + Ahead) % RingNum]];
+                    const FVector& LonLat = Sampling.UniqueLonLat[Sampling.VertexToUnique[RingStart + i]];
+                    Filled.Emplace(LonLat.X, LonLat.Y, FMath::Lerp(BackHeight, AheadHeight, double(Back) / (Back + Ahead)));
+                }
 
+                FGeoreferenceBatchTransform(CesiumGeoreference).LongitudeLatitudeHeightToUnreal(Filled, Filled);
+                for (int32 k = 0; k < Failed.Num(); ++k)
+                {
+                    Out[Out.Num() - RingNum + Failed[k]] = Filled[k];
+                }
+                SamplingReport.FilledVertices += Failed.Num();
+            };
 
-            FVector MinPoint(FLT_MAX, FLT_MAX, FLT_MAX);
-            FVector MaxPoint(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        AppendRing(Data.PolygonPoints.Num(), Sampled.WorldPoints);
+        for (int32 Hole = 0; Hole < Data.HoleRings.Num(); ++Hole)
+        {
+            AppendRing(Data.HoleRings[Hole].Points.Num(), Sampled.WorldHoles[Hole].Points);
+        }
 
-            for (const FVector& Point : UniquePoints)
-            {
-                MinPoint = MinPoint.ComponentMin(Point);
-                MaxPoint = MaxPoint.ComponentMax(Point);
-            }
+        if (!bRingsSampled)
+        {
+            UE_LOG(LogTemp, Verbose, TEXT("Dropping polygon %d of %s: height sampling failed for every vertex of one of its rings."), Data.Id, *Data.FileName);
+            SamplingReport.DroppedPolygons++;
+            continue;
+        }
 
-            FVector BoxExtents = (MaxPoint - MinPoint) * 0.5f;
+        SampledPolygonQueue.Add(MoveTemp(Sampled));
+    }
+}
 
+void APCGPolygonContent::DispatchPolygonPreprocessing()
+{
+    if (bPreprocessingInFlight || SampledPolygonQueue.Num() == 0) return;
 
-            // Spawn APCGPolygonActor
-            FActorSpawnParameters SpawnParams;
-            SpawnParams.Owner = this;
-            SpawnParams.Name = FName(FString::Printf(TEXT("PCG Polygon Actor (%s) %d"), *Data.Name, Data.Id));
-            APCGPolygonActor* PolygonActor = GetWorld()->SpawnActor<APCGPolygonActor>(
-                APCGPolygonActor::StaticClass(),
-                UniquePoints[0],
-                FRotator::ZeroRotator,
-                SpawnParams);
+    bPreprocessingInFlight = true;
 
-            if (!PolygonActor)
-            {
-                UE_LOG(LogTemp, Error, TEXT("Failed to spawn APCGPolygonActor."));
-                return;
-            }
+    TSharedRef<TArray<FSampledPolygon>> Batch = MakeShared<TArray<FSampledPolygon>>(MoveTemp(SampledPolygonQueue));
+    SampledPolygonQueue.Reset();
+
+    TWeakObjectPtr<APCGPolygonContent> WeakThis(this);
+
+    Async(EAsyncExecution::ThreadPool, [WeakThis, Batch]()
+        {
+            TRACE_CPUPROFILER_EVENT_SCOPE(APCGPolygonContent::PreprocessPolygons);
+
+            TSharedRef<TArray<FPreparedPolygon>> Prepared = MakeShared<TArray<FPreparedPolygon>>();
+            Prepared->SetNum(Batch->Num());
+
+            ParallelFor(Batch->Num(), [&Batch, &Prepared](int32 Index)
+                {
+                    FPolygonPreprocessor::PreparePolygon((*Batch)[Index].WorldPoints, (*Batch)[Index].WorldHoles, (*Prepared)[Index]);
+                });
+
+            AsyncTask(ENamedThreads::GameThread, [WeakThis, Batch, Prepared]()
+                {
+                    APCGPolygonContent* This = WeakThis.Get();
+                    if (!This) return;
+
+                    This->bPreprocessingInFlight = false;
+
+                    for (int32 i = 0; i < Batch->Num(); ++i)
+                    {
+                        if (!(*Prepared)[i].bValid)
+                        {
+                            UE_LOG(LogTemp, Warning, TEXT("Polygon has fewer than 3 unique points, skipping."));
+                            continue;
+                        }
+
+                        This->SpawnPreparedPolygon((*Batch)[i].Data, (*Prepared)[i]);
+                    }
+                });
+        });
+}
+
+void APCGPolygonContent::SpawnPreparedPolygon(const FGrassPolygonData& Data, const FPreparedPolygon& Prepared)
+{
+    // Acquire APCGPolygonActor (pooled or freshly spawned)
+    UPCGActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UPCGActorPoolSubsystem>();
+    APCGPolygonActor* PolygonActor = Pool->AcquirePolygonActor(Prepared.Origin, this);
+
+    if (!PolygonActor)
+    {
+        UE_LOG(LogTemp, Error, TEXT("Failed to spawn APCGPolygonActor."));
+        return;
+    }
+
+    SpawnedPolygonActors.Add(PolygonActor);
 
 #if WITH_EDITOR
-            PolygonActor->SetActorLabel(FString::Printf(TEXT("PCG Polygon Actor (%s) %d"), *Data.Name, Data.Id));
+    PolygonActor->SetActorLabel(FString::Printf(TEXT("PCG Polygon Actor (%s) %d"), *Data.Name, Data.Id));
 #endif
 
-            PolygonActor->Data = Data;
-            PolygonActor->Data.BoxExtents = BoxExtents;
-            PolygonActor->InteriorSampleSpacing = Data.Density * 100.0f;
-            PolygonActor->InteriorBorderSpacing = 100.0f;
-            PolygonActor->FileName = Data.FileName;
-            PolygonActor->ID = Data.Id;
-
-            InsertPolygonFeaturesToDB(PolygonActor->Data);
+    PolygonActor->Data = Data;
+    PolygonActor->Data.BoxExtents = Prepared.BoxExtents;
+    PolygonActor->InteriorSampleSpacing = Data.Density * 100.0f;
+    PolygonActor->InteriorBorderSpacing = 100.0f;
+    PolygonActor->FileName = Data.FileName;
+    PolygonActor->ID = Data.Id;
+    PolygonActor->HoleRings = Prepared.LocalHoles;
 
-            USplineComponent* Spline = PolygonActor->SplineComponent;
-            Spline->ClearSplinePoints();
+    InsertPolygonFeaturesToDB(PolygonActor->Data);
 
-            FVector Origin = UniquePoints[0];
-            for (int32 i = 0; i < UniquePoints.Num(); ++i)
-            {
-                FVector LocalPoint = UniquePoints[i] - Origin;
-                Spline->AddSplinePoint(LocalPoint, ESplineCoordinateSpace::Local);
-                Spline->SetTangentAtSplinePoint(i, FVector::ZeroVector, ESplineCoordinateSpace::Local);
-            }
-            //  UE_LOG(LogTemp, Log, TEXT("Total Spline(%d) Points : %d"), Data.Id, Spline->GetNumberOfSplinePoints());
+    if (Prepared.LocalHoles.Num() > 0)
+    {
+        TArray<FPolygonRing> WorldHoles = Prepared.LocalHoles;
+        for (FPolygonRing& Hole : WorldHoles)
+        {
+            for (FVector& Point : Hole.Points) Point += Prepared.Origin;
+        }
+        InsertPolygonHolesToDB(Data.FileName, Data.Id, WorldHoles);
+    }
 
-            Spline->SetClosedLoop(true);
-            Spline->UpdateSpline();
+    USplineComponent* Spline = PolygonActor->SplineComponent;
+    Spline->ClearSplinePoints(false);
 
+    for (int32 i = 0; i < Prepared.LocalPoints.Num(); ++i)
+    {
+        Spline->AddSplinePoint(Prepared.LocalPoints[i], ESplineCoordinateSpace::Local, false);
+        Spline->SetTangentAtSplinePoint(i, FVector::ZeroVector, ESplineCoordinateSpace::Local, false);
+    }
+    //  UE_LOG(LogTemp, Log, TEXT("Total Spline(%d) Points : %d"), Data.Id, Spline->GetNumberOfSplinePoints());
 
-            if (IsValid(ParentActor) && IsValid(ParentActor->GetRootComponent()))
-            {
-                PolygonActor->AttachToComponent(ParentActor->GetRootComponent(), FAttachmentTransformRules::KeepWorldTransform);
-            }
+    Spline->SetClosedLoop(true, false);
+    Spline->UpdateSpline();
 
-            UPCGComponent* PCG = PolygonActor->PCGComponent;
-            PCG->SetComponentTickEnabled(false);
-            PCG->bRuntimeGenerated = true;
-            PCG->bActivated = true;
 
-            FString GraphName = Data.Model.Replace(TEXT(" "), TEXT("")).ToLower();
-            AssignPCGGraph(PCG, GraphName);
+    if (IsValid(ParentActor) && IsValid(ParentActor->GetRootComponent()))
+    {
+        PolygonActor->AttachToComponent(ParentActor->GetRootComponent(), FAttachmentTransformRules::KeepWorldTransform);
+    }
 
+    UPCGComponent* PCG = PolygonActor->PCGComponent;
+    PCG->SetComponentTickEnabled(false);
+    PCG->bRuntimeGenerated = true;
+    PCG->bActivated = true;
 
-            PCG->CleanupLocal(true, true);
-            PCG->GenerateLocal(true);
-            PCG->OnPCGGraphGeneratedExternal.AddDynamic(this, &APCGPolygonContent::OnPcgGraphGenerated);
+    FString GraphName = Data.Model.Replace(TEXT(" "), TEXT("")).ToLower();
+    AssignPCGGraph(PCG, GraphName);
 
-        });
 
-    Tileset->SampleHeightMostDetailed(Points, Callback);
+    PCG->CleanupLocal(true, true);
+    PCG->GenerateLocal(true);
+    PCG->OnPCGGraphGeneratedExternal.AddDynamic(this, &APCGPolygonContent::OnPcgGraphGenerated);
 }
 
 void APCGPolygonContent::OnPcgGraphGenerated(UPCGComponent* PCG)
@@ -515,8 +983,6 @@ void APCGPolygonContent::OnPcgGraphGenerated(UPCGComponent* PCG)
     TArray<FBakedInstanceBatch> Batches;
     for (UActorComponent* Comp : PolygonActor->GetComponents())
     {
-        if (auto* HISMC = Cast<UHierarchicalInstancedStaticMeshComponent>(Comp))
-            ExtractFromHISMC(HISMC, Batches);
         if (auto* ISMC = Cast<UInstancedStaticMeshComponent>(Comp))
             ExtractFromISMC(ISMC, Batches);
     }
@@ -561,6 +1027,8 @@ void APCGPolygonContent::SpawnHiGenActorsFromDatabase(const FString& ShapefileID
     TMap<int32, FString> PolygonMeshMap;
     TMap<int32, FString> PolygonGraphMap;
     TMap<int32, FVector> PolygonBoxExtentsMap;  
+    TMap<int32, float> PolygonDensityMap;
+    TMap<int32, TArray<FPolygonRing>> PolygonHolesMap;
 
     // Query points
     FString PointsSQL = FString::Printf(TEXT("SELECT PolygonID, X, Y, Z, MeshID FROM PolygonPoints WHERE ShapefileID='%s';"), *ShapefileID);
@@ -583,14 +1051,17 @@ void APCGPolygonContent::SpawnHiGenActorsFromDatabase(const FString& ShapefileID
         });
 
     // Query features 
-    FString FeatureSQL = FString::Printf(TEXT("SELECT PolygonID, Model FROM PolygonFeatures WHERE ShapefileID='%s';"), *ShapefileID);
+    FString FeatureSQL = FString::Printf(TEXT("SELECT PolygonID, Model, Density FROM PolygonFeatures WHERE ShapefileID='%s';"), *ShapefileID);
     DBSubsystem->ExecuteWithCallback(FeatureSQL, [&](const FSQLitePreparedStatement& Statement) -> ESQLitePreparedStatementExecuteRowResult
         {
             int32 PolygonID = 0;
             FString Model;
+            float Density = 0;
             Statement.GetColumnValueByName(TEXT("PolygonID"), PolygonID);
             Statement.GetColumnValueByName(TEXT("Model"), Model);
+            Statement.GetColumnValueByName(TEXT("Density"), Density);
             PolygonGraphMap.FindOrAdd(PolygonID) = Model;
+            PolygonDensityMap.FindOrAdd(PolygonID) = Density;
 
             return ESQLitePreparedStatementExecuteRowResult::Continue;
         });
@@ -612,6 +1083,10 @@ void APCGPolygonContent::SpawnHiGenActorsFromDatabase(const FString& ShapefileID
         });
 
 
+    LoadPolygonHoles(DBSubsystem, ShapefileID, PolygonHolesMap);
+
+    UPCGActorPoolSubsystem* Pool = GetWorld()->GetSubsystem<UPCGActorPoolSubsystem>();
+
     int32 TotalPolygons = PolygonPointsMap.Num();
     int32 HalfPolygons = TotalPolygons ;  
     int32 Counter = 0;
@@ -623,7 +1098,17 @@ void APCGPolygonContent::SpawnHiGenActorsFromDatabase(const FString& ShapefileID
 
         if (Counter >= HalfPolygons) break;
 
-        const TArray<FVector>& Points = Elem.Value;
+        TArray<FVector>& Points = Elem.Value;
+
+        // Points baked before holes were tracked may still sit inside one
+        const TArray<FPolygonRing>* Holes = PolygonHolesMap.Find(PolygonID);
+        if (Holes)
+        {
+            FPolygonScanlineTable HoleTable;
+            HoleTable.Build(*Holes);
+            Points.RemoveAll([&HoleTable](const FVector& Point) { return HoleTable.Contains(Point); });
+        }
+
         if (Points.Num() == 0)
         {
             UE_LOG(LogTemp, Warning, TEXT("Polygon %d has no points; skipping."), PolygonID);
@@ -635,16 +1120,10 @@ void APCGPolygonContent::SpawnHiGenActorsFromDatabase(const FString& ShapefileID
         const FVector& BoxExtents = PolygonBoxExtentsMap.FindRef(PolygonID);  
 
         FString ActorName = FString::Printf(TEXT("HiGenActor_Polygon_%d"), PolygonID);
-        FActorSpawnParameters Params;
-        Params.Owner = this;
 
         FVector Location = Points[0];
 
-        APolygonHiGenActor* HiGenActor = GetWorld()->SpawnActor<APolygonHiGenActor>(
-            APolygonHiGenActor::StaticClass(),
-            Location,
-            FRotator::ZeroRotator,
-            Params);
+        APolygonHiGenActor* HiGenActor = Pool->AcquireHiGenActor(Location, this);
 
         if (!IsValid(HiGenActor))
         {
@@ -652,6 +1131,8 @@ void APCGPolygonContent::SpawnHiGenActorsFromDatabase(const FString& ShapefileID
             continue;
         }
 
+        SpawnedHiGenActors.Add(HiGenActor);
+
 #if WITH_EDITOR
         HiGenActor->SetActorLabel(ActorName);
 #endif
@@ -663,12 +1144,17 @@ void APCGPolygonContent::SpawnHiGenActorsFromDatabase(const FString& ShapefileID
 
         HiGenActor->PolygonID = PolygonID;
         HiGenActor->Positions = Points;
+        HiGenActor->HoleRings = Holes ? *Holes : TArray<FPolygonRing>();
         HiGenActor->BoxExtents = BoxExtents;
+        HiGenActor->Density = PolygonDensityMap.FindRef(PolygonID);
 
         FString GraphName = ModelName.Replace(TEXT(" "), TEXT("")).ToLower();
         HiGenActor->GraphName = GraphName;
         HiGenActor->AssignHiGenGraph();
 
+        const UPolygonGenerationProfile* Profile = GenerationProfile ? GenerationProfile : GetDefault<UPolygonGenerationProfile>();
+        HiGenActor->ApplyGenerationSettings(Profile->ResolveSettings(GraphName, HiGenActor->Density, BoxExtents));
+
         Counter++; 
     }
 }
@@ -0,0 +1,136 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PCGPolygonInteriorSamplerSettings.h"
+#include "Data/PCGPointData.h"
+#include "Helpers/PCGHelpers.h"
+#include "PCGComponent.h"
+#include "PCGPolygonActor.h"
+#include "PolygonInteriorSampler.h"
+#include "CustomPCGSettings.h"
+#include "FeatureCustomData.h"
+#include "Metadata/PCGMetadata.h"
+#include "Metadata/PCGMetadataAttributeTpl.h"
+
+TArray<FPCGPinProperties> UPCGPolygonInteriorSamplerSettings::InputPinProperties() const
+{
+	return {};
+}
+
+TArray<FPCGPinProperties> UPCGPolygonInteriorSamplerSettings::OutputPinProperties() const
+{
+	return { FPCGPinProperties(PCGPinConstants::DefaultOutputLabel, EPCGDataType::Point) };
+}
+
+FPCGElementPtr UPCGPolygonInteriorSamplerSettings::CreateElement() const
+{
+	return MakeShared<FPCGPolygonInteriorSamplerElement>();
+}
+
+UPCGPointData* FPCGPolygonInteriorSamplerElement::SamplePolygonActor(const APCGPolygonActor* Actor, float Spacing, float Jitter, bool bExcludeHoles, int32 Seed, UObject* Outer)
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FPCGPolygonInteriorSamplerElement::SamplePolygonActor);
+
+	if (!Actor || !Actor->SplineComponent || Spacing <= 0.0f) return nullptr;
+
+	const USplineComponent* Spline = Actor->SplineComponent;
+	const int32 NumSplinePoints = Spline->GetNumberOfSplinePoints();
+	if (NumSplinePoints < 3) return nullptr;
+
+	// Triangulate in world space so the jitter grid lines up across neighbouring polygons
+	TArray<FVector> OuterRing;
+	OuterRing.Reserve(NumSplinePoints);
+	for (int32 i = 0; i < NumSplinePoints; ++i)
+	{
+		OuterRing.Add(Spline->GetLocationAtSplinePoint(i, ESplineCoordinateSpace::World));
+	}
+
+	TArray<FPolygonRing> WorldHoles;
+	if (bExcludeHoles)
+	{
+		const FTransform& ActorTransform = Actor->GetActorTransform();
+		WorldHoles.Reserve(Actor->HoleRings.Num());
+		for (const FPolygonRing& Hole : Actor->HoleRings)
+		{
+			FPolygonRing& WorldHole = WorldHoles.AddDefaulted_GetRef();
+			WorldHole.Points.Reserve(Hole.Points.Num());
+			for (const FVector& Point : Hole.Points)
+			{
+				WorldHole.Points.Add(ActorTransform.TransformPosition(Point));
+			}
+		}
+	}
+
+	FTriangulatedPolygon Polygon;
+	if (!FPolygonInteriorSampler::Triangulate(OuterRing, WorldHoles, Polygon))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("PolygonInteriorSampler: Failed to triangulate polygon %d"), Actor->Data.Id);
+		return nullptr;
+	}
+
+	TArray<FVector> Locations;
+	FPolygonInteriorSampler::SamplePoints(Polygon, Spacing, Jitter, Seed, Locations);
+
+	UPCGPointData* OutputData = NewObject<UPCGPointData>(Outer);
+	TArray<FPCGPoint>& Points = OutputData->GetMutablePoints();
+	Points.SetNum(Locations.Num());
+
+	const FVector HalfExtents(Spacing * 0.5f, Spacing * 0.5f, 0.0);
+	for (int32 i = 0; i < Locations.Num(); ++i)
+	{
+		FPCGPoint& Point = Points[i];
+		Point.Transform.SetLocation(Locations[i]);
+		Point.SetExtents(HalfExtents);
+		Point.Seed = PCGHelpers::ComputeSeedFromPosition(Locations[i]);
+	}
+
+	// Every point of the polygon shares its custom data, so the attribute default carries it without per-point entries.
+	// The graph's spawner maps these to PerInstanceCustomData; the generated components are never touched afterwards
+	const TArray<FInstanceCustomDataSlot>& Slots = GetDefault<UCustomPCGSettings>()->PolygonInstanceCustomData;
+	if (Slots.Num() > 0)
+	{
+		TArray<float, TInlineAllocator<8>> Values;
+		Values.SetNumUninitialized(Slots.Num());
+		FFeatureCustomData::ForPolygon(Actor->Data, Slots, Values);
+
+		for (int32 Slot = 0; Slot < Slots.Num(); ++Slot)
+		{
+			OutputData->Metadata->CreateAttribute<float>(FFeatureCustomData::SlotAttributeName(Slot), Values[Slot], /*bAllowsInterpolation=*/false, /*bOverrideParent=*/true);
+		}
+	}
+
+	return OutputData;
+}
+
+bool FPCGPolygonInteriorSamplerElement::ExecuteInternal(FPCGContext* Context) const
+{
+	TRACE_CPUPROFILER_EVENT_SCOPE(FPCGPolygonInteriorSamplerElement::Execute);
+	check(Context);
+
+	const UPCGPolygonInteriorSamplerSettings* Settings = Context->GetInputSettings<UPCGPolygonInteriorSamplerSettings>();
+	check(Settings);
+
+	UPCGComponent* SourceComponent = Context->SourceComponent.Get();
+	if (!SourceComponent)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("PolygonInteriorSampler: Invalid SourceComponent"));
+		return true;
+	}
+
+	const APCGPolygonActor* PolygonActor = Cast<APCGPolygonActor>(SourceComponent->GetOwner());
+	if (!PolygonActor)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("PolygonInteriorSampler: Owner is not an APCGPolygonActor"));
+		return true;
+	}
+
+	const float Spacing = Settings->PointSpacing > 0.0f ? Settings->PointSpacing : PolygonActor->InteriorSampleSpacing;
+
+	UPCGPointData* OutputData = SamplePolygonActor(PolygonActor, Spacing, Settings->Jitter, Settings->bExcludeHoles, Context->GetSeed(), SourceComponent);
+	if (!OutputData) return true;
+
+	FPCGTaggedData& Output = Context->OutputData.TaggedData.AddDefaulted_GetRef();
+	Output.Data = OutputData;
+
+	return true;
+}
@@ -61,13 +61,13 @@ bool UPcgSQLiteSubsystem::IsOpen() const
 
 bool UPcgSQLiteSubsystem::Execute(const FString& Sql)
 {
-   // Lock();
+    Lock();
     bool bOk = DB.Execute(*Sql);
     if (!bOk)
     {
         UE_LOG(LogTemp, Error, TEXT("PcgSQLiteSubsystem::Execute failed: %s"), *Sql);
     }
-   // Unlock();
+    Unlock();
     return bOk;
 }
 
@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PolygonGenerationProfile.h"
+
+static void SetGenerationRadiusForGrid(FPCGRuntimeGenerationRadii& Radii, EPCGHiGenGrid Grid, double Radius)
+{
+    switch (Grid)
+    {
+    case EPCGHiGenGrid::Grid4:    Radii.GenerationRadius400 = Radius; break;
+    case EPCGHiGenGrid::Grid8:    Radii.GenerationRadius800 = Radius; break;
+    case EPCGHiGenGrid::Grid16:   Radii.GenerationRadius1600 = Radius; break;
+    case EPCGHiGenGrid::Grid32:   Radii.GenerationRadius3200 = Radius; break;
+    case EPCGHiGenGrid::Grid64:   Radii.GenerationRadius6400 = Radius; break;
+    case EPCGHiGenGrid::Grid128:  Radii.GenerationRadius12800 = Radius; break;
+    case EPCGHiGenGrid::Grid256:  Radii.GenerationRadius25600 = Radius; break;
+    case EPCGHiGenGrid::Grid512:  Radii.GenerationRadius51200 = Radius; break;
+    case EPCGHiGenGrid::Grid1024: Radii.GenerationRadius102400 = Radius; break;
+    case EPCGHiGenGrid::Grid2048: Radii.GenerationRadius204800 = Radius; break;
+    default: break;
+    }
+}
+
+FPCGRuntimeGenerationRadii FPolygonGenerationSettings::ToGenerationRadii() const
+{
+    FPCGRuntimeGenerationRadii Radii;
+    Radii.GenerationRadius = GenerationRadius;
+    // Every grid level, so the radius applies whichever levels the model's graph generates on
+    for (uint32 GridValue = static_cast<uint32>(EPCGHiGenGrid::Grid4); GridValue <= static_cast<uint32>(EPCGHiGenGrid::Grid2048); GridValue *= 2)
+    {
+        SetGenerationRadiusForGrid(Radii, static_cast<EPCGHiGenGrid>(GridValue), GenerationRadius);
+    }
+    Radii.CleanupRadiusMultiplier = CleanupRadiusMultiplier;
+    return Radii;
+}
+
+FPolygonGenerationSettings UPolygonGenerationProfile::ResolveSettings(const FString& ModelName, float Density, const FVector& BoxExtents) const
+{
+    if (const FPolygonGenerationSettings* Found = ModelSettings.Find(ModelName))
+    {
+        return *Found;
+    }
+
+    return ComputeAutomaticSettings(Density, BoxExtents);
+}
+
+FPolygonGenerationSettings UPolygonGenerationProfile::ComputeAutomaticSettings(float Density, const FVector& BoxExtents) const
+{
+    // Same spacing the polygon actor samples with (InteriorSampleSpacing = Density * 100)
+    const double Spacing = FMath::Max(Density * 100.0, 1.0);
+    const double Budget = FMath::Max(MaxInstancesAroundCamera, 1);
+
+    // A disc of radius R holds about PI * R^2 / Spacing^2 instances
+    double Radius = Spacing * FMath::Sqrt(Budget / PI);
+
+    // The whole polygon fits in the budget, no reason to hold generation back
+    const double PolygonInstances = (4.0 * BoxExtents.X * BoxExtents.Y) / (Spacing * Spacing);
+    if (PolygonInstances <= Budget)
+    {
+        Radius = MaxGenerationRadius;
+    }
+
+    Radius = FMath::Clamp(Radius, (double)MinGenerationRadius, (double)FMath::Max(MinGenerationRadius, MaxGenerationRadius));
+
+    FPolygonGenerationSettings Settings;
+    Settings.GenerationRadius = Radius;
+    Settings.CleanupRadiusMultiplier = DefaultCleanupRadiusMultiplier;
+    return Settings;
+}
@@ -45,6 +45,31 @@ void APolygonHiGenActor::AssignHiGenGraph()
     PCGComponent->SetGraph(Graph);
 }
 
+void APolygonHiGenActor::ApplyGenerationSettings(const FPolygonGenerationSettings& Settings)
+{
+    if (!PCGComponent) return;
+
+    PCGComponent->bOverrideGenerationRadii = true;
+    PCGComponent->GenerationRadii = Settings.ToGenerationRadii();
+}
+
+void APolygonHiGenActor::ResetForPool()
+{
+    PCGComponent->Cleanup();
+    PCGComponent->SetGraph(nullptr);
+
+    BoxExtents = FVector::ZeroVector;
+    BoxComponent->SetBoxExtent(BoxExtents);
+    Positions.Reset();
+    HoleRings.Reset();
+    PolygonID = INDEX_NONE;
+    Density = 0.0f;
+    GraphName.Reset();
+
+    DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+    SetActorHiddenInGame(true);
+}
+
 void APolygonHiGenActor::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
     PCGComponent->Cleanup();
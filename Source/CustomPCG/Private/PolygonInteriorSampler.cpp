@@ -0,0 +1,269 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PolygonInteriorSampler.h"
+#include "Algo/Reverse.h"
+#include "Async/ParallelFor.h"
+#include "CompGeom/Delaunay2.h"
+#include "Curve/GeneralPolygon2.h"
+#include "Math/VectorRegister.h"
+
+namespace PolygonInteriorSampler
+{
+    // Stable per-cell random value in [0, 1)
+    static float CellRandom(int64 CellX, int64 CellY, int32 Seed, uint32 Channel)
+    {
+        uint32 Hash = HashCombineFast(GetTypeHash(CellX), GetTypeHash(CellY));
+        Hash = HashCombineFast(Hash, GetTypeHash(Seed));
+        Hash = HashCombineFast(Hash, Channel);
+        // Final avalanche so neighbouring cells do not correlate
+        Hash ^= Hash >> 16;
+        Hash *= 0x7feb352dU;
+        Hash ^= Hash >> 15;
+        Hash *= 0x846ca68bU;
+        Hash ^= Hash >> 16;
+        return (Hash >> 8) * (1.0f / 16777216.0f);
+    }
+
+    // Edge function of P against Q0->Q1, computed with the endpoints in a fixed (Y, X) order so the two
+    // triangles sharing an edge get exactly opposite values. Top-left rule: for a counter-clockwise
+    // triangle the edges walked from the higher endpoint (left edges, and top edges running -X) own
+    // the points lying exactly on them.
+    static double SharedEdgeFunction(const FVector& Q0, const FVector& Q1, double PX, double PY, bool& bOwned)
+    {
+        bOwned = Q0.Y > Q1.Y || (Q0.Y == Q1.Y && Q0.X > Q1.X);
+        const FVector& Lo = bOwned ? Q1 : Q0;
+        const FVector& Hi = bOwned ? Q0 : Q1;
+        const double E = (Hi.X - Lo.X) * (PY - Lo.Y) - (Hi.Y - Lo.Y) * (PX - Lo.X);
+        return bOwned ? -E : E;
+    }
+
+    // Half-open point-in-triangle test for a counter-clockwise triangle; a point on a shared edge or vertex
+    // is inside exactly one of the triangles around it
+    static bool IsInsideTopLeft(const FVector& A, const FVector& B, const FVector& C, double PX, double PY)
+    {
+        const FVector* Edges[3][2] = { { &A, &B }, { &B, &C }, { &C, &A } };
+        for (const auto& Edge : Edges)
+        {
+            bool bOwned = false;
+            const double E = SharedEdgeFunction(*Edge[0], *Edge[1], PX, PY, bOwned);
+            if (E < 0.0 || (E == 0.0 && !bOwned)) return false;
+        }
+        return true;
+    }
+
+    static UE::Geometry::FPolygon2d ToPolygon2d(TConstArrayView<FVector> Ring)
+    {
+        UE::Geometry::FPolygon2d Polygon;
+        for (const FVector& Point : Ring)
+        {
+            Polygon.AppendVertex(FVector2d(Point.X, Point.Y));
+        }
+        return Polygon;
+    }
+}
+
+bool FPolygonInteriorSampler::Triangulate(TConstArrayView<FVector> OuterRing, TConstArrayView<FPolygonRing> Holes, FTriangulatedPolygon& OutPolygon)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FPolygonInteriorSampler::Triangulate);
+
+    using namespace UE::Geometry;
+
+    OutPolygon = FTriangulatedPolygon();
+    if (OuterRing.Num() < 3) return false;
+
+    FPolygon2d Outer = PolygonInteriorSampler::ToPolygon2d(OuterRing);
+    const bool bOuterReversed = Outer.IsClockwise();
+    if (bOuterReversed)
+    {
+        Outer.Reverse();
+    }
+
+    FGeneralPolygon2d GeneralPolygon(Outer);
+
+    // Heights for the original vertices, in the order the triangulator sees them (outer, then holes)
+    TArray<double> Heights;
+    Heights.Reserve(OuterRing.Num());
+    for (const FVector& Point : OuterRing) Heights.Add(Point.Z);
+    if (bOuterReversed)
+    {
+        Algo::Reverse(Heights);
+    }
+
+    for (const FPolygonRing& HoleRing : Holes)
+    {
+        if (HoleRing.Points.Num() < 3) continue;
+
+        FPolygon2d Hole = PolygonInteriorSampler::ToPolygon2d(HoleRing.Points);
+        const bool bReversed = !Hole.IsClockwise();
+        if (bReversed)
+        {
+            Hole.Reverse();
+        }
+
+        GeneralPolygon.AddHole(Hole, false, false);
+
+        const int32 First = Heights.Num();
+        for (const FVector& Point : HoleRing.Points) Heights.Add(Point.Z);
+        if (bReversed)
+        {
+            TArrayView<double> HoleHeights = MakeArrayView(Heights).Slice(First, HoleRing.Points.Num());
+            Algo::Reverse(HoleHeights);
+        }
+    }
+
+    FDelaunay2 Delaunay;
+    TArray<FIndex3i> Triangles;
+    TArray<FVector2d> Vertices;
+    if (!Delaunay.Triangulate(GeneralPolygon, &Triangles, &Vertices, true) || Triangles.Num() == 0)
+    {
+        return false;
+    }
+
+    // The triangulator may merge or add vertices; fall back to the mean ring height when it does
+    const bool bHeightsMatch = Vertices.Num() == Heights.Num();
+    double MeanHeight = 0.0;
+    for (double Height : Heights) MeanHeight += Height;
+    MeanHeight /= FMath::Max(Heights.Num(), 1);
+
+    OutPolygon.Vertices.SetNumUninitialized(Vertices.Num());
+    for (int32 i = 0; i < Vertices.Num(); ++i)
+    {
+        OutPolygon.Vertices[i] = FVector(Vertices[i].X, Vertices[i].Y, bHeightsMatch ? Heights[i] : MeanHeight);
+    }
+
+    OutPolygon.Triangles.Reserve(Triangles.Num());
+    for (const FIndex3i& Triangle : Triangles)
+    {
+        const FVector& A = OutPolygon.Vertices[Triangle.A];
+        const FVector& B = OutPolygon.Vertices[Triangle.B];
+        const FVector& C = OutPolygon.Vertices[Triangle.C];
+        const double SignedArea = 0.5 * ((B.X - A.X) * (C.Y - A.Y) - (B.Y - A.Y) * (C.X - A.X));
+        if (FMath::IsNearlyZero(SignedArea)) continue;
+
+        // Counter-clockwise so the inside test is "all edge functions >= 0"
+        OutPolygon.Triangles.Add(SignedArea > 0.0 ? FIntVector(Triangle.A, Triangle.B, Triangle.C) : FIntVector(Triangle.A, Triangle.C, Triangle.B));
+        OutPolygon.Area += FMath::Abs(SignedArea);
+    }
+
+    return OutPolygon.Triangles.Num() > 0;
+}
+
+void FPolygonInteriorSampler::SamplePoints(const FTriangulatedPolygon& Polygon, double Spacing, float Jitter, int32 Seed, TArray<FVector>& OutPoints)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FPolygonInteriorSampler::SamplePoints);
+
+    OutPoints.Reset();
+    if (Spacing <= 0.0 || Polygon.Triangles.Num() == 0) return;
+
+    Jitter = FMath::Clamp(Jitter, 0.0f, 1.0f);
+    const double InvSpacing = 1.0 / Spacing;
+
+    TArray<TArray<FVector>> PointsPerTriangle;
+    PointsPerTriangle.SetNum(Polygon.Triangles.Num());
+
+    ParallelFor(Polygon.Triangles.Num(), [&](int32 TriangleIndex)
+        {
+            const FIntVector& Triangle = Polygon.Triangles[TriangleIndex];
+            const FVector& A = Polygon.Vertices[Triangle.X];
+            const FVector& B = Polygon.Vertices[Triangle.Y];
+            const FVector& C = Polygon.Vertices[Triangle.Z];
+
+            const int64 MinCellX = FMath::FloorToInt64(FMath::Min3(A.X, B.X, C.X) * InvSpacing);
+            const int64 MaxCellX = FMath::FloorToInt64(FMath::Max3(A.X, B.X, C.X) * InvSpacing);
+            const int64 MinCellY = FMath::FloorToInt64(FMath::Min3(A.Y, B.Y, C.Y) * InvSpacing);
+            const int64 MaxCellY = FMath::FloorToInt64(FMath::Max3(A.Y, B.Y, C.Y) * InvSpacing);
+
+            // Edge functions are evaluated relative to A in float, which keeps precision on large polygons
+            const float BX = float(B.X - A.X), BY = float(B.Y - A.Y);
+            const float CX = float(C.X - A.X), CY = float(C.Y - A.Y);
+            const float DoubleArea = BX * CY - BY * CX;
+            if (DoubleArea <= 0.0f) return;
+
+            // E(P) = (Q1 - Q0) x (P - Q0) for the three edges AB, BC, CA
+            const VectorRegister4Float EdgeABdx = VectorSetFloat1(BX), EdgeABdy = VectorSetFloat1(BY);
+            const VectorRegister4Float EdgeBCdx = VectorSetFloat1(CX - BX), EdgeBCdy = VectorSetFloat1(CY - BY);
+            const VectorRegister4Float EdgeCAdx = VectorSetFloat1(-CX), EdgeCAdy = VectorSetFloat1(-CY);
+            const VectorRegister4Float VBX = VectorSetFloat1(BX), VBY = VectorSetFloat1(BY);
+            const VectorRegister4Float VCX = VectorSetFloat1(CX), VCY = VectorSetFloat1(CY);
+            // Float edge values this close to zero may have the wrong sign; those lanes are settled exactly
+            const float Extent = FMath::Max(FMath::Max(FMath::Abs(BX), FMath::Abs(BY)), FMath::Max(FMath::Abs(CX), FMath::Abs(CY)));
+            const float EdgeEpsilon = Extent * Extent * 1e-5f;
+            const VectorRegister4Float NegEpsilon = VectorSetFloat1(-EdgeEpsilon);
+            const VectorRegister4Float PosEpsilon = VectorSetFloat1(EdgeEpsilon);
+
+            TArray<FVector>& Points = PointsPerTriangle[TriangleIndex];
+            Points.Reserve(FMath::CeilToInt32(0.5 * DoubleArea * InvSpacing * InvSpacing) + 4);
+
+            const double JitterScale = Jitter * Spacing;
+            const double JitterOffset = 0.5 * (1.0 - Jitter) * Spacing;
+
+            for (int64 CellY = MinCellY; CellY <= MaxCellY; ++CellY)
+            {
+                for (int64 CellX = MinCellX; CellX <= MaxCellX; CellX += 4)
+                {
+                    double CandidateX[4], CandidateY[4];
+                    float LocalX[4], LocalY[4];
+                    for (int32 Lane = 0; Lane < 4; ++Lane)
+                    {
+                        const int64 LaneCellX = CellX + Lane;
+                        CandidateX[Lane] = LaneCellX * Spacing + JitterOffset + JitterScale * PolygonInteriorSampler::CellRandom(LaneCellX, CellY, Seed, 0);
+                        CandidateY[Lane] = CellY * Spacing + JitterOffset + JitterScale * PolygonInteriorSampler::CellRandom(LaneCellX, CellY, Seed, 1);
+                        LocalX[Lane] = float(CandidateX[Lane] - A.X);
+                        LocalY[Lane] = float(CandidateY[Lane] - A.Y);
+                    }
+
+                    const VectorRegister4Float PX = VectorLoad(LocalX);
+                    const VectorRegister4Float PY = VectorLoad(LocalY);
+
+                    // AB: ABdx * Py - ABdy * Px
+                    const VectorRegister4Float E0 = VectorSubtract(VectorMultiply(EdgeABdx, PY), VectorMultiply(EdgeABdy, PX));
+                    // BC: BCdx * (Py - By) - BCdy * (Px - Bx)
+                    const VectorRegister4Float E1 = VectorSubtract(VectorMultiply(EdgeBCdx, VectorSubtract(PY, VBY)), VectorMultiply(EdgeBCdy, VectorSubtract(PX, VBX)));
+                    // CA: CAdx * (Py - Cy) - CAdy * (Px - Cx)
+                    const VectorRegister4Float E2 = VectorSubtract(VectorMultiply(EdgeCAdx, VectorSubtract(PY, VCY)), VectorMultiply(EdgeCAdy, VectorSubtract(PX, VCX)));
+
+                    const VectorRegister4Float Inside = VectorBitwiseAnd(VectorBitwiseAnd(VectorCompareGE(E0, NegEpsilon), VectorCompareGE(E1, NegEpsilon)), VectorCompareGE(E2, NegEpsilon));
+                    const VectorRegister4Float ClearlyInside = VectorBitwiseAnd(VectorBitwiseAnd(VectorCompareGT(E0, PosEpsilon), VectorCompareGT(E1, PosEpsilon)), VectorCompareGT(E2, PosEpsilon));
+                    int32 InsideMask = VectorMaskBits(Inside);
+                    const int32 ClearlyInsideMask = VectorMaskBits(ClearlyInside);
+
+                    // Lanes past the triangle's last cell column are padding
+                    const int64 ValidLanes = FMath::Min<int64>(4, MaxCellX - CellX + 1);
+                    InsideMask &= (1 << ValidLanes) - 1;
+
+                    if (InsideMask == 0) continue;
+
+                    float E1Values[4], E2Values[4];
+                    VectorStore(E1, E1Values);
+                    VectorStore(E2, E2Values);
+
+                    for (int32 Lane = 0; Lane < 4; ++Lane)
+                    {
+                        if (!(InsideMask & (1 << Lane))) continue;
+
+                        // Near an edge: half-open test so samples on edges shared with neighbouring triangles are emitted once
+                        if (!(ClearlyInsideMask & (1 << Lane)) && !PolygonInteriorSampler::IsInsideTopLeft(A, B, C, CandidateX[Lane], CandidateY[Lane])) continue;
+
+                        // Barycentric weights come straight from the edge functions
+                        const double WeightA = E1Values[Lane] / DoubleArea;
+                        const double WeightB = E2Values[Lane] / DoubleArea;
+                        const double WeightC = 1.0 - WeightA - WeightB;
+                        const double Z = WeightA * A.Z + WeightB * B.Z + WeightC * C.Z;
+
+                        Points.Emplace(CandidateX[Lane], CandidateY[Lane], Z);
+                    }
+                }
+            }
+        });
+
+    int32 TotalPoints = 0;
+    for (const TArray<FVector>& Points : PointsPerTriangle) TotalPoints += Points.Num();
+
+    // Concatenate in triangle order so the output does not depend on thread scheduling
+    OutPoints.Reserve(TotalPoints);
+    for (const TArray<FVector>& Points : PointsPerTriangle)
+    {
+        OutPoints.Append(Points);
+    }
+}
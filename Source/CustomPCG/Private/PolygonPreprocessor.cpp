@@ -0,0 +1,612 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PolygonPreprocessor.h"
+#include "PolygonScanlineTable.h"
+
+namespace PolygonPreprocessor
+{
+    struct FVertexCell
+    {
+        int64 X = 0;
+        int64 Y = 0;
+        int64 Z = 0;
+
+        static FVertexCell FromPoint(const FVector& Point, double InvCellSize)
+        {
+            return { FMath::FloorToInt64(Point.X * InvCellSize), FMath::FloorToInt64(Point.Y * InvCellSize), FMath::FloorToInt64(Point.Z * InvCellSize) };
+        }
+
+        bool operator==(const FVertexCell& Other) const { return X == Other.X && Y == Other.Y && Z == Other.Z; }
+
+        friend uint32 GetTypeHash(const FVertexCell& Cell)
+        {
+            return HashCombineFast(HashCombineFast(GetTypeHash(Cell.X), GetTypeHash(Cell.Y)), GetTypeHash(Cell.Z));
+        }
+    };
+
+    // Meters per degree of latitude on the WGS84 equatorial radius
+    constexpr double MetersPerDegree = 6378137.0 * UE_DOUBLE_PI / 180.0;
+
+    // Local equirectangular projection around Origin, accurate enough for tolerance tests
+    static void ProjectToMeters(TConstArrayView<FVector> LonLat, const FVector& Origin, TArray<FVector2D>& OutMeters)
+    {
+        OutMeters.SetNumUninitialized(LonLat.Num());
+        if (LonLat.Num() == 0) return;
+
+        const double LonScale = MetersPerDegree * FMath::Cos(FMath::DegreesToRadians(Origin.Y));
+
+        for (int32 i = 0; i < LonLat.Num(); ++i)
+        {
+            OutMeters[i] = FVector2D((LonLat[i].X - Origin.X) * LonScale, (LonLat[i].Y - Origin.Y) * MetersPerDegree);
+        }
+    }
+
+    static double PointSegmentDistSquared(const FVector2D& P, const FVector2D& A, const FVector2D& B)
+    {
+        const FVector2D AB = B - A;
+        const double LengthSquared = AB.SizeSquared();
+        if (LengthSquared <= UE_DOUBLE_SMALL_NUMBER)
+        {
+            return FVector2D::DistSquared(P, A);
+        }
+
+        const double T = FMath::Clamp(FVector2D::DotProduct(P - A, AB) / LengthSquared, 0.0, 1.0);
+        return FVector2D::DistSquared(P, A + AB * T);
+    }
+
+    static double TriangleArea(const FVector2D& A, const FVector2D& B, const FVector2D& C)
+    {
+        return 0.5 * FMath::Abs(FVector2D::CrossProduct(B - A, C - A));
+    }
+
+    // Keep[i] for a closed ring of N vertices; vertices set in Locked are always kept
+    static void DouglasPeuckerRing(const TArray<FVector2D>& Ring, double Tolerance, const TBitArray<>& Locked, TArray<int32>& Anchors, TBitArray<>& Keep)
+    {
+        const int32 N = Ring.Num();
+        Keep.Init(false, N);
+
+        Anchors.Reset();
+        for (TConstSetBitIterator<> It(Locked); It; ++It)
+        {
+            Anchors.Add(It.GetIndex());
+        }
+
+        // Without two locked vertices, split the ring at its start and the vertex farthest from it
+        if (Anchors.Num() < 2)
+        {
+            const int32 Start = Anchors.Num() == 1 ? Anchors[0] : 0;
+            int32 Farthest = Start;
+            double FarthestDistSquared = -1.0;
+            for (int32 i = 0; i < N; ++i)
+            {
+                const double DistSquared = FVector2D::DistSquared(Ring[Start], Ring[i]);
+                if (i != Start && DistSquared > FarthestDistSquared)
+                {
+                    FarthestDistSquared = DistSquared;
+                    Farthest = i;
+                }
+            }
+
+            Anchors.Reset();
+            Anchors.Add(FMath::Min(Start, Farthest));
+            Anchors.Add(FMath::Max(Start, Farthest));
+        }
+
+        auto At = [&Ring, N](int32 Index) -> const FVector2D& { return Ring[Index % N]; };
+        const double ToleranceSquared = Tolerance * Tolerance;
+
+        // Open DP between consecutive anchors; index i stands for vertex i % N, so the last span closes the ring
+        TArray<TPair<int32, int32>> Stack;
+        for (int32 i = 0; i < Anchors.Num(); ++i)
+        {
+            Keep[Anchors[i]] = true;
+            Stack.Emplace(Anchors[i], i + 1 < Anchors.Num() ? Anchors[i + 1] : Anchors[0] + N);
+        }
+
+        while (Stack.Num() > 0)
+        {
+            const TPair<int32, int32> Range = Stack.Pop(EAllowShrinking::No);
+
+            int32 Split = INDEX_NONE;
+            double MaxDistSquared = ToleranceSquared;
+            for (int32 i = Range.Key + 1; i < Range.Value; ++i)
+            {
+                const double DistSquared = PointSegmentDistSquared(At(i), At(Range.Key), At(Range.Value));
+                if (DistSquared > MaxDistSquared)
+                {
+                    MaxDistSquared = DistSquared;
+                    Split = i;
+                }
+            }
+
+            if (Split != INDEX_NONE)
+            {
+                Keep[Split % N] = true;
+                Stack.Emplace(Range.Key, Split);
+                Stack.Emplace(Split, Range.Value);
+            }
+        }
+    }
+
+    static void VisvalingamWhyattRing(const TArray<FVector2D>& Ring, double Tolerance, const TBitArray<>& Locked, TBitArray<>& Keep)
+    {
+        const int32 N = Ring.Num();
+        Keep.Init(true, N);
+
+        TArray<int32> Prev, Next;
+        TArray<double> Area;
+        TArray<int32> Version;
+        Prev.SetNumUninitialized(N);
+        Next.SetNumUninitialized(N);
+        Area.SetNumUninitialized(N);
+        Version.SetNumZeroed(N);
+
+        struct FHeapEntry
+        {
+            double Area;
+            int32 Index;
+            int32 Version;
+            bool operator<(const FHeapEntry& Other) const { return Area < Other.Area; }
+        };
+
+        TArray<FHeapEntry> Heap;
+        Heap.Reserve(N);
+
+        for (int32 i = 0; i < N; ++i)
+        {
+            Prev[i] = (i + N - 1) % N;
+            Next[i] = (i + 1) % N;
+            Area[i] = TriangleArea(Ring[Prev[i]], Ring[i], Ring[Next[i]]);
+            Heap.HeapPush({ Area[i], i, 0 });
+        }
+
+        // Effective-area threshold equivalent to a spike of height Tolerance on a Tolerance-long base
+        const double AreaThreshold = 0.5 * Tolerance * Tolerance;
+        int32 Remaining = N;
+
+        while (Heap.Num() > 0 && Remaining > 3)
+        {
+            FHeapEntry Entry;
+            Heap.HeapPop(Entry, EAllowShrinking::No);
+
+            if (!Keep[Entry.Index] || Locked[Entry.Index] || Entry.Version != Version[Entry.Index]) continue;
+            if (Entry.Area >= AreaThreshold) break;
+
+            Keep[Entry.Index] = false;
+            --Remaining;
+
+            const int32 P = Prev[Entry.Index];
+            const int32 X = Next[Entry.Index];
+            Next[P] = X;
+            Prev[X] = P;
+
+            // Neighbours never drop below the removed area, which keeps elimination order monotonic
+            for (int32 Neighbour : { P, X })
+            {
+                Area[Neighbour] = FMath::Max(Entry.Area, TriangleArea(Ring[Prev[Neighbour]], Ring[Neighbour], Ring[Next[Neighbour]]));
+                Heap.HeapPush({ Area[Neighbour], Neighbour, ++Version[Neighbour] });
+            }
+        }
+    }
+
+    static bool SegmentsIntersect(const FVector2D& A, const FVector2D& B, const FVector2D& C, const FVector2D& D)
+    {
+        auto Orient = [](const FVector2D& P, const FVector2D& Q, const FVector2D& R)
+            {
+                return FVector2D::CrossProduct(Q - P, R - P);
+            };
+        auto OnSegment = [](const FVector2D& P, const FVector2D& Q, const FVector2D& R)
+            {
+                return FMath::Min(P.X, Q.X) <= R.X && R.X <= FMath::Max(P.X, Q.X) && FMath::Min(P.Y, Q.Y) <= R.Y && R.Y <= FMath::Max(P.Y, Q.Y);
+            };
+
+        const double O1 = Orient(A, B, C);
+        const double O2 = Orient(A, B, D);
+        const double O3 = Orient(C, D, A);
+        const double O4 = Orient(C, D, B);
+
+        if (((O1 > 0 && O2 < 0) || (O1 < 0 && O2 > 0)) && ((O3 > 0 && O4 < 0) || (O3 < 0 && O4 > 0)))
+        {
+            return true;
+        }
+
+        return (O1 == 0 && OnSegment(A, B, C)) || (O2 == 0 && OnSegment(A, B, D)) || (O3 == 0 && OnSegment(C, D, A)) || (O4 == 0 && OnSegment(C, D, B));
+    }
+
+    // True when no two non-adjacent edges intersect, within a ring or between two rings
+    static bool RingsAreSimple(TConstArrayView<TConstArrayView<FVector2D>> Rings)
+    {
+        // (ring, index of the edge's first vertex)
+        TArray<FIntPoint> Edges;
+        FBox2D Bounds(ForceInit);
+        double TotalLength = 0.0;
+        for (int32 RingIndex = 0; RingIndex < Rings.Num(); ++RingIndex)
+        {
+            const TConstArrayView<FVector2D> Ring = Rings[RingIndex];
+            if (Ring.Num() < 2) continue;
+
+            for (int32 i = 0; i < Ring.Num(); ++i)
+            {
+                Bounds += Ring[i];
+                TotalLength += FVector2D::Distance(Ring[i], Ring[(i + 1) % Ring.Num()]);
+                Edges.Emplace(RingIndex, i);
+            }
+        }
+
+        const int32 N = Edges.Num();
+        if (N < 4) return true;
+
+        // Bucket edges into a uniform grid sized to the mean edge length, then only test edges sharing a cell
+        const double CellSize = FMath::Max(TotalLength / N, UE_DOUBLE_KINDA_SMALL_NUMBER);
+        const FVector2D BoundsSize = Bounds.GetSize();
+        // About sqrt(N) cells per axis keeps the grid at O(N) cells however thin or sparse the rings are
+        const int64 MaxCellsPerAxis = FMath::Max<int64>(FMath::CeilToInt64(FMath::Sqrt(double(N))), 1);
+        const int64 CellsX = FMath::Clamp<int64>(FMath::FloorToInt64(BoundsSize.X / CellSize) + 1, 1, MaxCellsPerAxis);
+        const int64 CellsY = FMath::Clamp<int64>(FMath::FloorToInt64(BoundsSize.Y / CellSize) + 1, 1, MaxCellsPerAxis);
+        const double InvCellX = CellsX / FMath::Max(BoundsSize.X, UE_DOUBLE_KINDA_SMALL_NUMBER);
+        const double InvCellY = CellsY / FMath::Max(BoundsSize.Y, UE_DOUBLE_KINDA_SMALL_NUMBER);
+
+        auto CellOf = [&](const FVector2D& P)
+            {
+                return FIntPoint(
+                    (int32)FMath::Clamp<int64>(FMath::FloorToInt64((P.X - Bounds.Min.X) * InvCellX), 0, CellsX - 1),
+                    (int32)FMath::Clamp<int64>(FMath::FloorToInt64((P.Y - Bounds.Min.Y) * InvCellY), 0, CellsY - 1));
+            };
+
+        TMultiMap<FIntPoint, int32> Cells;
+        Cells.Reserve(N * 2);
+
+        for (int32 EdgeIndex = 0; EdgeIndex < N; ++EdgeIndex)
+        {
+            const FIntPoint Edge = Edges[EdgeIndex];
+            const TConstArrayView<FVector2D> Ring = Rings[Edge.X];
+            const int32 NumRing = Ring.Num();
+            const FVector2D& A = Ring[Edge.Y];
+            const FVector2D& B = Ring[(Edge.Y + 1) % NumRing];
+            const FIntPoint MinCell = CellOf(FVector2D(FMath::Min(A.X, B.X), FMath::Min(A.Y, B.Y)));
+            const FIntPoint MaxCell = CellOf(FVector2D(FMath::Max(A.X, B.X), FMath::Max(A.Y, B.Y)));
+
+            for (int32 X = MinCell.X; X <= MaxCell.X; ++X)
+            {
+                for (int32 Y = MinCell.Y; Y <= MaxCell.Y; ++Y)
+                {
+                    const FIntPoint Cell(X, Y);
+                    for (auto It = Cells.CreateConstKeyIterator(Cell); It; ++It)
+                    {
+                        const FIntPoint Other = Edges[It.Value()];
+                        const TConstArrayView<FVector2D> OtherRing = Rings[Other.X];
+                        const bool bAdjacent = Other.X == Edge.X && (Other.Y == Edge.Y || (Other.Y + 1) % NumRing == Edge.Y || (Edge.Y + 1) % NumRing == Other.Y);
+                        if (!bAdjacent && SegmentsIntersect(A, B, OtherRing[Other.Y], OtherRing[(Other.Y + 1) % OtherRing.Num()]))
+                        {
+                            return false;
+                        }
+                    }
+                    Cells.Add(Cell, EdgeIndex);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    // Even-odd test; points on the boundary may go either way
+    static bool IsPointInRing(const FVector2D& P, TConstArrayView<FVector2D> Ring)
+    {
+        bool bInside = false;
+        for (int32 i = 0, j = Ring.Num() - 1; i < Ring.Num(); j = i++)
+        {
+            if ((Ring[i].Y > P.Y) != (Ring[j].Y > P.Y)
+                && P.X < (Ring[j].X - Ring[i].X) * (P.Y - Ring[i].Y) / (Ring[j].Y - Ring[i].Y) + Ring[i].X)
+            {
+                bInside = !bInside;
+            }
+        }
+        return bInside;
+    }
+}
+
+void FPolygonPreprocessor::DedupeVertices(TConstArrayView<FVector> InPoints, double Epsilon, TArray<FVector>& OutPoints)
+{
+    using PolygonPreprocessor::FVertexCell;
+
+    OutPoints.Reset(InPoints.Num());
+
+    // Cells are as wide as Epsilon, so any duplicate lies in the 3x3x3 neighbourhood of the point's cell
+    const double CellSize = FMath::Max(Epsilon, UE_DOUBLE_SMALL_NUMBER);
+    const double InvCellSize = 1.0 / CellSize;
+    const double EpsilonSquared = Epsilon * Epsilon;
+
+    TMultiMap<FVertexCell, int32> Grid;
+    Grid.Reserve(InPoints.Num());
+
+    for (const FVector& Point : InPoints)
+    {
+        const FVertexCell Cell = FVertexCell::FromPoint(Point, InvCellSize);
+        bool bDuplicate = false;
+
+        for (int64 DX = -1; DX <= 1 && !bDuplicate; ++DX)
+        {
+            for (int64 DY = -1; DY <= 1 && !bDuplicate; ++DY)
+            {
+                for (int64 DZ = -1; DZ <= 1 && !bDuplicate; ++DZ)
+                {
+                    const FVertexCell Neighbour{ Cell.X + DX, Cell.Y + DY, Cell.Z + DZ };
+                    for (auto It = Grid.CreateConstKeyIterator(Neighbour); It; ++It)
+                    {
+                        if (FVector::DistSquared(OutPoints[It.Value()], Point) < EpsilonSquared)
+                        {
+                            bDuplicate = true;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (!bDuplicate)
+        {
+            Grid.Add(Cell, OutPoints.Add(Point));
+        }
+    }
+}
+
+bool FPolygonPreprocessor::PreparePolygon(TConstArrayView<FVector> WorldPoints, TConstArrayView<FPolygonRing> WorldHoles, FPreparedPolygon& OutPolygon)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FPolygonPreprocessor::PreparePolygon);
+
+    OutPolygon = FPreparedPolygon();
+
+    TArray<FVector> UniquePoints;
+    DedupeVertices(WorldPoints, DefaultDedupeEpsilon, UniquePoints);
+
+    if (UniquePoints.Num() < 3)
+    {
+        return false;
+    }
+
+    FVector MinPoint(TNumericLimits<double>::Max());
+    FVector MaxPoint(TNumericLimits<double>::Lowest());
+
+    for (const FVector& Point : UniquePoints)
+    {
+        MinPoint = MinPoint.ComponentMin(Point);
+        MaxPoint = MaxPoint.ComponentMax(Point);
+    }
+
+    OutPolygon.BoxExtents = (MaxPoint - MinPoint) * 0.5;
+    OutPolygon.Origin = UniquePoints[0];
+
+    OutPolygon.LocalPoints.SetNumUninitialized(UniquePoints.Num());
+    for (int32 i = 0; i < UniquePoints.Num(); ++i)
+    {
+        OutPolygon.LocalPoints[i] = UniquePoints[i] - OutPolygon.Origin;
+    }
+
+    for (const FPolygonRing& Hole : WorldHoles)
+    {
+        TArray<FVector> UniqueHolePoints;
+        DedupeVertices(Hole.Points, DefaultDedupeEpsilon, UniqueHolePoints);
+        if (UniqueHolePoints.Num() < 3) continue;
+
+        FPolygonRing& LocalHole = OutPolygon.LocalHoles.AddDefaulted_GetRef();
+        LocalHole.Points.SetNumUninitialized(UniqueHolePoints.Num());
+        for (int32 i = 0; i < UniqueHolePoints.Num(); ++i)
+        {
+            LocalHole.Points[i] = UniqueHolePoints[i] - OutPolygon.Origin;
+        }
+    }
+
+    OutPolygon.bValid = true;
+    return true;
+}
+
+void FPolygonPreprocessor::SplitRings(TConstArrayView<FVector> Points, TArray<TArray<FVector>>& OutRings)
+{
+    OutRings.Reset();
+
+    int32 RingStart = 0;
+    for (int32 i = 0; i < Points.Num(); ++i)
+    {
+        // A ring needs at least three distinct vertices before its closing one
+        if (i - RingStart >= 3 && Points[i].Equals(Points[RingStart], UE_DOUBLE_SMALL_NUMBER))
+        {
+            OutRings.Emplace(Points.GetData() + RingStart, i - RingStart + 1);
+            RingStart = i + 1;
+        }
+    }
+
+    // Unclosed tail (or a geometry without any closing vertex) is kept as one more ring
+    if (Points.Num() - RingStart >= 3)
+    {
+        OutRings.Emplace(Points.GetData() + RingStart, Points.Num() - RingStart);
+    }
+}
+
+int32 FPolygonPreprocessor::ClassifyRings(TArray<TArray<FVector>>& Rings, TArray<FVector>& OutOuterRing, TArray<FPolygonRing>& OutHoles)
+{
+    OutOuterRing.Reset();
+    OutHoles.Reset();
+    if (Rings.Num() == 0) return 0;
+
+    auto RingArea = [](const TArray<FVector>& Ring)
+        {
+            double Area = 0.0;
+            for (int32 i = 0, j = Ring.Num() - 1; i < Ring.Num(); j = i++)
+            {
+                Area += Ring[j].X * Ring[i].Y - Ring[i].X * Ring[j].Y;
+            }
+            return FMath::Abs(Area) * 0.5;
+        };
+
+    int32 OuterIndex = 0;
+    double OuterArea = -1.0;
+    for (int32 i = 0; i < Rings.Num(); ++i)
+    {
+        const double Area = RingArea(Rings[i]);
+        if (Area > OuterArea)
+        {
+            OuterArea = Area;
+            OuterIndex = i;
+        }
+    }
+
+    OutOuterRing = MoveTemp(Rings[OuterIndex]);
+    if (Rings.Num() == 1) return 0;
+
+    FPolygonRing OuterRing;
+    OuterRing.Points = OutOuterRing;
+    FPolygonScanlineTable OuterTable;
+    OuterTable.Build(MakeArrayView(&OuterRing, 1));
+
+    int32 NumDropped = 0;
+    for (int32 i = 0; i < Rings.Num(); ++i)
+    {
+        if (i == OuterIndex) continue;
+
+        if (OuterTable.Contains(Rings[i][0]))
+        {
+            OutHoles.AddDefaulted_GetRef().Points = MoveTemp(Rings[i]);
+        }
+        else
+        {
+            ++NumDropped;
+        }
+    }
+
+    return NumDropped;
+}
+
+bool FPolygonPreprocessor::IsRingSimple(TConstArrayView<FVector2D> Ring)
+{
+    return PolygonPreprocessor::RingsAreSimple(MakeArrayView(&Ring, 1));
+}
+
+void FPolygonPreprocessor::SimplifyPolygon(TConstArrayView<FVector> LonLatOuter, TConstArrayView<FPolygonRing> LonLatHoles, double ToleranceMeters,
+    EPolygonSimplificationMethod Method, TFunctionRef<bool(const FVector&)> IsLocked, TArray<FVector>& OutOuter, TArray<FPolygonRing>& OutHoles)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FPolygonPreprocessor::SimplifyPolygon);
+
+    OutOuter = TArray<FVector>(LonLatOuter.GetData(), LonLatOuter.Num());
+    OutHoles = TArray<FPolygonRing>(LonLatHoles.GetData(), LonLatHoles.Num());
+
+    if (Method == EPolygonSimplificationMethod::None || ToleranceMeters <= 0.0 || LonLatOuter.Num() == 0)
+    {
+        return;
+    }
+
+    struct FRing
+    {
+        // Shapefile rings repeat the first vertex at the end; simplify the open ring and close it again
+        TConstArrayView<FVector> Open;
+        bool bExplicitlyClosed = false;
+        TArray<FVector2D> Projected;
+        TBitArray<> Locked;
+        TBitArray<> Keep;
+        TArray<FVector2D> Simplified;
+    };
+
+    // Outer ring first, all projected around one origin so rings can be tested against each other
+    TArray<FRing> Rings;
+    Rings.SetNum(1 + LonLatHoles.Num());
+    for (int32 RingIndex = 0; RingIndex < Rings.Num(); ++RingIndex)
+    {
+        FRing& Ring = Rings[RingIndex];
+        const TConstArrayView<FVector> Source = RingIndex == 0 ? LonLatOuter : TConstArrayView<FVector>(LonLatHoles[RingIndex - 1].Points);
+        Ring.bExplicitlyClosed = Source.Num() > 1 && Source[0].Equals(Source.Last(), UE_DOUBLE_SMALL_NUMBER);
+        Ring.Open = Ring.bExplicitlyClosed ? Source.Slice(0, Source.Num() - 1) : Source;
+        PolygonPreprocessor::ProjectToMeters(Ring.Open, LonLatOuter[0], Ring.Projected);
+
+        Ring.Locked.Init(false, Ring.Open.Num());
+        for (int32 i = 0; i < Ring.Open.Num(); ++i)
+        {
+            if (IsLocked(Ring.Open[i]))
+            {
+                Ring.Locked[i] = true;
+            }
+        }
+    }
+
+    TArray<int32> Anchors;
+    TArray<TConstArrayView<FVector2D>> SimplifiedViews;
+    SimplifiedViews.SetNum(Rings.Num());
+
+    // Halve the tolerance until every ring stays simple, no two rings cross and every hole stays inside the outer ring;
+    // give up after a few tries
+    double Tolerance = ToleranceMeters;
+    for (int32 Attempt = 0; Attempt < 3; ++Attempt, Tolerance *= 0.5)
+    {
+        bool bChanged = false;
+        for (int32 RingIndex = 0; RingIndex < Rings.Num(); ++RingIndex)
+        {
+            FRing& Ring = Rings[RingIndex];
+
+            // Rings of up to 4 vertices are left as they are
+            if (Ring.Open.Num() < 4)
+            {
+                Ring.Keep.Init(true, Ring.Open.Num());
+            }
+            else if (Method == EPolygonSimplificationMethod::VisvalingamWhyatt)
+            {
+                PolygonPreprocessor::VisvalingamWhyattRing(Ring.Projected, Tolerance, Ring.Locked, Ring.Keep);
+            }
+            else
+            {
+                PolygonPreprocessor::DouglasPeuckerRing(Ring.Projected, Tolerance, Ring.Locked, Anchors, Ring.Keep);
+            }
+
+            if (Ring.Keep.CountSetBits() < 3)
+            {
+                Ring.Keep.Init(true, Ring.Open.Num());
+            }
+
+            Ring.Simplified.Reset();
+            for (TConstSetBitIterator<> It(Ring.Keep); It; ++It)
+            {
+                Ring.Simplified.Add(Ring.Projected[It.GetIndex()]);
+            }
+            SimplifiedViews[RingIndex] = Ring.Simplified;
+            bChanged |= Ring.Simplified.Num() != Ring.Projected.Num();
+        }
+
+        if (!bChanged)
+        {
+            return;
+        }
+
+        if (!PolygonPreprocessor::RingsAreSimple(SimplifiedViews))
+        {
+            continue;
+        }
+
+        // Without crossings a hole is inside the outer ring as soon as one of its vertices is
+        bool bHolesInside = true;
+        for (int32 RingIndex = 1; RingIndex < Rings.Num() && bHolesInside; ++RingIndex)
+        {
+            bHolesInside = Rings[RingIndex].Simplified.ContainsByPredicate([&Rings](const FVector2D& P)
+                {
+                    return PolygonPreprocessor::IsPointInRing(P, Rings[0].Simplified);
+                });
+        }
+        if (!bHolesInside)
+        {
+            continue;
+        }
+
+        for (int32 RingIndex = 0; RingIndex < Rings.Num(); ++RingIndex)
+        {
+            const FRing& Ring = Rings[RingIndex];
+            TArray<FVector>& OutRing = RingIndex == 0 ? OutOuter : OutHoles[RingIndex - 1].Points;
+            OutRing.Reset(Ring.Simplified.Num() + 1);
+            for (TConstSetBitIterator<> It(Ring.Keep); It; ++It)
+            {
+                OutRing.Add(Ring.Open[It.GetIndex()]);
+            }
+            if (Ring.bExplicitlyClosed)
+            {
+                OutRing.Add(OutRing[0]);
+            }
+        }
+        return;
+    }
+}
@@ -0,0 +1,102 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PolygonScanlineTable.h"
+
+void FPolygonScanlineTable::Build(TConstArrayView<FPolygonRing> Rings, const FTransform& RingTransform)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FPolygonScanlineTable::Build);
+
+    Edges.Reset();
+    BandStarts.Reset();
+    BandEdges.Reset();
+    Bounds = FBox2D(ForceInit);
+    InvBandHeight = 0.0;
+
+    const bool bIdentity = RingTransform.Equals(FTransform::Identity);
+
+    for (const FPolygonRing& Ring : Rings)
+    {
+        const int32 N = Ring.Points.Num();
+        if (N < 3) continue;
+
+        FVector Previous = bIdentity ? Ring.Points[N - 1] : RingTransform.TransformPosition(Ring.Points[N - 1]);
+        for (int32 i = 0; i < N; ++i)
+        {
+            const FVector Current = bIdentity ? Ring.Points[i] : RingTransform.TransformPosition(Ring.Points[i]);
+            Bounds += FVector2D(Current.X, Current.Y);
+
+            // Horizontal edges never cross a scanline; a repeated closing vertex yields one too
+            if (Previous.Y != Current.Y)
+            {
+                const FVector& Low = Previous.Y < Current.Y ? Previous : Current;
+                const FVector& High = Previous.Y < Current.Y ? Current : Previous;
+                Edges.Add({ Low.Y, High.Y, Low.X, (High.X - Low.X) / (High.Y - Low.Y) });
+            }
+
+            Previous = Current;
+        }
+    }
+
+    if (Edges.Num() == 0) return;
+
+    // About four edges per band keeps both the table and the per-query walk small
+    const int32 NumBands = FMath::Clamp(Edges.Num() / 4, 1, 4096);
+    const double Height = FMath::Max(Bounds.Max.Y - Bounds.Min.Y, UE_DOUBLE_KINDA_SMALL_NUMBER);
+    InvBandHeight = NumBands / Height;
+
+    auto BandOf = [this, NumBands](double Y)
+        {
+            return FMath::Clamp((int32)FMath::FloorToInt64((Y - Bounds.Min.Y) * InvBandHeight), 0, NumBands - 1);
+        };
+
+    // Counting pass, prefix sum, then fill
+    BandStarts.SetNumZeroed(NumBands + 1);
+    for (const FEdge& Edge : Edges)
+    {
+        for (int32 Band = BandOf(Edge.MinY); Band <= BandOf(Edge.MaxY); ++Band)
+        {
+            ++BandStarts[Band + 1];
+        }
+    }
+
+    for (int32 Band = 0; Band < NumBands; ++Band)
+    {
+        BandStarts[Band + 1] += BandStarts[Band];
+    }
+
+    BandEdges.SetNumUninitialized(BandStarts[NumBands]);
+    TArray<int32> Cursor(BandStarts.GetData(), NumBands);
+    for (int32 EdgeIndex = 0; EdgeIndex < Edges.Num(); ++EdgeIndex)
+    {
+        const FEdge& Edge = Edges[EdgeIndex];
+        for (int32 Band = BandOf(Edge.MinY); Band <= BandOf(Edge.MaxY); ++Band)
+        {
+            BandEdges[Cursor[Band]++] = EdgeIndex;
+        }
+    }
+}
+
+bool FPolygonScanlineTable::Contains(double X, double Y) const
+{
+    if (Edges.Num() == 0 || !Bounds.IsInsideOrOn(FVector2D(X, Y))) return false;
+
+    const int32 NumBands = BandStarts.Num() - 1;
+    const int32 Band = FMath::Clamp((int32)FMath::FloorToInt64((Y - Bounds.Min.Y) * InvBandHeight), 0, NumBands - 1);
+
+    bool bInside = false;
+    for (int32 i = BandStarts[Band]; i < BandStarts[Band + 1]; ++i)
+    {
+        const FEdge& Edge = Edges[BandEdges[i]];
+
+        // Half-open in Y so a scanline through a shared vertex counts it once
+        if (Y < Edge.MinY || Y >= Edge.MaxY) continue;
+
+        if (Edge.XAtMinY + (Y - Edge.MinY) * Edge.DxDy > X)
+        {
+            bInside = !bInside;
+        }
+    }
+
+    return bInside;
+}
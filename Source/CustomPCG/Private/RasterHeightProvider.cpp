@@ -0,0 +1,516 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RasterHeightProvider.h"
+#include "Algo/Count.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "Async/ParallelFor.h"
+#include "HAL/PlatformFileManager.h"
+#include "Math/VectorRegister.h"
+#include "Misc/Paths.h"
+
+namespace RasterHeightProvider
+{
+    static FCriticalSection RegistryLock;
+    static TMap<FString, TWeakPtr<FRasterHeightProvider>> Registry;
+
+    // Positions per ParallelFor task; a multiple of 4 so every task runs full SIMD groups
+    static constexpr int32 SamplesPerTask = 16384;
+
+    enum ETiffTag : uint16
+    {
+        ImageWidth = 256,
+        ImageLength = 257,
+        BitsPerSample = 258,
+        Compression = 259,
+        StripOffsets = 273,
+        SamplesPerPixel = 277,
+        StripByteCounts = 279,
+        TileWidth = 322,
+        SampleFormat = 339,
+        ModelPixelScale = 33550,
+        ModelTiepoint = 33922,
+        GeoKeyDirectory = 34735,
+        GdalNoData = 42113
+    };
+
+    enum ETiffType : uint16
+    {
+        Byte = 1,
+        Ascii = 2,
+        Short = 3,
+        Long = 4,
+        Double = 12
+    };
+
+    static constexpr uint16 GTModelTypeGeoKey = 1024;
+    static constexpr uint16 GTRasterTypeGeoKey = 1025;
+
+    struct FTiffEntry
+    {
+        uint16 Type = 0;
+        uint32 Count = 0;
+        // Offset of the entry's 4-byte value/offset field
+        int64 FieldOffset = 0;
+    };
+
+    // Little-endian TIFF reader over the mapped bytes; every read is bounds checked
+    struct FTiffReader
+    {
+        const uint8* Data = nullptr;
+        int64 Size = 0;
+
+        template <typename T>
+        bool Read(int64 Offset, T& Out) const
+        {
+            if (Offset < 0 || Offset + (int64)sizeof(T) > Size) return false;
+            FMemory::Memcpy(&Out, Data + Offset, sizeof(T));
+            return true;
+        }
+
+        static int32 TypeSize(uint16 Type)
+        {
+            switch (Type)
+            {
+            case Byte:
+            case Ascii:  return 1;
+            case Short:  return 2;
+            case Long:   return 4;
+            case Double: return 8;
+            default:     return 0;
+            }
+        }
+
+        // Values that fit in 4 bytes are stored in the entry itself, larger ones at the offset it holds
+        int64 ValuesOffset(const FTiffEntry& Entry) const
+        {
+            if ((int64)TypeSize(Entry.Type) * Entry.Count <= 4) return Entry.FieldOffset;
+
+            uint32 Offset = 0;
+            return Read(Entry.FieldOffset, Offset) ? (int64)Offset : -1;
+        }
+
+        bool ReadNumbers(const FTiffEntry& Entry, TArray<double>& Out) const
+        {
+            const int32 Stride = TypeSize(Entry.Type);
+            const int64 Offset = ValuesOffset(Entry);
+            if (Stride == 0 || Entry.Type == Ascii || Offset < 0) return false;
+
+            Out.SetNumUninitialized(Entry.Count);
+            for (uint32 i = 0; i < Entry.Count; ++i)
+            {
+                const int64 ValueOffset = Offset + (int64)i * Stride;
+                bool bRead = false;
+                switch (Entry.Type)
+                {
+                case Byte:   { uint8 V = 0;   bRead = Read(ValueOffset, V); Out[i] = V; break; }
+                case Short:  { uint16 V = 0;  bRead = Read(ValueOffset, V); Out[i] = V; break; }
+                case Long:   { uint32 V = 0;  bRead = Read(ValueOffset, V); Out[i] = V; break; }
+                case Double: { double V = 0;  bRead = Read(ValueOffset, V); Out[i] = V; break; }
+                default: break;
+                }
+                if (!bRead) return false;
+            }
+            return true;
+        }
+
+        bool ReadString(const FTiffEntry& Entry, FString& Out) const
+        {
+            const int64 Offset = ValuesOffset(Entry);
+            if (Entry.Type != Ascii || Offset < 0 || Offset + Entry.Count > Size) return false;
+
+            Out = FString(FUTF8ToTCHAR(reinterpret_cast<const ANSICHAR*>(Data + Offset), Entry.Count).Get());
+            Out.TrimStartAndEndInline();
+            return true;
+        }
+    };
+}
+
+FRasterHeightProvider::~FRasterHeightProvider()
+{
+    // Region before file handle
+    MappedRegion.Reset();
+    MappedFile.Reset();
+}
+
+TSharedPtr<FRasterHeightProvider> FRasterHeightProvider::Get(const FString& FilePath)
+{
+    using namespace RasterHeightProvider;
+
+    const FString FullPath = FPaths::ConvertRelativePathToFull(FilePath);
+
+    FScopeLock Lock(&RegistryLock);
+    if (TSharedPtr<FRasterHeightProvider> Existing = Registry.FindRef(FullPath).Pin())
+    {
+        return Existing;
+    }
+
+    TSharedPtr<FRasterHeightProvider> Provider = MakeShareable(new FRasterHeightProvider());
+    if (!Provider->Open(FullPath))
+    {
+        return nullptr;
+    }
+
+    Registry.Add(FullPath, Provider);
+    return Provider;
+}
+
+bool FRasterHeightProvider::Open(const FString& InFilePath)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(FRasterHeightProvider::Open);
+
+    FilePath = InFilePath;
+
+    MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*FilePath));
+    if (!MappedFile)
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: failed to map %s"), *FilePath);
+        return false;
+    }
+
+    MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+    if (!MappedRegion)
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: failed to map region of %s"), *FilePath);
+        return false;
+    }
+
+    const UCustomPCGSettings* Settings = GetDefault<UCustomPCGSettings>();
+    NoDataValue = Settings->RasterNoDataValue;
+    HeightOffset = Settings->RasterHeightOffset;
+
+    const FString Extension = FPaths::GetExtension(FilePath).ToLower();
+    const bool bParsed = (Extension == TEXT("tif") || Extension == TEXT("tiff"))
+        ? ParseGeoTiff(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize())
+        : ParseRaw(MappedRegion->GetMappedSize());
+
+    if (!bParsed)
+    {
+        return false;
+    }
+
+    UE_LOG(LogTemp, Log, TEXT("RasterHeightProvider: mapped %s (%dx%d, %s, origin %.6f,%.6f, pixel %.8f x %.8f deg)"),
+        *FilePath, Width, Height, Format == ERasterSampleFormat::Int16 ? TEXT("int16") : TEXT("float32"),
+        OriginLon, OriginLat, PixelSizeLon, PixelSizeLat);
+    return true;
+}
+
+bool FRasterHeightProvider::ParseRaw(int64 Size)
+{
+    const UCustomPCGSettings* Settings = GetDefault<UCustomPCGSettings>();
+
+    Width = Settings->RawRasterWidth;
+    Height = Settings->RawRasterHeight;
+    Format = Settings->RawRasterFormat;
+    OriginLon = Settings->RawRasterOrigin.X;
+    OriginLat = Settings->RawRasterOrigin.Y;
+    PixelSizeLon = Settings->RawRasterPixelSize.X;
+    PixelSizeLat = Settings->RawRasterPixelSize.Y;
+
+    const int64 BytesPerSample = Format == ERasterSampleFormat::Int16 ? 2 : 4;
+    if (Width <= 0 || Height <= 0 || (int64)Width * Height * BytesPerSample > Size || PixelSizeLon <= 0.0 || PixelSizeLat <= 0.0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s is %lld bytes, too small for the configured %dx%d raw raster"), *FilePath, Size, Width, Height);
+        return false;
+    }
+
+    Samples = MappedRegion->GetMappedPtr();
+    return true;
+}
+
+bool FRasterHeightProvider::ParseGeoTiff(const uint8* Data, int64 Size)
+{
+    using namespace RasterHeightProvider;
+
+    const FTiffReader Reader{ Data, Size };
+
+    uint16 ByteOrder = 0;
+    uint16 Magic = 0;
+    uint32 IfdOffset = 0;
+    if (!Reader.Read(0, ByteOrder) || !Reader.Read(2, Magic) || !Reader.Read(4, IfdOffset) || Magic != 42)
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s is not a classic TIFF"), *FilePath);
+        return false;
+    }
+    if (ByteOrder != 0x4949)
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s is big-endian, only little-endian GeoTIFFs are supported"), *FilePath);
+        return false;
+    }
+
+    uint16 NumEntries = 0;
+    if (!Reader.Read(IfdOffset, NumEntries))
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s has a truncated IFD"), *FilePath);
+        return false;
+    }
+
+    // First image only
+    TMap<uint16, FTiffEntry> Entries;
+    for (int32 i = 0; i < NumEntries; ++i)
+    {
+        const int64 EntryOffset = (int64)IfdOffset + 2 + i * 12;
+        uint16 Tag = 0;
+        FTiffEntry Entry;
+        if (!Reader.Read(EntryOffset, Tag) || !Reader.Read(EntryOffset + 2, Entry.Type) || !Reader.Read(EntryOffset + 4, Entry.Count))
+        {
+            UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s has a truncated IFD"), *FilePath);
+            return false;
+        }
+        Entry.FieldOffset = EntryOffset + 8;
+        Entries.Add(Tag, Entry);
+    }
+
+    auto ReadNumbers = [&Reader, &Entries](uint16 Tag, TArray<double>& Out)
+        {
+            const FTiffEntry* Entry = Entries.Find(Tag);
+            return Entry && Reader.ReadNumbers(*Entry, Out) && Out.Num() > 0;
+        };
+
+    auto ReadNumber = [&ReadNumbers](uint16 Tag, double Default)
+        {
+            TArray<double> Values;
+            return ReadNumbers(Tag, Values) ? Values[0] : Default;
+        };
+
+    if (Entries.Contains(TileWidth))
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s is tiled, re-export it with strips (e.g. gdal_translate -co TILED=NO)"), *FilePath);
+        return false;
+    }
+
+    if (ReadNumber(Compression, 1.0) != 1.0 || ReadNumber(SamplesPerPixel, 1.0) != 1.0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s must be an uncompressed single-band image (e.g. gdal_translate -co COMPRESS=NONE -b 1)"), *FilePath);
+        return false;
+    }
+
+    Width = (int32)ReadNumber(ImageWidth, 0.0);
+    Height = (int32)ReadNumber(ImageLength, 0.0);
+
+    const int32 Bits = (int32)ReadNumber(BitsPerSample, 0.0);
+    const int32 SampleKind = (int32)ReadNumber(SampleFormat, 1.0);
+    if (Bits == 16 && SampleKind == 2)
+    {
+        Format = ERasterSampleFormat::Int16;
+    }
+    else if (Bits == 32 && SampleKind == 3)
+    {
+        Format = ERasterSampleFormat::Float32;
+    }
+    else
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s has %d-bit samples of format %d, only int16 and float32 are supported"), *FilePath, Bits, SampleKind);
+        return false;
+    }
+
+    // Strips must follow each other so the whole image is one row-major array
+    TArray<double> Offsets;
+    TArray<double> Counts;
+    if (!ReadNumbers(StripOffsets, Offsets) || !ReadNumbers(StripByteCounts, Counts) || Offsets.Num() != Counts.Num())
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s has no usable strip layout"), *FilePath);
+        return false;
+    }
+
+    int64 TotalBytes = 0;
+    for (int32 i = 0; i < Offsets.Num(); ++i)
+    {
+        if ((int64)Offsets[i] != (int64)Offsets[0] + TotalBytes)
+        {
+            UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s has non-contiguous strips"), *FilePath);
+            return false;
+        }
+        TotalBytes += (int64)Counts[i];
+    }
+
+    const int64 BytesPerSample = Bits / 8;
+    if (Width <= 0 || Height <= 0 || TotalBytes < (int64)Width * Height * BytesPerSample || (int64)Offsets[0] + TotalBytes > Size)
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s image data is truncated"), *FilePath);
+        return false;
+    }
+
+    Samples = Data + (int64)Offsets[0];
+
+    // Geographic placement: tiepoint (I, J, K, X, Y, Z) and pixel scale (X, Y, Z)
+    TArray<double> Scale;
+    TArray<double> Tiepoint;
+    if (!ReadNumbers(ModelPixelScale, Scale) || Scale.Num() < 2 || !ReadNumbers(ModelTiepoint, Tiepoint) || Tiepoint.Num() < 6)
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s lacks ModelTiepoint/ModelPixelScale"), *FilePath);
+        return false;
+    }
+
+    bool bPixelIsPoint = false;
+    TArray<double> GeoKeys;
+    if (ReadNumbers(GeoKeyDirectory, GeoKeys))
+    {
+        // Header of 4 shorts, then (KeyID, TagLocation, Count, Value) per key; inline values only
+        for (int32 i = 4; i + 3 < GeoKeys.Num(); i += 4)
+        {
+            if (GeoKeys[i + 1] != 0.0) continue;
+
+            if ((uint16)GeoKeys[i] == GTModelTypeGeoKey && GeoKeys[i + 3] != 2.0)
+            {
+                UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s is projected, reproject it to geographic WGS84 (e.g. gdalwarp -t_srs EPSG:4326)"), *FilePath);
+                return false;
+            }
+            if ((uint16)GeoKeys[i] == GTRasterTypeGeoKey)
+            {
+                bPixelIsPoint = GeoKeys[i + 3] == 2.0;
+            }
+        }
+    }
+
+    PixelSizeLon = Scale[0];
+    PixelSizeLat = Scale[1];
+    OriginLon = Tiepoint[3] - Tiepoint[0] * PixelSizeLon;
+    OriginLat = Tiepoint[4] + Tiepoint[1] * PixelSizeLat;
+
+    // PixelIsPoint tiepoints name the pixel centre rather than its corner
+    if (bPixelIsPoint)
+    {
+        OriginLon -= 0.5 * PixelSizeLon;
+        OriginLat += 0.5 * PixelSizeLat;
+    }
+
+    if (PixelSizeLon <= 0.0 || PixelSizeLat <= 0.0)
+    {
+        UE_LOG(LogTemp, Error, TEXT("RasterHeightProvider: %s has an invalid pixel scale"), *FilePath);
+        return false;
+    }
+
+    FString NoDataText;
+    if (const FTiffEntry* NoDataEntry = Entries.Find(GdalNoData); NoDataEntry && Reader.ReadString(*NoDataEntry, NoDataText) && NoDataText.IsNumeric())
+    {
+        NoDataValue = FCString::Atod(*NoDataText);
+    }
+
+    return true;
+}
+
+float FRasterHeightProvider::ReadSample(int32 X, int32 Y) const
+{
+    const int64 Index = (int64)Y * Width + X;
+
+    if (Format == ERasterSampleFormat::Int16)
+    {
+        int16 Value;
+        FMemory::Memcpy(&Value, Samples + Index * 2, 2);
+        return Value;
+    }
+
+    float Value;
+    FMemory::Memcpy(&Value, Samples + Index * 4, 4);
+    return Value;
+}
+
+void FRasterHeightProvider::SampleHeightsImmediate(TConstArrayView<FVector> LonLatPositions, TArrayView<FCesiumSampleHeightResult> OutResults) const
+{
+    check(LonLatPositions.Num() == OutResults.Num());
+
+    const double InvPixelLon = 1.0 / PixelSizeLon;
+    const double InvPixelLat = 1.0 / PixelSizeLat;
+    const float NoData = (float)NoDataValue;
+
+    // Four positions per step: corner fetches are scalar gathers, the two-level lerp is SIMD
+    for (int32 Base = 0; Base < LonLatPositions.Num(); Base += 4)
+    {
+        const int32 Lanes = FMath::Min(4, LonLatPositions.Num() - Base);
+
+        alignas(16) float H00[4] = {};
+        alignas(16) float H10[4] = {};
+        alignas(16) float H01[4] = {};
+        alignas(16) float H11[4] = {};
+        alignas(16) float Fx[4] = {};
+        alignas(16) float Fy[4] = {};
+        alignas(16) float Heights[4];
+        bool bValid[4] = {};
+
+        for (int32 Lane = 0; Lane < Lanes; ++Lane)
+        {
+            const FVector& LonLat = LonLatPositions[Base + Lane];
+
+            // Pixel centres sit at +0.5; outside the raster's extent is a failed sample
+            const double Col = (LonLat.X - OriginLon) * InvPixelLon - 0.5;
+            const double Row = (OriginLat - LonLat.Y) * InvPixelLat - 0.5;
+            if (Col < -0.5 || Row < -0.5 || Col > Width - 0.5 || Row > Height - 0.5) continue;
+
+            const double ClampedCol = FMath::Clamp(Col, 0.0, (double)(Width - 1));
+            const double ClampedRow = FMath::Clamp(Row, 0.0, (double)(Height - 1));
+            const int32 X0 = (int32)ClampedCol;
+            const int32 Y0 = (int32)ClampedRow;
+            const int32 X1 = FMath::Min(X0 + 1, Width - 1);
+            const int32 Y1 = FMath::Min(Y0 + 1, Height - 1);
+
+            H00[Lane] = ReadSample(X0, Y0);
+            H10[Lane] = ReadSample(X1, Y0);
+            H01[Lane] = ReadSample(X0, Y1);
+            H11[Lane] = ReadSample(X1, Y1);
+            Fx[Lane] = (float)(ClampedCol - X0);
+            Fy[Lane] = (float)(ClampedRow - Y0);
+
+            bValid[Lane] = H00[Lane] != NoData && H10[Lane] != NoData && H01[Lane] != NoData && H11[Lane] != NoData;
+        }
+
+        const VectorRegister4Float V00 = VectorLoadAligned(H00);
+        const VectorRegister4Float V10 = VectorLoadAligned(H10);
+        const VectorRegister4Float V01 = VectorLoadAligned(H01);
+        const VectorRegister4Float V11 = VectorLoadAligned(H11);
+        const VectorRegister4Float VFx = VectorLoadAligned(Fx);
+        const VectorRegister4Float VFy = VectorLoadAligned(Fy);
+
+        const VectorRegister4Float Top = VectorMultiplyAdd(VectorSubtract(V10, V00), VFx, V00);
+        const VectorRegister4Float Bottom = VectorMultiplyAdd(VectorSubtract(V11, V01), VFx, V01);
+        VectorStoreAligned(VectorMultiplyAdd(VectorSubtract(Bottom, Top), VFy, Top), Heights);
+
+        for (int32 Lane = 0; Lane < Lanes; ++Lane)
+        {
+            const FVector& LonLat = LonLatPositions[Base + Lane];
+            FCesiumSampleHeightResult& Result = OutResults[Base + Lane];
+            Result.SampleSuccess = bValid[Lane];
+            Result.LongitudeLatitudeHeight = FVector(LonLat.X, LonLat.Y, bValid[Lane] ? Heights[Lane] + HeightOffset : LonLat.Z);
+        }
+    }
+}
+
+void FRasterHeightProvider::SampleHeights(const TArray<FVector>& LonLatPositions, FHeightSampleCallback OnComplete)
+{
+    // The mapping stays alive until the last in-flight request returns
+    Async(EAsyncExecution::ThreadPool, [Self = AsShared(), Positions = LonLatPositions, OnComplete = MoveTemp(OnComplete)]() mutable
+        {
+            TRACE_CPUPROFILER_EVENT_SCOPE(FRasterHeightProvider::SampleHeights);
+
+            TArray<FCesiumSampleHeightResult> Results;
+            Results.SetNum(Positions.Num());
+
+            const int32 NumTasks = FMath::DivideAndRoundUp(Positions.Num(), RasterHeightProvider::SamplesPerTask);
+            ParallelFor(NumTasks, [&](int32 TaskIndex)
+                {
+                    const int32 Start = TaskIndex * RasterHeightProvider::SamplesPerTask;
+                    const int32 Num = FMath::Min(RasterHeightProvider::SamplesPerTask, Positions.Num() - Start);
+                    Self->SampleHeightsImmediate(
+                        TConstArrayView<FVector>(Positions.GetData() + Start, Num),
+                        TArrayView<FCesiumSampleHeightResult>(Results.GetData() + Start, Num));
+                });
+
+            TArray<FString> Warnings;
+            const int32 NumFailed = Algo::CountIf(Results, [](const FCesiumSampleHeightResult& Result) { return !Result.SampleSuccess; });
+            if (NumFailed > 0)
+            {
+                Warnings.Add(FString::Printf(TEXT("%d positions outside %s or on nodata"), NumFailed, *Self->FilePath));
+            }
+
+            AsyncTask(ENamedThreads::GameThread, [Results = MoveTemp(Results), Warnings = MoveTemp(Warnings), OnComplete = MoveTemp(OnComplete)]()
+                {
+                    OnComplete(Results, Warnings);
+                });
+        });
+}
+
+FString FRasterHeightProvider::GetDescription() const
+{
+    return FString::Printf(TEXT("Raster (%s)"), *FilePath);
+}
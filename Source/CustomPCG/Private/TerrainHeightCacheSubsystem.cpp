@@ -0,0 +1,234 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "TerrainHeightCacheSubsystem.h"
+#include "Async/Async.h"
+#include "Cesium3DTileset.h"
+#include "CustomPCGSettings.h"
+#include "Engine/GameInstance.h"
+#include "Engine/World.h"
+#include "PcgSQLiteSubsystem.h"
+
+void UTerrainHeightCacheSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+    Collection.InitializeDependency<UPcgSQLiteSubsystem>();
+    Super::Initialize(Collection);
+
+    const double CellDegrees = FMath::Max(GetDefault<UCustomPCGSettings>()->HeightCacheCellDegrees, UE_DOUBLE_SMALL_NUMBER);
+    InvCellDegrees = 1.0 / CellDegrees;
+    // Stored CellX/CellY only mean something at the cell size they were quantized with
+    CellKeySuffix = FString::Printf(TEXT("|cell:%.9g"), CellDegrees);
+
+    UPcgSQLiteSubsystem* DBSubsystem = GetGameInstance()->GetSubsystem<UPcgSQLiteSubsystem>();
+    if (!DBSubsystem || !DBSubsystem->IsOpen())
+    {
+        UE_LOG(LogTemp, Error, TEXT("TerrainHeightCache: DB subsystem not available/open, heights will not persist"));
+        return;
+    }
+
+    const FString CreateHeightCacheTableSQL = TEXT(R"(
+        CREATE TABLE IF NOT EXISTS HeightCache (
+            TilesetKey TEXT,
+            CellX INTEGER,
+            CellY INTEGER,
+            Height REAL,
+            PRIMARY KEY(TilesetKey, CellX, CellY)
+        );
+    )");
+
+    DBSubsystem->Execute(CreateHeightCacheTableSQL);
+}
+
+void UTerrainHeightCacheSubsystem::Deinitialize()
+{
+    Flush();
+
+    UE_LOG(LogTemp, Log, TEXT("TerrainHeightCache: %lld hits, %lld misses"), NumHits, NumMisses);
+
+    Super::Deinitialize();
+}
+
+FString UTerrainHeightCacheSubsystem::MakeTilesetKey(const ACesium3DTileset* Tileset)
+{
+    if (!Tileset) return FString();
+
+    if (Tileset->GetTilesetSource() == ETilesetSource::FromUrl)
+    {
+        return Tileset->GetUrl();
+    }
+
+    return FString::Printf(TEXT("ion:%lld"), Tileset->GetIonAssetID());
+}
+
+UTerrainHeightCacheSubsystem::FHeightCell UTerrainHeightCacheSubsystem::CellOf(const FVector& LonLat) const
+{
+    return { FMath::FloorToInt64(LonLat.X * InvCellDegrees), FMath::FloorToInt64(LonLat.Y * InvCellDegrees) };
+}
+
+TMap<UTerrainHeightCacheSubsystem::FHeightCell, double>& UTerrainHeightCacheSubsystem::GetTilesetHeights(const FString& TilesetKey)
+{
+    if (TMap<FHeightCell, double>* Found = HeightsPerTileset.Find(TilesetKey))
+    {
+        return *Found;
+    }
+
+    TRACE_CPUPROFILER_EVENT_SCOPE(UTerrainHeightCacheSubsystem::LoadTileset);
+
+    TMap<FHeightCell, double>& Heights = HeightsPerTileset.Add(TilesetKey);
+
+    UPcgSQLiteSubsystem* DBSubsystem = GetGameInstance()->GetSubsystem<UPcgSQLiteSubsystem>();
+    if (!DBSubsystem || !DBSubsystem->IsOpen()) return Heights;
+
+    const FString SQL = FString::Printf(TEXT("SELECT CellX, CellY, Height FROM HeightCache WHERE TilesetKey='%s';"), *TilesetKey.Replace(TEXT("'"), TEXT("''")));
+    DBSubsystem->ExecuteWithCallback(SQL, [&Heights](const FSQLitePreparedStatement& Statement) -> ESQLitePreparedStatementExecuteRowResult
+        {
+            FHeightCell Cell;
+            double Height = 0.0;
+            Statement.GetColumnValueByIndex(0, Cell.X);
+            Statement.GetColumnValueByIndex(1, Cell.Y);
+            Statement.GetColumnValueByIndex(2, Height);
+            Heights.Add(Cell, Height);
+
+            return ESQLitePreparedStatementExecuteRowResult::Continue;
+        });
+
+    UE_LOG(LogTemp, Log, TEXT("TerrainHeightCache: loaded %d heights for %s"), Heights.Num(), *TilesetKey);
+    return Heights;
+}
+
+void UTerrainHeightCacheSubsystem::StoreHeight(const FString& TilesetKey, const FHeightCell& Cell, double Height)
+{
+    GetTilesetHeights(TilesetKey).Add(Cell, Height);
+    PendingWrites.Add({ TilesetKey, Cell, Height });
+
+    if (PendingWrites.Num() >= GetDefault<UCustomPCGSettings>()->HeightCacheWriteBatchSize)
+    {
+        Flush();
+    }
+}
+
+void UTerrainHeightCacheSubsystem::Flush()
+{
+    if (PendingWrites.Num() == 0) return;
+
+    TRACE_CPUPROFILER_EVENT_SCOPE(UTerrainHeightCacheSubsystem::Flush);
+
+    UPcgSQLiteSubsystem* DBSubsystem = GetGameInstance()->GetSubsystem<UPcgSQLiteSubsystem>();
+    if (!DBSubsystem || !DBSubsystem->IsOpen())
+    {
+        PendingWrites.Reset();
+        return;
+    }
+
+    DBSubsystem->BeginTransaction();
+
+    FSQLitePreparedStatement Statement = DBSubsystem->GetDatabase().PrepareStatement(
+        TEXT("INSERT OR REPLACE INTO HeightCache (TilesetKey, CellX, CellY, Height) VALUES (?1, ?2, ?3, ?4);"),
+        ESQLitePreparedStatementFlags::Persistent);
+
+    if (Statement.IsValid())
+    {
+        for (const FPendingHeight& Pending : PendingWrites)
+        {
+            Statement.SetBindingValueByIndex(1, Pending.TilesetKey);
+            Statement.SetBindingValueByIndex(2, Pending.Cell.X);
+            Statement.SetBindingValueByIndex(3, Pending.Cell.Y);
+            Statement.SetBindingValueByIndex(4, Pending.Height);
+            Statement.Execute();
+            Statement.Reset();
+            Statement.ClearBindings();
+        }
+    }
+    else
+    {
+        UE_LOG(LogTemp, Error, TEXT("TerrainHeightCache: failed to prepare insert statement"));
+    }
+
+    DBSubsystem->CommitTransaction();
+
+    UE_LOG(LogTemp, Verbose, TEXT("TerrainHeightCache: wrote %d heights"), PendingWrites.Num());
+    PendingWrites.Reset();
+}
+
+void UTerrainHeightCacheSubsystem::SampleHeights(UWorld* World, ACesium3DTileset* Tileset, const TArray<FVector>& LonLatPositions, FCachedHeightSampleCallback OnComplete)
+{
+    UGameInstance* GameInstance = World ? World->GetGameInstance() : nullptr;
+    if (UTerrainHeightCacheSubsystem* Cache = GameInstance ? GameInstance->GetSubsystem<UTerrainHeightCacheSubsystem>() : nullptr)
+    {
+        Cache->SampleHeights(Tileset, LonLatPositions, MoveTemp(OnComplete));
+        return;
+    }
+
+    FCesiumSampleHeightMostDetailedCallback Callback;
+    Callback.BindLambda([OnComplete = MoveTemp(OnComplete)](ACesium3DTileset*, const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings)
+        {
+            OnComplete(Results, Warnings);
+        });
+    Tileset->SampleHeightMostDetailed(LonLatPositions, Callback);
+}
+
+void UTerrainHeightCacheSubsystem::SampleHeights(ACesium3DTileset* Tileset, const TArray<FVector>& LonLatPositions, FCachedHeightSampleCallback OnComplete)
+{
+    TRACE_CPUPROFILER_EVENT_SCOPE(UTerrainHeightCacheSubsystem::SampleHeights);
+
+    const FString TilesetKey = MakeTilesetKey(Tileset) + CellKeySuffix;
+    const TMap<FHeightCell, double>& Heights = GetTilesetHeights(TilesetKey);
+
+    TSharedRef<TArray<FCesiumSampleHeightResult>> Results = MakeShared<TArray<FCesiumSampleHeightResult>>();
+    Results->SetNum(LonLatPositions.Num());
+
+    TArray<FVector> MissPositions;
+    TArray<int32> MissIndices;
+
+    for (int32 i = 0; i < LonLatPositions.Num(); ++i)
+    {
+        FCesiumSampleHeightResult& Result = (*Results)[i];
+        if (const double* Height = Heights.Find(CellOf(LonLatPositions[i])))
+        {
+            Result.LongitudeLatitudeHeight = FVector(LonLatPositions[i].X, LonLatPositions[i].Y, *Height);
+            Result.SampleSuccess = true;
+        }
+        else
+        {
+            MissIndices.Add(i);
+            MissPositions.Add(LonLatPositions[i]);
+        }
+    }
+
+    NumHits += LonLatPositions.Num() - MissIndices.Num();
+    NumMisses += MissIndices.Num();
+
+    // Fully cached: still complete on a later tick so callers see the same ordering as a Cesium request
+    if (MissIndices.Num() == 0)
+    {
+        AsyncTask(ENamedThreads::GameThread, [Results, OnComplete = MoveTemp(OnComplete)]()
+            {
+                OnComplete(*Results, TArray<FString>());
+            });
+        return;
+    }
+
+    TWeakObjectPtr<UTerrainHeightCacheSubsystem> WeakThis(this);
+
+    FCesiumSampleHeightMostDetailedCallback Callback;
+    Callback.BindLambda([WeakThis, TilesetKey, Results, MissIndices = MoveTemp(MissIndices), OnComplete = MoveTemp(OnComplete)](ACesium3DTileset*, const TArray<FCesiumSampleHeightResult>& MissResults, const TArray<FString>& Warnings)
+        {
+            UTerrainHeightCacheSubsystem* This = WeakThis.Get();
+
+            const int32 NumResults = FMath::Min(MissResults.Num(), MissIndices.Num());
+            for (int32 i = 0; i < NumResults; ++i)
+            {
+                const FCesiumSampleHeightResult& MissResult = MissResults[i];
+                (*Results)[MissIndices[i]] = MissResult;
+
+                if (This && MissResult.SampleSuccess)
+                {
+                    This->StoreHeight(TilesetKey, This->CellOf(MissResult.LongitudeLatitudeHeight), MissResult.LongitudeLatitudeHeight.Z);
+                }
+            }
+
+            OnComplete(*Results, Warnings);
+        });
+
+    Tileset->SampleHeightMostDetailed(MissPositions, Callback);
+}
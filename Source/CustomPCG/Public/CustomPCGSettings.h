@@ -0,0 +1,249 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DeveloperSettings.h"
+#include "CustomPCGSettings.generated.h"
+
+class UStaticMesh;
+class UBlueprintRegistery;
+class UPolygonGenerationProfile;
+
+UENUM()
+enum class EPolygonSimplificationMethod : uint8
+{
+    None,
+    DouglasPeucker,
+    VisvalingamWhyatt
+};
+
+UENUM()
+enum class EPointHeightSource : uint8
+{
+    // Elev attribute of the shapefile, no terrain sampling
+    ElevAttribute,
+    // One PointHeightProvider request per HeightSampleChunkSize points
+    Batched
+};
+
+UENUM(BlueprintType)
+enum class EPCGHeightProviderType : uint8
+{
+    // Cesium tileset sampling through the height cache; needs a streaming tileset
+    Cesium,
+    // Local DEM (GeoTIFF or raw heightmap) from RasterHeightFile, works offline
+    Raster
+};
+
+UENUM()
+enum class ERasterSampleFormat : uint8
+{
+    Int16,
+    Float32
+};
+
+// Component class instanced meshes are added to
+UENUM()
+enum class EInstanceBackend : uint8
+{
+    // ISM for meshes with Nanite data, HISM otherwise
+    Auto,
+    // Cluster tree for CPU culling and LOD selection, rebuilt whenever instances change
+    HISM,
+    // No tree; GPU culling only. Cheapest to build and update, and what Nanite meshes need
+    ISM
+};
+
+// Feature attribute written to a per-instance custom data slot; an attribute the feature type lacks writes 0
+UENUM()
+enum class EFeatureCustomDataAttribute : uint8
+{
+    Id,
+    KindID,
+    DomainID,
+    CountryID,
+    CategoryID,
+    SubCategID,
+    SpecificID,
+    Scale,
+    // Points only
+    Rotation,
+    Elev,
+    Height,
+    Altitude,
+    // Polygons only
+    Density,
+    Area,
+    // String attributes are written as a stable hash in [0, 1)
+    State,
+    Name,
+    Code,
+    EntityEnum,
+    Type,
+    Foliage
+};
+
+// One float of PerInstanceCustomData; the slot index is the entry's position in its array
+USTRUCT()
+struct FInstanceCustomDataSlot
+{
+    GENERATED_BODY()
+
+    UPROPERTY(EditAnywhere, Category = "Custom Data")
+    EFeatureCustomDataAttribute Attribute = EFeatureCustomDataAttribute::State;
+
+    // Written value is Attribute * Multiplier + Offset
+    UPROPERTY(EditAnywhere, Category = "Custom Data")
+    float Multiplier = 1.0f;
+
+    UPROPERTY(EditAnywhere, Category = "Custom Data")
+    float Offset = 0.0f;
+};
+
+/**
+ * Project-wide tuning for the CustomPCG pipelines (Project Settings > Plugins > Custom PCG).
+ */
+UCLASS(config = Game, defaultconfig, meta = (DisplayName = "Custom PCG"))
+class CUSTOMPCG_API UCustomPCGSettings : public UDeveloperSettings
+{
+    GENERATED_BODY()
+
+public:
+    virtual FName GetCategoryName() const override { return TEXT("Plugins"); }
+
+    // Released APCGPolygonActors kept for reuse; extra actors are destroyed
+    UPROPERTY(EditAnywhere, config, Category = "Pooling", meta = (ClampMin = "0", UIMin = "0"))
+    int32 MaxPooledPolygonActors = 256;
+
+    // Released APolygonHiGenActors kept for reuse; extra actors are destroyed
+    UPROPERTY(EditAnywhere, config, Category = "Pooling", meta = (ClampMin = "0", UIMin = "0"))
+    int32 MaxPooledHiGenActors = 512;
+
+    // Estimated memory of shapefiles being read and parsed at once; one file is always allowed, however large
+    UPROPERTY(EditAnywhere, config, Category = "Shapefile Ingestion", meta = (ClampMin = "1", UIMin = "1"))
+    int32 ShapefileIngestMemoryBudgetMB = 1024;
+
+    // Data asset listing the blueprints point features are matched to by model name
+    UPROPERTY(EditAnywhere, config, Category = "Point Models")
+    TSoftObjectPtr<UBlueprintRegistery> PointModelRegistry = TSoftObjectPtr<UBlueprintRegistery>(FSoftObjectPath(TEXT("/Game/PCGData/PointDataAssets/BP_Registry.BP_Registry")));
+
+    // Per-model HiGen generation radii of polygon models; models without an entry, or no profile, get automatic radii
+    UPROPERTY(EditAnywhere, config, Category = "Polygon Models")
+    TSoftObjectPtr<UPolygonGenerationProfile> PolygonGenerationProfile = TSoftObjectPtr<UPolygonGenerationProfile>(FSoftObjectPath(TEXT("/Game/PCGData/PolygonDataAssets/HiGen/PolygonGenerationProfile.PolygonGenerationProfile")));
+
+    // Edge of the square tiles point instances are bucketed into (cm); each tile gets its own component per model. 0 puts every instance of a model in one component
+    UPROPERTY(EditAnywhere, config, Category = "Point Tiles", meta = (ClampMin = "0.0", UIMin = "0.0"))
+    float PointTileSize = 25600.0f;
+
+    // Point tiles farther than this from the camera (cm, horizontal) are unregistered by AGridStreamingManager; 0 keeps every tile loaded
+    UPROPERTY(EditAnywhere, config, Category = "Point Tiles", meta = (ClampMin = "0.0", UIMin = "0.0"))
+    float PointTileStreamingRadius = 0.0f;
+
+    // Backend of meshes without an entry in InstanceBackendPerMesh
+    UPROPERTY(EditAnywhere, config, Category = "Instancing")
+    EInstanceBackend DefaultInstanceBackend = EInstanceBackend::Auto;
+
+    // Per-model backend, keyed by the model's mesh so point models, cached replay and streamed rows resolve alike
+    UPROPERTY(EditAnywhere, config, Category = "Instancing")
+    TMap<TSoftObjectPtr<UStaticMesh>, EInstanceBackend> InstanceBackendPerMesh;
+
+    // Distance (cm) at which instances start fading out; 0 with InstanceEndCullDistance 0 never culls
+    UPROPERTY(EditAnywhere, config, Category = "Instancing", meta = (ClampMin = "0", UIMin = "0"))
+    int32 InstanceStartCullDistance = 0;
+
+    // Distance (cm) beyond which instances are culled; 0 never culls
+    UPROPERTY(EditAnywhere, config, Category = "Instancing", meta = (ClampMin = "0", UIMin = "0"))
+    int32 InstanceEndCullDistance = 0;
+
+    // Feature attributes written to PerInstanceCustomData of point instances, read in materials with PerInstanceCustomData[slot]
+    UPROPERTY(EditAnywhere, config, Category = "Instance Custom Data")
+    TArray<FInstanceCustomDataSlot> PointInstanceCustomData;
+
+    // Same for the instances PCG graphs generate inside a polygon. The Polygon Interior Sampler writes slot i as the
+    // float point attribute CustomData<i> with the polygon's value; map them in the graph's spawner (Instance Data Packer)
+    UPROPERTY(EditAnywhere, config, Category = "Instance Custom Data")
+    TArray<FInstanceCustomDataSlot> PolygonInstanceCustomData;
+
+    // Simplification applied to polygon rings before their vertices are height sampled
+    UPROPERTY(EditAnywhere, config, Category = "Polygon Simplification")
+    EPolygonSimplificationMethod PolygonSimplificationMethod = EPolygonSimplificationMethod::DouglasPeucker;
+
+    // Tolerance as a fraction of the polygon's InteriorSampleSpacing (Density * 100)
+    UPROPERTY(EditAnywhere, config, Category = "Polygon Simplification", meta = (ClampMin = "0.0", UIMin = "0.0", UIMax = "2.0"))
+    float SimplificationToleranceFactor = 0.5f;
+
+    // Where APCGPointContent takes instance heights from
+    UPROPERTY(EditAnywhere, config, Category = "Height Sampling")
+    EPointHeightSource PointHeightSource = EPointHeightSource::ElevAttribute;
+
+    // Height source of the batched point path
+    UPROPERTY(EditAnywhere, config, Category = "Height Sampling")
+    EPCGHeightProviderType PointHeightProvider = EPCGHeightProviderType::Cesium;
+
+    // Height source for polygon ring vertices
+    UPROPERTY(EditAnywhere, config, Category = "Height Sampling")
+    EPCGHeightProviderType PolygonHeightProvider = EPCGHeightProviderType::Cesium;
+
+    // Positions per coalesced batch of the world's height-sampling service
+    UPROPERTY(EditAnywhere, config, Category = "Height Sampling", meta = (ClampMin = "1", UIMin = "1"))
+    int32 HeightServiceBatchSize = 16384;
+
+    // Batches outstanding at once across every caller in a world
+    UPROPERTY(EditAnywhere, config, Category = "Height Sampling", meta = (ClampMin = "1", UIMin = "1"))
+    int32 MaxHeightServiceBatchesInFlight = 4;
+
+    // Requests queued for a provider that stays not ready this long are failed instead of waiting forever
+    UPROPERTY(EditAnywhere, config, Category = "Height Sampling", meta = (ClampMin = "0.0", Units = "s"))
+    float HeightServiceReadyTimeoutSeconds = 30.0f;
+
+    // Polygon vertices closer than this (degrees) share one height sample; adjacent polygons share boundary vertices
+    UPROPERTY(EditAnywhere, config, Category = "Height Sampling", meta = (ClampMin = "0.0"))
+    double PolygonVertexDedupeDegrees = 0.0000001;
+
+    // Positions per height provider request
+    UPROPERTY(EditAnywhere, config, Category = "Height Sampling", meta = (ClampMin = "1", UIMin = "1"))
+    int32 HeightSampleChunkSize = 1024;
+
+    // Chunks waiting on the height provider at once; further chunks are issued as earlier ones complete
+    UPROPERTY(EditAnywhere, config, Category = "Height Sampling", meta = (ClampMin = "1", UIMin = "1"))
+    int32 MaxHeightSampleRequestsInFlight = 8;
+
+    // Size of a HeightCache cell; positions in the same cell share one sampled height (1e-6 deg is about 0.1 m)
+    UPROPERTY(EditAnywhere, config, Category = "Height Cache", meta = (ClampMin = "0.0000001", UIMin = "0.0000001"))
+    double HeightCacheCellDegrees = 0.000001;
+
+    // Newly sampled heights buffered before they are written to the HeightCache table in one transaction
+    UPROPERTY(EditAnywhere, config, Category = "Height Cache", meta = (ClampMin = "1", UIMin = "1"))
+    int32 HeightCacheWriteBatchSize = 4096;
+
+    // Uncompressed, strip-organised little-endian GeoTIFF (geographic, ModelTiepoint + ModelPixelScale),
+    // or a raw row-major heightmap described by the Raw settings below
+    UPROPERTY(EditAnywhere, config, Category = "Raster Heights", meta = (FilePathFilter = "Height rasters (*.tif;*.tiff;*.raw;*.r16;*.r32)|*.tif;*.tiff;*.raw;*.r16;*.r32"))
+    FFilePath RasterHeightFile;
+
+    // Added to every raster height, e.g. geoid separation when the DEM is relative to mean sea level
+    UPROPERTY(EditAnywhere, config, Category = "Raster Heights")
+    double RasterHeightOffset = 0.0;
+
+    // Samples equal to this value are reported as failed; GeoTIFFs with GDAL_NODATA override it
+    UPROPERTY(EditAnywhere, config, Category = "Raster Heights")
+    double RasterNoDataValue = -32768.0;
+
+    UPROPERTY(EditAnywhere, config, Category = "Raster Heights|Raw", meta = (ClampMin = "1", UIMin = "1"))
+    int32 RawRasterWidth = 1;
+
+    UPROPERTY(EditAnywhere, config, Category = "Raster Heights|Raw", meta = (ClampMin = "1", UIMin = "1"))
+    int32 RawRasterHeight = 1;
+
+    UPROPERTY(EditAnywhere, config, Category = "Raster Heights|Raw")
+    ERasterSampleFormat RawRasterFormat = ERasterSampleFormat::Float32;
+
+    // Longitude/latitude of the top-left corner of the top-left pixel, in degrees
+    UPROPERTY(EditAnywhere, config, Category = "Raster Heights|Raw")
+    FVector2D RawRasterOrigin = FVector2D::ZeroVector;
+
+    // Pixel size in degrees (longitude, latitude); rows go south
+    UPROPERTY(EditAnywhere, config, Category = "Raster Heights|Raw")
+    FVector2D RawRasterPixelSize = FVector2D(1.0, 1.0);
+};
@@ -0,0 +1,34 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CustomPCGSettings.h"
+
+struct FPointFeature;
+struct FGrassPolygonData;
+struct FFeatureStringTable;
+
+/**
+ * Maps feature attributes to PerInstanceCustomData slots (UCustomPCGSettings::PointInstanceCustomData and
+ * PolygonInstanceCustomData), so variants of one model can share a mesh and a component.
+ */
+struct CUSTOMPCG_API FFeatureCustomData
+{
+    // Stable value in [0, 1) for a string attribute, the same across sessions
+    static float HashString(const FString& Value);
+
+    // HashString of every entry of a dataset's string table, indexed like the table
+    static TArray<float> HashStrings(const FFeatureStringTable& Strings);
+
+    // Slot values of one point; StringValues comes from HashStrings of the point's dataset
+    static void ForPoint(const FPointFeature& Feature, TConstArrayView<float> StringValues, TConstArrayView<FInstanceCustomDataSlot> Slots, TArrayView<float> Out);
+
+    static void ForPolygon(const FGrassPolygonData& Data, TConstArrayView<FInstanceCustomDataSlot> Slots, TArrayView<float> Out);
+
+    // PCG point attribute carrying a slot's value through polygon graphs, "CustomData<Slot>"
+    static FName SlotAttributeName(int32 Slot);
+
+    // Identifies a slot mapping, for cache keys
+    static FString Describe(TConstArrayView<FInstanceCustomDataSlot> Slots);
+};
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Crc.h"
+
+/**
+ * Interned string attributes of one shapefile dataset. Feature records store indices into it, so values
+ * that repeat across features (model, descriptions, enums) are kept once. Index 0 is the empty string.
+ */
+struct CUSTOMPCG_API FFeatureStringTable
+{
+    FFeatureStringTable();
+
+    // Not thread safe; a dataset is parsed by a single task
+    int32 Intern(const FString& Value);
+
+    const FString& Get(int32 Index) const { return Strings[Index]; }
+
+    int32 Num() const { return Strings.Num(); }
+
+    SIZE_T GetAllocatedSize() const;
+
+private:
+    // FString keys hash and compare ignoring case by default; attribute values that differ only in case are distinct
+    struct FCaseSensitiveKeyFuncs : TDefaultMapKeyFuncs<FString, int32, false>
+    {
+        static bool Matches(const FString& A, const FString& B) { return A.Equals(B, ESearchCase::CaseSensitive); }
+        static uint32 GetKeyHash(const FString& Key) { return FCrc::StrCrc32(*Key); }
+    };
+
+    TArray<FString> Strings;
+    TMap<FString, int32, FDefaultSetAllocator, FCaseSensitiveKeyFuncs> Lookup;
+};
@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ACesiumGeoreference;
+
+/**
+ * Georeference conversions for whole spans of positions. The Unreal <-> ECEF matrices are read
+ * from the georeference once, when the transform is built; the ellipsoid math then runs four
+ * positions at a time in structure-of-arrays form on the WGS84 ellipsoid.
+ */
+class CUSTOMPCG_API FGeoreferenceBatchTransform
+{
+public:
+    FGeoreferenceBatchTransform() = default;
+    explicit FGeoreferenceBatchTransform(const ACesiumGeoreference* Georef);
+
+    bool IsValid() const { return bValid; }
+
+    // Unreal world positions to (longitude, latitude, height) in degrees and meters.
+    // Both conversions accept the same array as input and output.
+    void UnrealToLongitudeLatitudeHeight(TConstArrayView<FVector> UnrealPositions, TArrayView<FVector> OutLongitudeLatitudeHeights) const;
+
+    void LongitudeLatitudeHeightToUnreal(TConstArrayView<FVector> LongitudeLatitudeHeights, TArrayView<FVector> OutUnrealPositions) const;
+
+private:
+    FMatrix UnrealToEcef = FMatrix::Identity;
+    FMatrix EcefToUnreal = FMatrix::Identity;
+    bool bValid = false;
+};
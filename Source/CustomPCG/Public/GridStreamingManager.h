@@ -7,6 +7,8 @@
 #include "SQLiteDatabase.h"
 #include "GridStreamingManager.generated.h"
 
+class APCGPointContent;
+
 UCLASS()
 class CUSTOMPCG_API AGridStreamingManager : public AActor
 {
@@ -18,8 +20,23 @@ public:
     void LoadDataFromDatabase(const FString& ShapefileID);
     void UpdateStreaming(FVector PawnLocation);
 
+    // Point content tiles, registered and unregistered by horizontal distance to the camera (PointTileStreamingRadius)
+    void RegisterPointTile(APCGPointContent* Content, FIntPoint Tile, const FBox2D& Bounds);
+
     FSQLiteDatabase DB;
 private:
+    struct FStreamedPointTile
+    {
+        TWeakObjectPtr<APCGPointContent> Content;
+        FIntPoint Tile;
+        FBox2D Bounds;
+        bool bLoaded = true;
+    };
+
+    TArray<FStreamedPointTile> PointTiles;
+
+    void UpdatePointTileStreaming(const FVector& ViewLocation);
+
     TSet<FIntPoint> LoadedCells;
     UPROPERTY() AActor* ParentActor;
     int32 Radius = 500; // radius around pawn
@@ -29,6 +46,9 @@ private:
     void LoadCellAsync(FIntPoint Cell);
     void UnloadCell(FIntPoint Cell);
 
+    // One bulk add per mesh through the world's UInstanceBuilderSubsystem, grouped under the cell
+    void AddCellInstances(FIntPoint Cell, const TArray<FString>& MeshPaths, const TArray<FTransform>& Transforms);
+
     int32 DrawEveryNFrames = 60; 
     int32 FramesSinceUpdate = 0;
     TSet<FIntPoint> RequestedCells; 
@@ -0,0 +1,51 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CesiumSampleHeightResult.h"
+#include "CustomPCGSettings.h"
+
+class ACesium3DTileset;
+
+// Called on the game thread with one result per requested position, in request order
+using FHeightSampleCallback = TFunction<void(const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings)>;
+
+/**
+ * Source of terrain heights for longitude/latitude positions. Heights are returned as
+ * LongitudeLatitudeHeight like Cesium's SampleHeightMostDetailed, whichever provider answers.
+ */
+class CUSTOMPCG_API IPCGHeightProvider
+{
+public:
+    virtual ~IPCGHeightProvider() = default;
+
+    virtual void SampleHeights(const TArray<FVector>& LonLatPositions, FHeightSampleCallback OnComplete) = 0;
+
+    // False when the provider can't answer yet, e.g. the tileset root hasn't streamed in
+    virtual bool IsReady() const { return true; }
+
+    virtual FString GetDescription() const = 0;
+
+    // Returns null (and logs) when the requested provider can't be created, e.g. no tileset or no raster file.
+    // Requests go through the world's UHeightSamplingSubsystem when it has one.
+    static TSharedPtr<IPCGHeightProvider> Create(EPCGHeightProviderType Type, UWorld* World, ACesium3DTileset* Tileset);
+
+    // The provider itself, bypassing the world's sampling service
+    static TSharedPtr<IPCGHeightProvider> CreateDirect(EPCGHeightProviderType Type, UWorld* World, ACesium3DTileset* Tileset);
+};
+
+// Cesium tileset sampling through UTerrainHeightCacheSubsystem
+class CUSTOMPCG_API FCesiumHeightProvider : public IPCGHeightProvider
+{
+public:
+    FCesiumHeightProvider(UWorld* InWorld, ACesium3DTileset* InTileset);
+
+    virtual void SampleHeights(const TArray<FVector>& LonLatPositions, FHeightSampleCallback OnComplete) override;
+    virtual bool IsReady() const override;
+    virtual FString GetDescription() const override;
+
+private:
+    TWeakObjectPtr<UWorld> World;
+    TWeakObjectPtr<ACesium3DTileset> Tileset;
+};
@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HeightProvider.h"
+#include "HeightSamplingSubsystem.generated.h"
+
+struct FHeightSampleResponse
+{
+    // One result per requested position, in request order
+    TArray<FCesiumSampleHeightResult> Results;
+    TArray<FString> Warnings;
+};
+
+USTRUCT(BlueprintType)
+struct FHeightSamplingStats
+{
+    GENERATED_BODY();
+
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|HeightSampling") int64 Requests = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|HeightSampling") int64 RequestedPositions = 0;
+    // Positions actually sent to providers after dedupe
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|HeightSampling") int64 SampledPositions = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|HeightSampling") int64 Batches = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|HeightSampling") int32 QueuedRequests = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|HeightSampling") int32 BatchesInFlight = 0;
+    // Submit to fulfilment, per request
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|HeightSampling") double AverageLatencySeconds = 0.0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|HeightSampling") double MaxLatencySeconds = 0.0;
+    // Requested positions fulfilled per second of wall time since the first request
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|HeightSampling") double PositionsPerSecond = 0.0;
+};
+
+/**
+ * One height-sampling queue per world. Requests submitted during a frame are coalesced per
+ * provider into batches of up to HeightServiceBatchSize positions, identical coordinates are
+ * sampled once, and at most MaxHeightServiceBatchesInFlight batches are outstanding at a time
+ * across all callers. Each request gets its own future.
+ */
+UCLASS()
+class CUSTOMPCG_API UHeightSamplingSubsystem : public UTickableWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    virtual void Tick(float DeltaTime) override;
+    virtual TStatId GetStatId() const override;
+    virtual bool IsTickableInEditor() const override { return true; }
+
+    // Fulfilled on the game thread once the request's batch returns
+    TFuture<FHeightSampleResponse> RequestHeights(const TSharedRef<IPCGHeightProvider>& Provider, TArray<FVector> LonLatPositions);
+
+    UFUNCTION(BlueprintCallable, Category = "CustomPCG|HeightSampling")
+    FHeightSamplingStats GetStats() const;
+
+    UFUNCTION(BlueprintCallable, Category = "CustomPCG|HeightSampling")
+    void ResetStats();
+
+    void LogStats() const;
+
+private:
+    struct FPendingRequest
+    {
+        TArray<FVector> Positions;
+        TPromise<FHeightSampleResponse> Promise;
+        double SubmitSeconds = 0.0;
+    };
+
+    struct FBatch;
+
+    struct FProviderQueue
+    {
+        TSharedPtr<IPCGHeightProvider> Provider;
+        TArray<FPendingRequest> Pending;
+        // When the provider was first seen not ready with requests waiting; 0 while it's ready
+        double NotReadySinceSeconds = 0.0;
+    };
+
+    void DispatchBatch(FProviderQueue& Queue);
+    void CompleteBatch(FBatch& Batch, const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings);
+
+    // Keyed by provider description, so separately created providers for the same source share batches
+    TMap<FString, FProviderQueue> Queues;
+
+    int32 BatchesInFlight = 0;
+
+    bool bDeinitialized = false;
+
+    int64 Requests = 0;
+    int64 RequestedPositions = 0;
+    int64 SampledPositions = 0;
+    int64 FulfilledPositions = 0;
+    int64 Batches = 0;
+    int64 FulfilledRequests = 0;
+    double TotalLatencySeconds = 0.0;
+    double MaxLatencySeconds = 0.0;
+    double FirstRequestSeconds = 0.0;
+    double LastFulfilledSeconds = 0.0;
+};
+
+// Routes a provider's requests through the world's UHeightSamplingSubsystem
+class CUSTOMPCG_API FCoalescedHeightProvider : public IPCGHeightProvider
+{
+public:
+    FCoalescedHeightProvider(UHeightSamplingSubsystem* InService, const TSharedRef<IPCGHeightProvider>& InInner);
+
+    virtual void SampleHeights(const TArray<FVector>& LonLatPositions, FHeightSampleCallback OnComplete) override;
+    virtual bool IsReady() const override { return Inner->IsReady(); }
+    virtual FString GetDescription() const override { return Inner->GetDescription(); }
+
+private:
+    TWeakObjectPtr<UHeightSamplingSubsystem> Service;
+    TSharedRef<IPCGHeightProvider> Inner;
+};
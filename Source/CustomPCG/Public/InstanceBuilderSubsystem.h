@@ -0,0 +1,97 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "CustomPCGSettings.h"
+#include "InstanceBuilderSubsystem.generated.h"
+
+class UInstancedStaticMeshComponent;
+class UStaticMesh;
+
+USTRUCT(BlueprintType)
+struct FInstanceBackendStats
+{
+    GENERATED_BODY();
+
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Instancing") int32 Components = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Instancing") int64 Instances = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Instancing") int32 Adds = 0;
+    // Game-thread time of the add calls
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Instancing") double AddSeconds = 0.0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Instancing") int64 RemovedInstances = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Instancing") double RemoveSeconds = 0.0;
+};
+
+USTRUCT(BlueprintType)
+struct FInstanceBuilderStats
+{
+    GENERATED_BODY();
+
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Instancing") FInstanceBackendStats HISM;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Instancing") FInstanceBackendStats ISM;
+};
+
+/**
+ * Creates and fills the instanced mesh components of every pipeline in a world: point content tiles,
+ * the cached point replay, AGridStreamingManager cells and polygon bakes. The component class follows
+ * DefaultInstanceBackend / InstanceBackendPerMesh and cull distances come from the project settings.
+ * Game thread only.
+ */
+UCLASS()
+class CUSTOMPCG_API UInstanceBuilderSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    // Never returns Auto
+    static EInstanceBackend ResolveBackend(const UStaticMesh* Mesh);
+
+    static EInstanceBackend GetBackend(const UInstancedStaticMeshComponent* Component);
+
+    // Component of the mesh's backend, attached to Owner's root; the caller keeps track of it
+    UInstancedStaticMeshComponent* CreateComponent(AActor* Owner, UStaticMesh* Mesh, int32 NumCustomDataFloats = 0, bool bRegister = true);
+
+    // Component shared by every caller adding Mesh to Owner in Group, created on first use.
+    // Groups are released together, e.g. one per streaming cell
+    UInstancedStaticMeshComponent* FindOrCreateComponent(AActor* Owner, UStaticMesh* Mesh, FIntPoint Group = FIntPoint::ZeroValue);
+
+    // Returns the index of the first new instance
+    int32 AddInstances(UInstancedStaticMeshComponent* Component, const TArray<FTransform>& Transforms, bool bWorldSpace);
+
+    int32 AddInstance(UInstancedStaticMeshComponent* Component, const FTransform& Transform, bool bWorldSpace);
+
+    // Groups the instances by mesh and adds each mesh's in one call to its shared component in Group; null meshes are skipped
+    void AddInstancesByMesh(AActor* Owner, TConstArrayView<UStaticMesh*> Meshes, TConstArrayView<FTransform> Transforms, FIntPoint Group, bool bWorldSpace);
+
+    // Writes Values (NumFloats per instance) to instances [FirstInstance, FirstInstance + Values.Num() / NumFloats).
+    // NumFloats must match the size the component was created with
+    void SetCustomData(UInstancedStaticMeshComponent* Component, int32 FirstInstance, TConstArrayView<float> Values, int32 NumFloats);
+
+    // Destroys the shared components of Owner in Group
+    void ReleaseGroup(AActor* Owner, FIntPoint Group);
+
+    // World transforms of every instance, in instance order
+    static void ReadInstances(const UInstancedStaticMeshComponent* Component, TArray<FTransform>& OutTransforms);
+
+    UFUNCTION(BlueprintCallable, Category = "CustomPCG|Instancing")
+    FInstanceBuilderStats GetStats() const;
+
+    UFUNCTION(BlueprintCallable, Category = "CustomPCG|Instancing")
+    void ResetStats();
+
+    void LogStats() const;
+
+private:
+    FInstanceBackendStats& StatsOf(EInstanceBackend Backend);
+
+    using FSharedComponentKey = TTuple<TObjectKey<AActor>, TObjectKey<UStaticMesh>, FIntPoint>;
+
+    TMap<FSharedComponentKey, TWeakObjectPtr<UInstancedStaticMeshComponent>> SharedComponents;
+
+    FInstanceBuilderStats Stats;
+};
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PCGPolygonActor.h"
+#include "PolygonHiGenActor.h"
+#include "PCGActorPoolSubsystem.generated.h"
+
+USTRUCT(BlueprintType)
+struct FPCGActorPoolStats
+{
+    GENERATED_BODY();
+
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Pool") int32 PolygonActorHits = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Pool") int32 PolygonActorMisses = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Pool") int32 PooledPolygonActors = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Pool") int32 HiGenActorHits = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Pool") int32 HiGenActorMisses = 0;
+    UPROPERTY(BlueprintReadOnly, Category = "CustomPCG|Pool") int32 PooledHiGenActors = 0;
+};
+
+/**
+ * Recycles APCGPolygonActor and APolygonHiGenActor instances so reloads and region changes
+ * reset spline, box, graph and PolygonID instead of paying for a full actor construction.
+ */
+UCLASS()
+class CUSTOMPCG_API UPCGActorPoolSubsystem : public UWorldSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Deinitialize() override;
+
+    APCGPolygonActor* AcquirePolygonActor(const FVector& Location, AActor* Owner);
+    void ReleasePolygonActor(APCGPolygonActor* Actor);
+
+    APolygonHiGenActor* AcquireHiGenActor(const FVector& Location, AActor* Owner);
+    void ReleaseHiGenActor(APolygonHiGenActor* Actor);
+
+    UFUNCTION(BlueprintCallable, Category = "CustomPCG|Pool")
+    FPCGActorPoolStats GetStats() const;
+
+    UFUNCTION(BlueprintCallable, Category = "CustomPCG|Pool")
+    void ResetStats();
+
+private:
+    UPROPERTY() TArray<APCGPolygonActor*> PooledPolygonActors;
+    UPROPERTY() TArray<APolygonHiGenActor*> PooledHiGenActors;
+
+    int32 PolygonActorHits = 0;
+    int32 PolygonActorMisses = 0;
+    int32 HiGenActorHits = 0;
+    int32 HiGenActorMisses = 0;
+};
@@ -8,9 +8,9 @@
 #include "PCGSubSystem.h"
 #include "PCGElement.h"
 #include "PCGContext.h"
+#include "CustomPCGSettings.h"
+#include "Containers/Ticker.h"
 
-#include "Async/Async.h" // For AsyncTask
-#include <mutex>
 
 
 
@@ -49,21 +49,50 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Cesium PCG", meta = (PCG_Overridable))
 	float MinHeightTrace = -200000.0f;
 
+	/** Where heights come from: the Cesium tileset, or the project's RasterHeightFile **/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Cesium PCG", meta = (PCG_Overridable))
+	EPCGHeightProviderType HeightProvider = EPCGHeightProviderType::Cesium;
+
+	/** Points per height sampling request; large inputs are split into chunks of this size **/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Cesium PCG", meta = (PCG_Overridable, ClampMin = "1", UIMin = "1"))
+	int32 ChunkSize = 4096;
+
+	/** Chunks of one execution waiting on the height provider at the same time **/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Cesium PCG", meta = (PCG_Overridable, ClampMin = "1", UIMin = "1"))
+	int32 MaxChunksInFlight = 4;
+
 };
-class FPCGCesiumHeightAdjusterElement : public IPCGElement
+namespace PCGCesiumHeightAdjuster
 {
+	struct FHeightAdjustJob;
+}
 
-public:
-	bool isUpdate = false;
+/** Per-execution state; the job outlives the context only until its pending height callbacks return **/
+struct FPCGCesiumHeightAdjusterContext : public FPCGContext
+{
+	virtual ~FPCGCesiumHeightAdjusterContext() override;
 
+	TSharedPtr<PCGCesiumHeightAdjuster::FHeightAdjustJob> Job;
 
+	// When the height provider was first seen not ready; 0 until then
+	double NotReadySinceSeconds = 0.0;
 
+	// Wakes the paused context to check the provider again
+	FTSTicker::FDelegateHandle ReadyPollHandle;
+};
+
+class FPCGCesiumHeightAdjusterElement : public IPCGElement
+{
+
+public:
+	virtual FPCGContext* Initialize(const FPCGDataCollection& InputData, TWeakObjectPtr<UPCGComponent> SourceComponent, const UPCGNode* Node) override;
 
-	//bool getIsUpdated();
-	//void setIsUpdated(bool isUpdated);
+	// Cesium and actor access, and the job state is only touched from the game thread
+	virtual bool CanExecuteOnlyOnMainThread(FPCGContext* Context) const override { return true; }
 
+	virtual bool IsCacheable(const UPCGSettings* InSettings) const override { return false; }
 
 protected:
-	virtual bool ExecuteInternal(FPCGContext* Context) const override;
+	virtual bool ExecuteInternal(FPCGContext* InContext) const override;
 
 };
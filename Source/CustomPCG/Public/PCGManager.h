@@ -7,9 +7,38 @@
 #include "PCGContent.h"
 #include "PolygonCacheSave.h"
 #include "SQLiteDatabase.h"
+#include "PCGPointContent.h"
+#include "PCGPolygonActor.h"
 #include "PCGManager.generated.h"
 
 
+enum class EShapefileIngestKind : uint8
+{
+    Point,
+    Polygon
+};
+
+// One shapefile's trip through ingestion: read and parsed on the thread pool, spawned on the game thread.
+// Phase times are FPlatformTime seconds
+struct FShapefileIngestJob
+{
+    FString Path;
+    EShapefileIngestKind Kind = EShapefileIngestKind::Point;
+    int64 FileTimestamp = 0;
+    int64 EstimatedBytes = 0;
+
+    double QueuedSeconds = 0.0;
+    double ReadStartSeconds = 0.0;
+    double ReadEndSeconds = 0.0;
+    double ParseEndSeconds = 0.0;
+    double SpawnStartSeconds = 0.0;
+    double SpawnEndSeconds = 0.0;
+
+    int32 NumFeatures = 0;
+    FPointFeatureDataset Points;
+    TArray<FGrassPolygonData> Polygons;
+};
+
 UCLASS()
 class CUSTOMPCG_API APCGManager : public AActor
 {
@@ -32,6 +61,24 @@ public:
     void LoadDataforPCGPolygon();
 
 private:
+    // Queues a shapefile to be read and parsed off the game thread
+    void QueueShapefileIngest(const FString& Path, EShapefileIngestKind Kind, int64 FileTimestamp);
+
+    // Starts queued jobs while their estimated memory fits in ShapefileIngestMemoryBudgetMB
+    void StartPendingIngestJobs();
+
+    // Game thread: creates the content for a parsed dataset and spawns it
+    void SpawnIngestedShapefile(const TSharedRef<FShapefileIngestJob>& Job);
+
+    // Read, parse and spawn phases of every file, logged once the queue drains
+    void LogIngestTimeline() const;
+
     FSQLiteDatabase DB;
+
+    TArray<TSharedRef<FShapefileIngestJob>> PendingIngestJobs;
+    TArray<TSharedRef<FShapefileIngestJob>> CompletedIngestJobs;
+    int32 IngestJobsInFlight = 0;
+    int64 IngestBytesInFlight = 0;
+    double IngestStartSeconds = 0.0;
 };
 
@@ -6,10 +6,15 @@
 #include "PCGContent.h"
 #include "BlueprintRegistery.h"
 #include "Engine/Blueprint.h"
-#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Components/InstancedStaticMeshComponent.h"
 #include "HAL/ThreadSafeCounter.h"
+#include "HeightProvider.h"
+#include "FeatureStringTable.h"
 #include "PCGPointContent.generated.h"
 
+struct FStreamableHandle;
+class UPcgSQLiteSubsystem;
+
 // --- STRUCT 1: For vegetation_elev.shp ---
 USTRUCT(BlueprintType)
 struct FVegetationPointData
@@ -46,6 +51,91 @@ struct FVegetationPointData
     UPROPERTY(BlueprintReadWrite, Category = "CustomPCG|PointData") FString FileName;
 };
 
+// Compact point feature; string attributes are indices into the dataset's FFeatureStringTable
+struct FPointFeature
+{
+    FVector Location = FVector::ZeroVector;
+    int32 Id = 0;
+    float Lat = 0.0f;
+    float Long = 0.0f;
+    float Elev = 0.0f;
+    float Height = 0.0f;
+    float Scale = 0.0f;
+    float Rotation = 0.0f;
+    float Altitude = 0.0f;
+    int32 KindID = 0;
+    int32 DomainID = 0;
+    int32 CountryID = 0;
+    int32 CategoryID = 0;
+    int32 SubCategID = 0;
+    int32 SpecificID = 0;
+
+    int32 Name = 0;
+    int32 Code = 0;
+    int32 Model = 0;
+    int32 State = 0;
+    int32 KindDesc = 0;
+    int32 DomainDesc = 0;
+    int32 CountryDes = 0;
+    int32 CategoryDe = 0;
+    int32 SubCategDe = 0;
+    int32 SpecificDe = 0;
+    int32 EntityEnum = 0;
+};
+
+// Point features of one shapefile; FileName is shared by every feature
+struct FPointFeatureDataset
+{
+    FString FileName;
+    FFeatureStringTable Strings;
+    TArray<FPointFeature> Features;
+
+    int32 Num() const { return Features.Num(); }
+
+    const FString& GetModel(const FPointFeature& Feature) const { return Strings.Get(Feature.Model); }
+
+    // Blueprint-facing copy of one feature with its strings expanded
+    FVegetationPointData Expand(int32 Index) const;
+
+    // Logs bytes per feature of this layout against the same features held as FVegetationPointData
+    void LogMemoryUsage() const;
+};
+
+// Requests and timing of one shapefile's height sampling, logged when the last point returns or sampling stops early
+struct FPointSamplingReport
+{
+    double StartSeconds = 0.0;
+    int32 Points = 0;
+    int32 Requests = 0;
+    int32 CompletedPoints = 0;
+    // Returned without a height (failed sample or a chunk whose result count did not match)
+    int32 FailedPoints = 0;
+};
+
+// Instances of one spatial tile of a point content, one component per model
+USTRUCT()
+struct FPointInstanceTile
+{
+    GENERATED_BODY()
+
+    UPROPERTY() TMap<FString, UInstancedStaticMeshComponent*> Components;
+
+    bool bLoaded = true;
+};
+
+// Change detection of the point instance cache; cached instances are reused only when every field matches
+struct FPointCacheKey
+{
+    FString ShapefileID;
+    // Newest timestamp and summed size of the .shp and .dbf
+    int64 LastModified = 0;
+    int64 FileSize = 0;
+    // Height source settings, model registry hash and georeference origin the cached instances were resolved with
+    FString SourceKey;
+
+    static FPointCacheKey Make(const FString& ShapefilePath, UWorld* World);
+};
+
 UCLASS()
 class CUSTOMPCG_API APCGPointContent : public APCGContent
 {
@@ -56,20 +146,94 @@ public:
     APCGPointContent();
 
     // Not exposed -> no Category required
-    TArray<FVegetationPointData> PointDataList;
+    FPointFeatureDataset PointData;
 
     // Override the InitializeContent function
     virtual void InitializeContent() override;
 
     void InitializePCGPointData(const FShapeRawData& Raw);
+
+    // Takes features parsed off the game thread by ParsePointData
+    void InitializePCGPointData(FPointFeatureDataset&& Points);
+
+    // Attribute parsing and string interning only, safe on any thread
+    static void ParsePointData(const FShapeRawData& Raw, FPointFeatureDataset& OutPoints);
+
+    // Fills StringCustomData when PointInstanceCustomData is set
+    void HashCustomDataStrings();
+
+    // Loads the registry classes PointData uses asynchronously, then spawns
     void SpawnPCGPointData();
-    void SpawnPointDataOnTerrainUsingCesiumSampler(const FVegetationPointData& Data);
-    void SpawnPointDataOnTerrainUsingElevData(const FVegetationPointData& Data);
-    void SpawnPointDataOnTerrainUsingCesiumSampler_HISM(const FVegetationPointData& Data);
 
-    void SpawnPointDataOnTerrainUsingElevData_HISM(const FVegetationPointData& Data);
+    void SpawnLoadedPCGPointData();
+
+    void SpawnParentActor(const FString& BaseName);
 
-    UStaticMesh* ExtractMeshFromBlueprint(TSubclassOf<AActor> BPClass);
+    // PointShapefileMetadata + PointInstances (+ PointInstanceCustomData): final world transforms, mesh paths and custom data per point shapefile
+    static void CreatePointCacheTables(UPcgSQLiteSubsystem* SQLite);
+    static bool IsPointCacheValid(UPcgSQLiteSubsystem* SQLite, const FPointCacheKey& Key);
+
+    // Reads the cached instances on the thread pool and adds them per mesh; no shapefile read or height sampling
+    void SpawnPCGPointDataFromCache(const FPointCacheKey& Key);
+
+    // Replaces the cached instances of CacheKey with everything in InstanceTiles
+    void WritePointCache();
+
+    // Tile of a world location; always (0, 0) when PointTileSize is 0
+    static FIntPoint TileOf(const FVector& WorldLocation, float TileSize);
+
+    // Hands every tile to the world's AGridStreamingManager, if there is one and PointTileSize is set
+    void RegisterTilesForStreaming();
+
+    // Registers or unregisters the components of a tile; instance data stays in memory either way
+    void SetTileLoaded(FIntPoint Tile, bool bLoaded);
+    // Elev attribute path for the whole PointData: parallel georeference and transform build, one AddInstances per model
+    void SpawnPointDataOnTerrainUsingElevData_Staged();
+
+    // Groups the points by model, builds their transforms in parallel and adds each model's instances in one call.
+    // WorldLocations[i] is the location of PointData.Features[PointIndices[i]]
+    void AddPointInstances(TConstArrayView<int32> PointIndices, TConstArrayView<FVector> WorldLocations);
+
+    // Samples PointData from the PointHeightProvider in chunks of HeightSampleChunkSize, at most MaxHeightSampleRequestsInFlight at a time
+    void SpawnPointDataOnTerrainUsingHeightProvider_Batched();
+
+    void IssuePendingSampleChunks();
+
+    // Adds the instances of one sampled chunk, one AddInstances call per model
+    void ScatterSampledChunk(int32 FirstIndex, const TArray<FCesiumSampleHeightResult>& Results);
+
+    void OnPointSamplesCompleted(int32 NumPoints);
+
+    // Resets SamplingReport for PointData at the start of a sampled spawn
+    void BeginPointSamplingReport();
+
+    // Logs SamplingReport; Outcome is "complete" or why sampling stopped before every point returned
+    void LogPointSamplingReport(const TCHAR* Outcome) const;
+
+    UInstancedStaticMeshComponent* FindOrCreateInstancedMesh(const FString& CleanedName, FIntPoint Tile);
+
+    UInstancedStaticMeshComponent* CreateInstancedMesh(const FString& Key, FIntPoint Tile, UStaticMesh* Mesh);
+
+    // The registry set in UCustomPCGSettings::PointModelRegistry; logs and returns null when it does not load
+    static UBlueprintRegistery* LoadBlueprintRegistry();
+
+    // Changes whenever a registry entry is added, removed, reordered or repointed
+    static uint32 HashModelRegistry(const UBlueprintRegistery* Registry);
+
+    // Lower case, spaces removed; the key of ModelIndex, StaticMeshesPerType and the tile components
+    static FString NormalizeModelName(const FString& Model);
+
+    // Maps every "PD_<model>" registry entry by normalized model name
+    void BuildModelIndex();
+
+    // Hash lookups; a model that is not in the registry (or has no mesh) is logged once and remembered as missing
+    TSubclassOf<AActor> FindModelClass(const FString& CleanedName);
+    UStaticMesh* FindModelMesh(const FString& CleanedName);
+
+    // First static mesh of the class, read from its default object and construction script templates; cached per class
+    static UStaticMesh* ExtractMeshFromBlueprint(TSubclassOf<AActor> BPClass);
+
+    static void ResetExtractedMeshCache();
 
     // If you want to see these in Details, add VisibleAnywhere + Category.
     // Otherwise, keep them as plain members or minimally as UPROPERTY without exposure.
@@ -80,11 +244,31 @@ public:
 
     UPROPERTY() AActor* ParentActor = nullptr;
 
+    TMap<FString, TSoftClassPtr<AActor>> ModelIndex;
+
+    UPROPERTY() TMap<FString, TSubclassOf<AActor>> ModelClasses;
+
+    TSet<FString> MissingModels;
+
+    TSharedPtr<FStreamableHandle> ModelLoadHandle;
+
     // Caches extracted static meshes for each object type
     UPROPERTY() TMap<FString, UStaticMesh*> StaticMeshesPerType;
 
-    // Maps type name to its corresponding HISM component
-    UPROPERTY() TMap<FString, UHierarchicalInstancedStaticMeshComponent*> InstancedMeshMap;
+    // Spatial tiles, each mapping type name to its instanced component (HISM or ISM, see UInstanceBuilderSubsystem)
+    UPROPERTY() TMap<FIntPoint, FPointInstanceTile> InstanceTiles;
+
+    TSharedPtr<IPCGHeightProvider> HeightProvider;
+
+    // Custom data value of every PointData string, indexed like PointData.Strings
+    TArray<float> StringCustomData;
+
+    // Set by APCGManager before spawning; instances are cached under it once placed (no ShapefileID: not cached)
+    FPointCacheKey CacheKey;
+
+    int32 NextSampleIndex = 0;
+    int32 SampleRequestsInFlight = 0;
+    FPointSamplingReport SamplingReport;
 
     static int32     TotalPointDataPoints;
     static FDateTime StartTime;
@@ -4,6 +4,7 @@
 #include "Components/SplineComponent.h"
 #include "Components/BoxComponent.h"
 #include "PCGComponent.h"
+#include "GISShapeTypes.h"
 #include "PCGPolygonActor.generated.h"
 
 
@@ -36,6 +37,7 @@ struct FGrassPolygonData
     UPROPERTY(BlueprintReadWrite, Category = "CustomPCG|PolygonData") FString Foliage;
     UPROPERTY(BlueprintReadWrite, Category = "CustomPCG|PolygonData") FString State;
     UPROPERTY(BlueprintReadWrite, Category = "CustomPCG|PolygonData") TArray<FVector> PolygonPoints;
+    UPROPERTY(BlueprintReadWrite, Category = "CustomPCG|PolygonData") TArray<FPolygonRing> HoleRings;
     UPROPERTY(BlueprintReadWrite, Category = "CustomPCG|PolygonData") FString FileName;
     UPROPERTY(BlueprintReadWrite, Category = "CustomPCG|PolygonData") FVector BoxExtents;
 
@@ -73,8 +75,14 @@ public:
     // UFUNCTION(BlueprintCallable, Category="CustomPCG")
     void DeActivatePCG();
 
+    // Returns the actor to a blank state so UPCGActorPoolSubsystem can hand it out again
+    void ResetForPool();
+
     FString FileName;
     int32 ID;
     FGrassPolygonData Data;
 
+    // Interior rings in actor space, excluded by the interior sampler node
+    TArray<FPolygonRing> HoleRings;
+
 };
@@ -5,7 +5,10 @@
 #include "PCGComponent.h"
 #include "PCGPolygonActor.h"
 #include "PolygonHiGenActor.h"
+#include "PolygonGenerationProfile.h"
+#include "PolygonPreprocessor.h"
 #include "PcgSQLiteSubsystem.h"
+#include "HeightProvider.h"
 #include "PCGPolygonContent.generated.h"
 
 
@@ -23,6 +26,60 @@ struct FBakedInstanceBatch
 };
 
 
+// Height-sampled polygon waiting for worker-thread preprocessing
+struct FSampledPolygon
+{
+    FGrassPolygonData Data;
+    TArray<FVector> WorldPoints;
+    TArray<FPolygonRing> WorldHoles;
+};
+
+
+// Vertex counts and timings of the simplification + height sampling stage of one shapefile
+struct FPolygonSamplingReport
+{
+    int32 VerticesBefore = 0;
+    int32 VerticesAfter = 0;
+    double SimplifySeconds = 0.0;
+    double SamplingStartSeconds = 0.0;
+    int32 PendingSampleRequests = 0;
+    int32 SampledVertices = 0;
+    int32 UniqueVertices = 0;
+    // Polygons not spawned because a vertex was in a mismatched chunk or a whole ring failed to sample
+    int32 DroppedPolygons = 0;
+    // Failed vertex samples whose height was interpolated from sampled ring neighbours
+    int32 FilledVertices = 0;
+};
+
+// Unique ring vertices of one shapefile's polygons, each height sampled once and shared by every ring that uses it
+struct FSharedVertexSampling
+{
+    TArray<FVector> UniqueLonLat;
+    TArray<FVector> UniqueUnreal;
+    // Sampled heights, used to fill failed vertices from their ring neighbours
+    TArray<double> UniqueHeight;
+    // False for failed samples and for every vertex of a chunk whose result count did not match
+    TArray<bool> UniqueSampled;
+    // True for every vertex of a chunk whose result count did not match; there is no result to trust for any of them
+    TArray<bool> UniqueLost;
+
+    // Unique index of every ring vertex, polygons (outer ring, then holes) in PolygonDataList order
+    TArray<int32> VertexToUnique;
+    // Start of each polygon in VertexToUnique, plus a final end entry
+    TArray<int32> PolygonVertexStart;
+    // Highest unique index used by this polygon or any before it; unique indices are handed out in first-use order
+    TArray<int32> PolygonMaxUnique;
+
+    TArray<bool> ChunkDone;
+    int32 ChunkSize = 1;
+    int32 NextChunk = 0;
+    int32 ChunksInFlight = 0;
+    // Unique vertices [0, SampledPrefix) have all returned
+    int32 SampledPrefix = 0;
+    int32 NextPolygon = 0;
+};
+
+
 UCLASS()
 class CUSTOMPCG_API APCGPolygonContent : public APCGContent
 {
@@ -39,6 +96,8 @@ public:
 
     virtual void BeginPlay() override;
 
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
     // Called when the game starts or when spawned
     virtual void InitializeContent() override;
 
@@ -46,6 +105,12 @@ public:
 
     void InitializePCGPolygonData(const FShapeRawData& Raw);
 
+    // Takes features parsed off the game thread by ParsePolygonData
+    void InitializePCGPolygonData(TArray<FGrassPolygonData>&& Polygons);
+
+    // Attribute parsing and ring classification only, safe on any thread
+    static void ParsePolygonData(const FShapeRawData& Raw, TArray<FGrassPolygonData>& OutPolygons);
+
     bool InsertPolygonsFeaturesToDB(const FString& ShapefileID);
 
     bool InsertPolygonFeaturesToDB(const FGrassPolygonData& Data);
@@ -54,24 +119,73 @@ public:
 
     void SpawnPCGPolygonData();
 
-    void SpawnIndividualPCGPolygonData(const FGrassPolygonData& Data);
+    // Dedupes the ring vertices of PolygonDataList by quantized longitude/latitude into VertexSampling
+    void BuildSharedVertexSampling();
+
+    // Samples unique vertices in HeightSampleChunkSize chunks, at most MaxHeightSampleRequestsInFlight at a time
+    void IssueSharedVertexChunks();
+
+    void OnSharedVertexChunkSampled(int32 ChunkIndex, const TArray<FCesiumSampleHeightResult>& Results);
+
+    // Queues every polygon whose unique vertices have all been sampled, in PolygonDataList order
+    void QueueSampledPolygons();
+
+    // Simplifies every polygon before height sampling, tolerance derived from InteriorSampleSpacing; vertices shared between polygons are kept
+    void SimplifyPolygonData();
+
+    void ReportPolygonSampling() const;
+
+    // Moves the sampled polygons collected so far to a worker batch (ParallelFor over polygons)
+    void DispatchPolygonPreprocessing();
+
+    // Game-thread half of the pipeline: only actor, spline and PCG component setup
+    void SpawnPreparedPolygon(const FGrassPolygonData& Data, const FPreparedPolygon& Prepared);
 
     void AssignPCGGraph(UPCGComponent* TargetPCG, const FString& GraphName);
 
     void SpawnHiGenActorsFromDatabase(const FString& ShapefileName);
 
+    // Hands every polygon and HiGen actor spawned by this content back to UPCGActorPoolSubsystem
+    void ReleaseSpawnedActors();
+
     // If you want these visible in the editor, wrap with UPROPERTY + Category.
     UPROPERTY() ACesiumGeoreference* CesiumGeoreference = nullptr;
     UPROPERTY() ACesium3DTileset* Tileset = nullptr;
 
+    // PolygonHeightProvider from the project settings, created in InitializeContent
+    TSharedPtr<IPCGHeightProvider> HeightProvider;
+
+    // Per-model HiGen generation radii; automatic defaults are used when the asset is missing
+    UPROPERTY() UPolygonGenerationProfile* GenerationProfile = nullptr;
+
     TArray<FGrassPolygonData> PolygonDataList;
 
     UPROPERTY() AActor* ParentActor = nullptr;
 
+    UPROPERTY() TArray<APCGPolygonActor*> SpawnedPolygonActors;
+
+    UPROPERTY() TArray<APolygonHiGenActor*> SpawnedHiGenActors;
+
     FTimerHandle handle;
 
+    TArray<FSampledPolygon> SampledPolygonQueue;
+
+    bool bPreprocessingInFlight = false;
+
+    FPolygonSamplingReport SamplingReport;
+
+    FSharedVertexSampling VertexSampling;
+
     bool InsertPolygonPointsToDB(const FString& ShapefileID, FGrassPolygonData PolygonID, const TArray<FTransform>& Instances, const FString& MeshID);
 
+    // Hole rings are stored in world space so HiGen actors can reject points without the polygon actor
+    bool InsertPolygonHolesToDB(const FString& ShapefileID, int32 PolygonID, const TArray<FPolygonRing>& WorldHoles);
+
+    // Shared by APCGManager's table setup and stale-file cleanup and by the HiGen replay
+    static const FString& GetCreatePolygonHolesTableSQL();
+    static void DeletePolygonHoles(UPcgSQLiteSubsystem* SQLite, const FString& ShapefileID);
+    static void LoadPolygonHoles(UPcgSQLiteSubsystem* SQLite, const FString& ShapefileID, TMap<int32, TArray<FPolygonRing>>& OutHoles);
+
     UFUNCTION()
     void OnPcgGraphGenerated(UPCGComponent* PCG);
 
@@ -0,0 +1,63 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PCGSettings.h"
+#include "PCGElement.h"
+#include "PCGContext.h"
+#include "PCGPolygonInteriorSamplerSettings.generated.h"
+
+class APCGPolygonActor;
+class UPCGPointData;
+
+/**
+ * Generates interior points for the owning APCGPolygonActor by triangulating its ring (minus HoleRings)
+ * instead of sampling the spline's interior.
+ */
+UCLASS(BlueprintType)
+class CUSTOMPCG_API UPCGPolygonInteriorSamplerSettings : public UPCGSettings
+{
+	GENERATED_BODY()
+
+public:
+#if WITH_EDITOR
+	virtual FName GetDefaultNodeName() const override { return FName(TEXT("PCGPolygonInteriorSampler")); }
+	virtual FText GetDefaultNodeTitle() const override { return FText::FromString("Polygon Interior Sampler"); }
+	virtual FText GetNodeTooltipText() const override { return FText::FromString("Samples the interior of the owning polygon actor from a triangulation of its ring and holes"); }
+	virtual EPCGSettingsType GetType() const override { return EPCGSettingsType::Sampler; }
+#endif
+
+protected:
+	virtual TArray<FPCGPinProperties> InputPinProperties() const override;
+	virtual TArray<FPCGPinProperties> OutputPinProperties() const override;
+	virtual FPCGElementPtr CreateElement() const override;
+
+public:
+	/** Distance between points; 0 uses the actor's InteriorSampleSpacing **/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Sampling", meta = (PCG_Overridable, ClampMin = "0.0", UIMin = "0.0"))
+	float PointSpacing = 0.0f;
+
+	/** Fraction of the spacing each point may move off the regular grid **/
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Sampling", meta = (PCG_Overridable, ClampMin = "0.0", ClampMax = "1.0", UIMin = "0.0", UIMax = "1.0"))
+	float Jitter = 1.0f;
+
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Sampling", meta = (PCG_Overridable))
+	bool bExcludeHoles = true;
+};
+
+class FPCGPolygonInteriorSamplerElement : public IPCGElement
+{
+public:
+	// Reads the actor's spline and hole rings, which are only safe to touch from the game thread
+	virtual bool CanExecuteOnlyOnMainThread(FPCGContext* Context) const override { return true; }
+
+	// Reads the actor, so results must not be reused across actors
+	virtual bool IsCacheable(const UPCGSettings* InSettings) const override { return false; }
+
+	// Shared with the benchmark command so both measure the same work
+	static UPCGPointData* SamplePolygonActor(const APCGPolygonActor* Actor, float Spacing, float Jitter, bool bExcludeHoles, int32 Seed, UObject* Outer);
+
+protected:
+	virtual bool ExecuteInternal(FPCGContext* Context) const override;
+};
@@ -23,6 +23,9 @@ public:
 
     bool IsOpen() const;
 
+    // Absolute path of the open database, for workers that read through their own connection
+    const FString& GetDatabasePath() const { return DbPathFull; }
+
     bool Execute(const FString& Sql);
 
     bool ExecuteWithCallback(const FString& Sql, TFunctionRef<ESQLitePreparedStatementExecuteRowResult(const FSQLitePreparedStatement&)> RowCallback);
@@ -36,8 +39,13 @@ public:
     bool CommitTransaction();
     bool RollbackTransaction();
 
+    // Callers preparing statements on it directly hold GetLock() while they use it
     FSQLiteDatabase& GetDatabase();
 
+    // Recursive; hold it across transactions and other multi-statement work so it cannot
+    // interleave with queries other threads run on the same connection
+    FCriticalSection& GetLock() const { return DbCriticalSection; }
+
 private:
     FString DbPathFull;
 
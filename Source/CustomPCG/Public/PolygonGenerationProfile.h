@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "PCGCommon.h"
+#include "PolygonGenerationProfile.generated.h"
+
+/**
+ * Runtime generation settings for the HiGen actors of one polygon model.
+ */
+USTRUCT(BlueprintType)
+struct FPolygonGenerationSettings
+{
+    GENERATED_BODY();
+
+    // Applied to every HiGen grid level; the graph's own grid settings decide which levels generate
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HiGen", meta = (ClampMin = "0.0", UIMin = "0.0"))
+    float GenerationRadius = 512.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HiGen", meta = (ClampMin = "1.0", UIMin = "1.0"))
+    float CleanupRadiusMultiplier = 1.1f;
+
+    FPCGRuntimeGenerationRadii ToGenerationRadii() const;
+};
+
+/**
+ * Per-model generation radii for APolygonHiGenActor.
+ * Models without an entry get an automatic default derived from Density and BoxExtents,
+ * sized so roughly MaxInstancesAroundCamera instances are generated around the camera.
+ */
+UCLASS(BlueprintType)
+class CUSTOMPCG_API UPolygonGenerationProfile : public UDataAsset
+{
+    GENERATED_BODY()
+
+public:
+    // Keyed by the normalized model name (spaces removed, lower case), same as the graph name
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HiGen")
+    TMap<FString, FPolygonGenerationSettings> ModelSettings;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HiGen|Automatic", meta = (ClampMin = "1", UIMin = "1"))
+    int32 MaxInstancesAroundCamera = 20000;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HiGen|Automatic", meta = (ClampMin = "0.0", UIMin = "0.0"))
+    float MinGenerationRadius = 2000.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HiGen|Automatic", meta = (ClampMin = "0.0", UIMin = "0.0"))
+    float MaxGenerationRadius = 204800.0f;
+
+    UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "HiGen|Automatic", meta = (ClampMin = "1.0", UIMin = "1.0"))
+    float DefaultCleanupRadiusMultiplier = 1.1f;
+
+    FPolygonGenerationSettings ResolveSettings(const FString& ModelName, float Density, const FVector& BoxExtents) const;
+
+    FPolygonGenerationSettings ComputeAutomaticSettings(float Density, const FVector& BoxExtents) const;
+};
@@ -5,6 +5,8 @@
 #include "PCGComponent.h"
 #include "Components/BoxComponent.h"
 #include "PCGSubsystem.h"
+#include "PolygonGenerationProfile.h"
+#include "GISShapeTypes.h"
 #include "PolygonHiGenActor.generated.h"
 
 UCLASS(Blueprintable)
@@ -31,12 +33,23 @@ public:
     UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "HiGen")
     int32 PolygonID;
 
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "HiGen")
+    float Density = 0.0f;
+
+    // World-space hole rings of the source polygon, loaded from the PolygonHoles table
+    TArray<FPolygonRing> HoleRings;
+
 
     UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "HiGen")
     FString GraphName;
 
     void AssignHiGenGraph();
 
+    void ApplyGenerationSettings(const FPolygonGenerationSettings& Settings);
+
+    // Returns the actor to a blank state so UPCGActorPoolSubsystem can hand it out again
+    void ResetForPool();
+
 };
 
 
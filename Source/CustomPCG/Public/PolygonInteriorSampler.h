@@ -0,0 +1,31 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GISShapeTypes.h"
+
+/**
+ * Triangulated polygon ring (XY plane) with per-vertex heights, ready for interior sampling.
+ */
+struct FTriangulatedPolygon
+{
+    TArray<FVector> Vertices;
+    TArray<FIntVector> Triangles;
+    double Area = 0.0;
+};
+
+/**
+ * Area-weighted interior point generation for polygon actors.
+ * Candidates come from a jittered grid of the requested spacing; each triangle keeps the
+ * candidates inside it, tested four at a time with SIMD edge functions.
+ */
+struct CUSTOMPCG_API FPolygonInteriorSampler
+{
+    // Constrained Delaunay triangulation of the outer ring with holes removed. Rings are in the same space, Z is kept
+    static bool Triangulate(TConstArrayView<FVector> OuterRing, TConstArrayView<FPolygonRing> Holes, FTriangulatedPolygon& OutPolygon);
+
+    // Deterministic for a given Seed and Spacing: a grid cell always produces the same candidate,
+    // whatever triangle or worker thread it ends up in. Jitter is a fraction of Spacing in [0, 1].
+    static void SamplePoints(const FTriangulatedPolygon& Polygon, double Spacing, float Jitter, int32 Seed, TArray<FVector>& OutPoints);
+};
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "CustomPCGSettings.h"
+#include "GISShapeTypes.h"
+
+/**
+ * Height-sampled polygon turned into what APCGPolygonActor needs: deduplicated spline points
+ * relative to the actor origin plus the half-size of the polygon bounds.
+ */
+struct FPreparedPolygon
+{
+    bool bValid = false;
+
+    // World position of the first unique vertex, used as the actor location
+    FVector Origin = FVector::ZeroVector;
+
+    // Spline points relative to Origin
+    TArray<FVector> LocalPoints;
+
+    FVector BoxExtents = FVector::ZeroVector;
+
+    // Hole rings relative to Origin; holes with fewer than 3 unique vertices are dropped
+    TArray<FPolygonRing> LocalHoles;
+};
+
+/**
+ * Thread-safe polygon preprocessing used by APCGPolygonContent on worker threads.
+ */
+struct CUSTOMPCG_API FPolygonPreprocessor
+{
+    // Matches the former DistSquared < KINDA_SMALL_NUMBER duplicate test
+    static constexpr double DefaultDedupeEpsilon = 0.01;
+
+    // Drops every vertex closer than Epsilon to an earlier kept vertex, using a hashed grid instead of a pairwise scan
+    static void DedupeVertices(TConstArrayView<FVector> InPoints, double Epsilon, TArray<FVector>& OutPoints);
+
+    // Dedupes, computes bounds and builds local spline points. Returns false for fewer than 3 unique vertices
+    static bool PreparePolygon(TConstArrayView<FVector> WorldPoints, TConstArrayView<FPolygonRing> WorldHoles, FPreparedPolygon& OutPolygon);
+
+    // Splits a shapefile polygon's flattened parts back into rings; a ring ends at the vertex repeating its first one
+    static void SplitRings(TConstArrayView<FVector> Points, TArray<TArray<FVector>>& OutRings);
+
+    // The ring with the largest area becomes the outer ring, rings starting inside it become holes.
+    // Returns how many rings were neither (disjoint parts of a multipart polygon)
+    static int32 ClassifyRings(TArray<TArray<FVector>>& Rings, TArray<FVector>& OutOuterRing, TArray<FPolygonRing>& OutHoles);
+
+    // Simplifies a polygon's closed longitude/latitude rings (degrees) with a tolerance in meters. Vertices IsLocked
+    // accepts are always kept, so boundaries shared with other polygons stay identical. Falls back to smaller tolerances,
+    // then to the input rings, if a ring would self-intersect, two rings would cross or a hole would leave the outer ring.
+    static void SimplifyPolygon(TConstArrayView<FVector> LonLatOuter, TConstArrayView<FPolygonRing> LonLatHoles, double ToleranceMeters,
+        EPolygonSimplificationMethod Method, TFunctionRef<bool(const FVector&)> IsLocked, TArray<FVector>& OutOuter, TArray<FPolygonRing>& OutHoles);
+
+    // True when no two non-adjacent edges of the closed ring intersect
+    static bool IsRingSimple(TConstArrayView<FVector2D> Ring);
+};
@@ -0,0 +1,40 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GISShapeTypes.h"
+
+/**
+ * Even-odd point-in-polygon test over any number of rings (XY only).
+ * Edges are bucketed into horizontal bands so a query only walks the edges crossing its band.
+ */
+struct CUSTOMPCG_API FPolygonScanlineTable
+{
+    // Rings are transformed by RingTransform before bucketing; pass identity when they are already in query space
+    void Build(TConstArrayView<FPolygonRing> Rings, const FTransform& RingTransform = FTransform::Identity);
+
+    bool IsEmpty() const { return Edges.Num() == 0; }
+
+    bool Contains(const FVector& Point) const { return Contains(Point.X, Point.Y); }
+
+    bool Contains(double X, double Y) const;
+
+private:
+    struct FEdge
+    {
+        double MinY;
+        double MaxY;
+        double XAtMinY;
+        double DxDy;
+    };
+
+    TArray<FEdge> Edges;
+
+    // Band B owns BandEdges[BandStarts[B] .. BandStarts[B + 1])
+    TArray<int32> BandStarts;
+    TArray<int32> BandEdges;
+
+    FBox2D Bounds = FBox2D(ForceInit);
+    double InvBandHeight = 0.0;
+};
@@ -0,0 +1,68 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HeightProvider.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/**
+ * Heights from a memory-mapped DEM: an uncompressed little-endian GeoTIFF in geographic
+ * coordinates, or a raw heightmap described by UCustomPCGSettings. Sampling is bilinear,
+ * four positions at a time, and runs on the thread pool; results come back on the game thread.
+ */
+class CUSTOMPCG_API FRasterHeightProvider : public IPCGHeightProvider, public TSharedFromThis<FRasterHeightProvider>
+{
+public:
+    virtual ~FRasterHeightProvider() override;
+
+    // Maps the file once and shares it between callers until the last reference goes away
+    static TSharedPtr<FRasterHeightProvider> Get(const FString& FilePath);
+
+    virtual void SampleHeights(const TArray<FVector>& LonLatPositions, FHeightSampleCallback OnComplete) override;
+    virtual FString GetDescription() const override;
+
+    // Synchronous sampling, safe from any thread
+    void SampleHeightsImmediate(TConstArrayView<FVector> LonLatPositions, TArrayView<FCesiumSampleHeightResult> OutResults) const;
+
+    int32 GetWidth() const { return Width; }
+    int32 GetHeight() const { return Height; }
+
+    // Longitude/latitude covered by the raster, in degrees
+    FBox2D GetLonLatBounds() const
+    {
+        return FBox2D(FVector2D(OriginLon, OriginLat - Height * PixelSizeLat), FVector2D(OriginLon + Width * PixelSizeLon, OriginLat));
+    }
+
+private:
+    FRasterHeightProvider() = default;
+
+    bool Open(const FString& InFilePath);
+    bool ParseGeoTiff(const uint8* Data, int64 Size);
+    bool ParseRaw(int64 Size);
+
+    // Raw sample at a clamped pixel, converted to float
+    float ReadSample(int32 X, int32 Y) const;
+
+    FString FilePath;
+
+    TUniquePtr<IMappedFileHandle> MappedFile;
+    TUniquePtr<IMappedFileRegion> MappedRegion;
+
+    const uint8* Samples = nullptr;
+    ERasterSampleFormat Format = ERasterSampleFormat::Float32;
+
+    int32 Width = 0;
+    int32 Height = 0;
+
+    // Longitude/latitude of the top-left corner of pixel (0, 0) and the pixel size in degrees
+    double OriginLon = 0.0;
+    double OriginLat = 0.0;
+    double PixelSizeLon = 1.0;
+    double PixelSizeLat = 1.0;
+
+    double NoDataValue = -32768.0;
+    double HeightOffset = 0.0;
+};
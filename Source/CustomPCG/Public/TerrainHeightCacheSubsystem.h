@@ -0,0 +1,81 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/GameInstanceSubsystem.h"
+#include "CesiumSampleHeightResult.h"
+#include "TerrainHeightCacheSubsystem.generated.h"
+
+class ACesium3DTileset;
+
+// Called with one result per requested position, in request order
+using FCachedHeightSampleCallback = TFunction<void(const TArray<FCesiumSampleHeightResult>& Results, const TArray<FString>& Warnings)>;
+
+/**
+ * Persistent terrain heights keyed by quantized longitude/latitude cell and tileset, stored in the
+ * HeightCache table of the PCG database. Only cache misses are sent to Cesium; their results are
+ * written back in batches.
+ */
+UCLASS()
+class CUSTOMPCG_API UTerrainHeightCacheSubsystem : public UGameInstanceSubsystem
+{
+    GENERATED_BODY()
+
+public:
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    virtual void Deinitialize() override;
+
+    // Uses the world's cache when there is one (game worlds), otherwise samples Cesium directly (editor PCG)
+    static void SampleHeights(UWorld* World, ACesium3DTileset* Tileset, const TArray<FVector>& LonLatPositions, FCachedHeightSampleCallback OnComplete);
+
+    void SampleHeights(ACesium3DTileset* Tileset, const TArray<FVector>& LonLatPositions, FCachedHeightSampleCallback OnComplete);
+
+    // Writes pending entries to SQLite in one transaction
+    void Flush();
+
+    static FString MakeTilesetKey(const ACesium3DTileset* Tileset);
+
+    int64 GetNumHits() const { return NumHits; }
+    int64 GetNumMisses() const { return NumMisses; }
+
+private:
+    struct FHeightCell
+    {
+        int64 X = 0;
+        int64 Y = 0;
+
+        bool operator==(const FHeightCell& Other) const { return X == Other.X && Y == Other.Y; }
+
+        friend uint32 GetTypeHash(const FHeightCell& Cell)
+        {
+            return HashCombineFast(GetTypeHash(Cell.X), GetTypeHash(Cell.Y));
+        }
+    };
+
+    struct FPendingHeight
+    {
+        FString TilesetKey;
+        FHeightCell Cell;
+        double Height = 0.0;
+    };
+
+    FHeightCell CellOf(const FVector& LonLat) const;
+
+    // Loads every cached height of a tileset on first use
+    TMap<FHeightCell, double>& GetTilesetHeights(const FString& TilesetKey);
+
+    void StoreHeight(const FString& TilesetKey, const FHeightCell& Cell, double Height);
+
+    TMap<FString, TMap<FHeightCell, double>> HeightsPerTileset;
+
+    TArray<FPendingHeight> PendingWrites;
+
+    double InvCellDegrees = 1.0;
+
+    // Appended to the tileset key of every HeightCache row, so rows of another HeightCacheCellDegrees are never loaded
+    FString CellKeySuffix;
+
+    int64 NumHits = 0;
+    int64 NumMisses = 0;
+};